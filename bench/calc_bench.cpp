@@ -0,0 +1,704 @@
+// Micro and macro benchmarks for calc_engine.
+//
+//   calc_bench [--json] [--filter TEXT] [--min-time SECONDS] [--large]
+//
+// Every benchmark is repeated until it has run for --min-time, five times
+// over, and the median is reported. --json prints one machine-readable
+// document for tracking regressions between releases; --large adds the
+// 100M-expression batch run, which takes minutes.
+#include "engine/Batch.hpp"
+#include "engine/Columnar.hpp"
+#include "engine/Eval.hpp"
+#include "engine/Expression.hpp"
+#include "engine/Format.hpp"
+#include "engine/Jit.hpp"
+#include "engine/Plot.hpp"
+#include "engine/Session.hpp"
+#include "engine/Statistics.hpp"
+#include "engine/ThreadPool.hpp"
+#include "engine/Units.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <new>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Body of a benchmark: performs `iterations` operations and returns how
+// many items (expressions, digits, ...) they processed
+using Body = std::function<std::uint64_t(std::uint64_t iterations)>;
+
+struct Benchmark {
+  std::string name;
+  Body body;
+  // Iterations are fixed for benchmarks that are expensive per operation
+  std::uint64_t fixedIterations = 0;
+};
+
+struct Result {
+  std::string name;
+  std::uint64_t iterations = 0;
+  double nsPerOp = 0.0;
+  double itemsPerSecond = 0.0;
+  double allocationsPerOp = 0.0;
+};
+
+struct Options {
+  bool json = false;
+  bool large = false;
+  std::string filter;
+  double minTime = 0.2;
+  int repetitions = 5;
+};
+
+// Results are folded into this so the optimizer cannot drop the work
+volatile std::uint64_t sink = 0;
+
+// Heap allocations made by the whole process, counted by the operator new
+// replacements below so every benchmark reports allocations per operation
+std::atomic<std::uint64_t> allocations{0};
+
+void keep(double value) { sink = sink + static_cast<std::uint64_t>(value); }
+void keep(std::size_t value) { sink = sink + value; }
+
+#ifdef _WIN32
+constexpr const char *kNullDevice = "NUL";
+#else
+constexpr const char *kNullDevice = "/dev/null";
+#endif
+
+// Keypad-style expressions like "267 + 45 × 0.1344 ÷ 4", one per line
+std::string makeExpressions(std::size_t count, std::uint32_t seed = 1) {
+  std::mt19937 random(seed);
+  std::uniform_int_distribution<int> large(1, 999);
+  std::uniform_int_distribution<int> small(1, 99);
+  std::uniform_int_distribution<int> fraction(1000, 9999);
+  std::uniform_int_distribution<int> digit(1, 9);
+  std::string text;
+  text.reserve(count * 24);
+  for (std::size_t i = 0; i < count; ++i) {
+    text += std::to_string(large(random));
+    text += " + ";
+    text += std::to_string(small(random));
+    text += " × 0.";
+    text += std::to_string(fraction(random));
+    text += " ÷ ";
+    text += std::to_string(digit(random));
+    text += '\n';
+  }
+  return text;
+}
+
+std::vector<double> makeNumbers(std::size_t count) {
+  std::mt19937 random(7);
+  std::uniform_real_distribution<double> real(-1e6, 1e6);
+  std::uniform_int_distribution<int> integer(-100000, 100000);
+  std::vector<double> numbers(count);
+  for (std::size_t i = 0; i < count; ++i) {
+    // Half integral (plain path), half fractional (general notation)
+    numbers[i] = i % 2 ? real(random) : integer(random);
+  }
+  return numbers;
+}
+
+Result measure(const Benchmark &benchmark, const Options &options) {
+  const auto run = [&benchmark](std::uint64_t iterations,
+                                std::uint64_t &items) {
+    const auto start = Clock::now();
+    items = benchmark.body(iterations);
+    return std::chrono::duration<double>(Clock::now() - start).count();
+  };
+
+  std::uint64_t items = 0;
+  std::uint64_t iterations = benchmark.fixedIterations;
+  if (iterations == 0) {
+    // Grow the iteration count until one run lasts at least --min-time
+    iterations = 1;
+    for (;;) {
+      const double seconds = run(iterations, items);
+      if (seconds >= options.minTime || iterations >= (1ULL << 40)) {
+        break;
+      }
+      const double scale =
+          seconds > 0 ? options.minTime * 1.2 / seconds : 100.0;
+      iterations = static_cast<std::uint64_t>(
+          static_cast<double>(iterations) * std::clamp(scale, 2.0, 100.0));
+    }
+  }
+
+  std::vector<double> samples;
+  const std::uint64_t allocationsBefore = allocations.load();
+  for (int i = 0; i < options.repetitions; ++i) {
+    samples.push_back(run(iterations, items));
+  }
+  const std::uint64_t allocated = allocations.load() - allocationsBefore;
+  std::sort(samples.begin(), samples.end());
+  const double median = samples[samples.size() / 2];
+
+  Result result;
+  result.name = benchmark.name;
+  result.iterations = iterations;
+  result.nsPerOp = median * 1e9 / static_cast<double>(iterations);
+  result.itemsPerSecond = static_cast<double>(items) / median;
+  result.allocationsPerOp =
+      static_cast<double>(allocated) /
+      static_cast<double>(iterations * static_cast<std::uint64_t>(
+                                           options.repetitions));
+  return result;
+}
+
+// Evaluates `input` on the calling thread, discarding the output
+std::uint64_t evaluateSerial(std::string_view input) {
+  std::string out;
+  calc::BatchStats stats;
+  std::size_t consumed = 0;
+  // Same chunking as the batch reader so `out` stays small
+  constexpr std::size_t kChunk = 256 * 1024;
+  while (consumed < input.size()) {
+    const std::size_t size = std::min(kChunk, input.size() - consumed);
+    const bool final = consumed + size == input.size();
+    consumed += calc::evaluateLines(input.substr(consumed, size), final, out,
+                                    stats);
+    keep(out.size());
+    out.clear();
+  }
+  return stats.lines;
+}
+
+void addEngineBenchmarks(std::vector<Benchmark> &benchmarks) {
+  benchmarks.push_back({"engine/compile", [](std::uint64_t iterations) {
+                          for (std::uint64_t i = 0; i < iterations; ++i) {
+                            const auto program =
+                                calc::compile("267 + 45 × 0.1344 ÷ 4");
+                            keep(program->code.size());
+                          }
+                          return iterations;
+                        }});
+
+  // Compiling into one Program over and over, as batch lines and key
+  // presses do, reuses its buffers instead of allocating new ones
+  benchmarks.push_back(
+      {"engine/compile_reuse", [](std::uint64_t iterations) {
+         calc::Program program;
+         for (std::uint64_t i = 0; i < iterations; ++i) {
+           calc::compile("267 + 45 × 0.1344 ÷ 4", program);
+           keep(program.code.size());
+         }
+         return iterations;
+       }});
+
+  benchmarks.push_back(
+      {"engine/evaluate", [](std::uint64_t iterations) {
+         static const auto program = calc::compile("267 + 45 × 0.1344 ÷ 4");
+         for (std::uint64_t i = 0; i < iterations; ++i) {
+           keep(*calc::evaluate(*program));
+         }
+         return iterations;
+       }});
+
+  // The same expression compiled at build time, with its constants as
+  // variables so the work is not folded away
+  benchmarks.push_back(
+      {"engine/formula", [](std::uint64_t iterations) {
+         constexpr auto program = calc::formula<"a + b × c ÷ d">;
+         for (std::uint64_t i = 0; i < iterations; ++i) {
+           keep(*program(267.0, 45.0, 0.1344, 4.0));
+         }
+         return iterations;
+       }});
+
+  // What Session::calculate() does per operator press: compile the
+  // history, evaluate it and format the result for the display
+  benchmarks.push_back(
+      {"engine/calculate", [](std::uint64_t iterations) {
+         std::size_t length = 0;
+         for (std::uint64_t i = 0; i < iterations; ++i) {
+           const auto program = calc::compile("267 + 45 × 0.1344 ÷ 4");
+           length += calc::formatNumber(*calc::evaluate(*program)).size();
+         }
+         keep(length);
+         return iterations;
+       }});
+}
+
+// One formula over six columns of 4096 rows, as `--formula` evaluates it
+// on the interpreter and as native code once it is hot
+void addColumnarBenchmarks(std::vector<Benchmark> &benchmarks) {
+  constexpr std::size_t kRows = 4096;
+  static const std::vector<double> numbers = makeNumbers(6 * kRows);
+  static const auto program =
+      calc::compile("(a × b + c) ÷ (d - e) × f% + a × a - b × (c + d) ÷ "
+                    "(e + 1)");
+  static const std::vector<const double *> columns = [] {
+    std::vector<const double *> pointers;
+    for (std::size_t i = 0; i < 6; ++i) {
+      pointers.push_back(numbers.data() + i * kRows);
+    }
+    return pointers;
+  }();
+
+  benchmarks.push_back(
+      {"columnar/interpreted", [](std::uint64_t iterations) {
+         std::vector<double> values(kRows);
+         std::vector<std::uint8_t> errors(kRows);
+         for (std::uint64_t i = 0; i < iterations; ++i) {
+           calc::evaluateColumns(*program, columns, kRows, values.data(),
+                                 errors.data());
+           keep(values[i % kRows]);
+         }
+         return iterations * kRows;
+       }});
+
+  benchmarks.push_back(
+      {"columnar/native", [](std::uint64_t iterations) {
+         static const auto native = calc::NativeProgram::compile(*program);
+         if (!native) {
+           return std::uint64_t{0}; // No JIT on this platform
+         }
+         std::vector<double> values(kRows);
+         std::vector<std::uint8_t> errors(kRows);
+         for (std::uint64_t i = 0; i < iterations; ++i) {
+           native->run(columns, kRows, values.data(), errors.data());
+           keep(values[i % kRows]);
+         }
+         return iterations * kRows;
+       }});
+}
+
+// What --stats does per result, and the merge that combines two workers'
+// partial statistics
+void addStatisticsBenchmarks(std::vector<Benchmark> &benchmarks) {
+  static const std::vector<double> numbers = makeNumbers(4096);
+
+  benchmarks.push_back({"stats/add", [](std::uint64_t iterations) {
+                          calc::Statistics statistics;
+                          for (std::uint64_t i = 0; i < iterations; ++i) {
+                            statistics.add(numbers[i % 4096]);
+                          }
+                          keep(statistics.percentile(50.0));
+                          return iterations;
+                        }});
+
+  benchmarks.push_back({"stats/merge", [](std::uint64_t iterations) {
+                          calc::Statistics part;
+                          for (const double number : numbers) {
+                            part.add(number);
+                          }
+                          calc::Statistics total;
+                          for (std::uint64_t i = 0; i < iterations; ++i) {
+                            total.merge(part);
+                          }
+                          keep(total.percentile(99.0));
+                          return iterations;
+                        }});
+
+  benchmarks.push_back(
+      {"stats/function", [](std::uint64_t iterations) {
+         static const auto program =
+             calc::compile("percentile(90, 267, 45, 0.1344, 4, 12, 7.5)");
+         for (std::uint64_t i = 0; i < iterations; ++i) {
+           keep(*calc::evaluate(*program));
+         }
+         return iterations;
+       }});
+}
+
+// The key-press lookup of a unit, and converting a column of values one
+// at a time against the SIMD kernel
+void addUnitBenchmarks(std::vector<Benchmark> &benchmarks) {
+  constexpr std::size_t kRows = 4096;
+  static const std::vector<double> numbers = makeNumbers(kRows);
+  static const auto table =
+      calc::UnitTable::parse("m length 1\n"
+                             "km length 1000\n"
+                             "mi length 1609.344\n"
+                             "ft length 0.3048\n"
+                             "kg mass 1\n"
+                             "lb mass 0.45359237\n"
+                             "K temperature 1\n"
+                             "°C temperature 1 273.15\n");
+  static const calc::Conversion conversion = *table->conversion("km", "mi");
+
+  benchmarks.push_back({"units/find", [](std::uint64_t iterations) {
+                          constexpr std::string_view kNames[] = {"km", "lb",
+                                                                 "°C", "mi"};
+                          std::size_t found = 0;
+                          for (std::uint64_t i = 0; i < iterations; ++i) {
+                            found += table->find(kNames[i % 4]);
+                          }
+                          keep(found);
+                          return iterations;
+                        }});
+
+  benchmarks.push_back({"units/convert_scalar", [](std::uint64_t iterations) {
+                          std::vector<double> out(kRows);
+                          for (std::uint64_t i = 0; i < iterations; ++i) {
+                            for (std::size_t row = 0; row < kRows; ++row) {
+                              out[row] = conversion(numbers[row]);
+                            }
+                            keep(out[i % kRows]);
+                          }
+                          return iterations * kRows;
+                        }});
+
+  benchmarks.push_back({"units/convert_bulk", [](std::uint64_t iterations) {
+                          std::vector<double> out(kRows);
+                          for (std::uint64_t i = 0; i < iterations; ++i) {
+                            conversion.apply(numbers, out.data());
+                            keep(out[i % kRows]);
+                          }
+                          return iterations * kRows;
+                        }});
+}
+
+void addPlotBenchmarks(std::vector<Benchmark> &benchmarks) {
+  // A pole and a parabola through the middle of one tile
+  static const calc::Program program = *calc::compile("1 / (x - 0.3) + x * x");
+  static constexpr calc::PlotArea area{-4.0, 4.0, 8.0 / calc::kTileSize};
+
+  benchmarks.push_back({"plot/sample", [](std::uint64_t iterations) {
+                          std::vector<calc::CurvePoint> points;
+                          for (std::uint64_t i = 0; i < iterations; ++i) {
+                            calc::sampleCurve(program, area, points);
+                            keep(points.size());
+                          }
+                          return iterations;
+                        }});
+
+  benchmarks.push_back({"plot/render", [](std::uint64_t iterations) {
+                          std::vector<calc::CurvePoint> points;
+                          calc::sampleCurve(program, area, points);
+                          std::vector<std::uint32_t> pixels(
+                              std::size_t{calc::kTileSize} * calc::kTileSize);
+                          for (std::uint64_t i = 0; i < iterations; ++i) {
+                            calc::renderCurve(points, area, 0xFFE6850E,
+                                              pixels.data(), calc::kTileSize);
+                            keep(std::size_t{pixels[i % pixels.size()]});
+                          }
+                          return iterations;
+                        }});
+}
+
+void addFormatBenchmarks(std::vector<Benchmark> &benchmarks) {
+  static const std::vector<double> numbers = makeNumbers(4096);
+
+  benchmarks.push_back({"format/formatNumber", [](std::uint64_t iterations) {
+                          std::size_t length = 0;
+                          for (std::uint64_t i = 0; i < iterations; ++i) {
+                            length +=
+                                calc::formatNumber(numbers[i % 4096]).size();
+                          }
+                          keep(length);
+                          return iterations;
+                        }});
+
+  benchmarks.push_back(
+      {"format/formatNumber_buffer", [](std::uint64_t iterations) {
+         calc::NumberBuffer buffer;
+         std::size_t length = 0;
+         for (std::uint64_t i = 0; i < iterations; ++i) {
+           length += calc::formatNumber(numbers[i % 4096], buffer).size();
+         }
+         keep(length);
+         return iterations;
+       }});
+
+  benchmarks.push_back(
+      {"format/parseNumber", [](std::uint64_t iterations) {
+         static const std::vector<std::string> texts = [] {
+           std::vector<std::string> formatted;
+           for (const double number : numbers) {
+             formatted.push_back(calc::formatNumber(number));
+           }
+           return formatted;
+         }();
+         double total = 0.0;
+         for (std::uint64_t i = 0; i < iterations; ++i) {
+           total += calc::parseNumber(texts[i % 4096]);
+         }
+         keep(total);
+         return iterations;
+       }});
+}
+
+void addSessionBenchmarks(std::vector<Benchmark> &benchmarks) {
+  // Typing a 12-digit number and clearing it again
+  benchmarks.push_back({"session/inputDigit", [](std::uint64_t iterations) {
+                          calc::Session session;
+                          for (std::uint64_t i = 0; i < iterations; ++i) {
+                            if (i % 12 == 0) {
+                              session.allClear();
+                            }
+                            session.inputDigit(
+                                static_cast<char>('1' + i % 9));
+                          }
+                          keep(session.display().size());
+                          return iterations;
+                        }});
+
+  // Digits typed after a 20-operator chain, so every press rebuilds the
+  // preview from a long calculation history
+  benchmarks.push_back(
+      {"session/updatePreview", [](std::uint64_t iterations) {
+         calc::Session session;
+         const auto startChain = [&session] {
+           session.allClear();
+           for (int i = 0; i < 20; ++i) {
+             session.inputDigit(static_cast<char>('1' + i % 9));
+             session.performOperation(i % 2 ? calc::Operator::Multiply
+                                            : calc::Operator::Add);
+           }
+         };
+         startChain();
+         for (std::uint64_t i = 0; i < iterations; ++i) {
+           if (i % 8 == 0) {
+             session.clearEntry();
+           }
+           session.inputDigit(static_cast<char>('1' + i % 9));
+         }
+         keep(session.preview().size());
+         return iterations;
+       }});
+
+  // A recorded key sequence replayed through the action table
+  benchmarks.push_back(
+      {"session/dispatch", [](std::uint64_t iterations) {
+         constexpr std::string_view keys = "12+34*5-6/7=";
+         calc::Session session;
+         for (std::uint64_t i = 0; i < iterations; ++i) {
+           session.dispatch(*calc::actionForCharacter(keys[i % keys.size()]));
+         }
+         keep(session.value());
+         return iterations;
+       }});
+
+  // The same sequence with --latency timing switched on
+  benchmarks.push_back(
+      {"session/dispatch_timed", [](std::uint64_t iterations) {
+         constexpr std::string_view keys = "12+34*5-6/7=";
+         calc::LatencyMonitor monitor;
+         calc::Session session;
+         session.setLatencyMonitor(&monitor);
+         for (std::uint64_t i = 0; i < iterations; ++i) {
+           session.dispatch(*calc::actionForCharacter(keys[i % keys.size()]));
+         }
+         keep(monitor.histogram(calc::LatencyStage::Dispatch).count());
+         return iterations;
+       }});
+
+  // Random jumps through a 100k-step session whose expression has grown
+  // to 200 KB; each restores the history text and rebuilds the preview
+  benchmarks.push_back(
+      {"session/jumpTo", [](std::uint64_t iterations) {
+         static const calc::Session recorded = [] {
+           constexpr std::string_view keys = "12+34*5-6/7+";
+           calc::Session session;
+           for (std::size_t i = 0; i < 100000; ++i) {
+             session.dispatch(*calc::actionForCharacter(keys[i % 12]));
+           }
+           return session;
+         }();
+         calc::Session session = recorded;
+         std::mt19937_64 random(7);
+         for (std::uint64_t i = 0; i < iterations; ++i) {
+           session.jumpTo(random() % session.steps());
+         }
+         keep(session.preview().size());
+         return iterations;
+       }});
+
+  // Operator presses, each of which compiles and evaluates the history
+  benchmarks.push_back(
+      {"session/performOperation", [](std::uint64_t iterations) {
+         calc::Session session;
+         for (std::uint64_t i = 0; i < iterations; ++i) {
+           if (i % 32 == 0) {
+             session.allClear();
+           }
+           session.inputDigit(static_cast<char>('1' + i % 9));
+           session.performOperation(i % 2 ? calc::Operator::Multiply
+                                          : calc::Operator::Add);
+         }
+         keep(session.value());
+         return iterations;
+       }});
+}
+
+void addBatchBenchmarks(std::vector<Benchmark> &benchmarks,
+                        const Options &options) {
+  for (const std::size_t count : {std::size_t{1000}, std::size_t{1000000}}) {
+    const std::string label = count == 1000 ? "1K" : "1M";
+    auto input = std::make_shared<const std::string>(makeExpressions(count));
+
+    benchmarks.push_back({"batch/serial/" + label,
+                          [input](std::uint64_t iterations) {
+                            std::uint64_t lines = 0;
+                            for (std::uint64_t i = 0; i < iterations; ++i) {
+                              lines += evaluateSerial(*input);
+                            }
+                            return lines;
+                          },
+                          count >= 1000000 ? 1u : 0u});
+
+    benchmarks.push_back(
+        {"batch/parallel/" + label,
+         [input](std::uint64_t iterations) {
+           static calc::ThreadPool pool;
+           std::FILE *null = std::fopen(kNullDevice, "wb");
+           if (!null) {
+             return std::uint64_t{0};
+           }
+           std::uint64_t lines = 0;
+           {
+             calc::OutputStream out(null);
+             for (std::uint64_t i = 0; i < iterations; ++i) {
+               calc::BatchStats stats;
+               calc::evaluateLinesParallel(
+                   *input, true, out, stats, pool,
+                   [](std::string_view text, bool final, std::string &result,
+                      calc::BatchStats &counts) {
+                     return calc::evaluateLines(text, final, result, counts);
+                   });
+               lines += stats.lines;
+             }
+             out.flush();
+           }
+           std::fclose(null);
+           return lines;
+         },
+         count >= 1000000 ? 1u : 0u});
+  }
+
+  if (options.large) {
+    // 100M expressions would not fit in memory at once, so the same 1M
+    // lines are streamed through the evaluator a hundred times
+    auto input = std::make_shared<const std::string>(makeExpressions(1000000));
+    benchmarks.push_back({"batch/serial/100M",
+                          [input](std::uint64_t) {
+                            std::uint64_t lines = 0;
+                            for (int i = 0; i < 100; ++i) {
+                              lines += evaluateSerial(*input);
+                            }
+                            return lines;
+                          },
+                          1});
+  }
+}
+
+void printText(const std::vector<Result> &results) {
+  std::printf("%-32s %14s %14s %16s %10s\n", "benchmark", "iterations",
+              "ns/op", "items/s", "allocs/op");
+  for (const auto &result : results) {
+    std::printf("%-32s %14llu %14.1f %16.0f %10.2f\n", result.name.c_str(),
+                static_cast<unsigned long long>(result.iterations),
+                result.nsPerOp, result.itemsPerSecond,
+                result.allocationsPerOp);
+  }
+}
+
+void printJson(const std::vector<Result> &results, const Options &options) {
+  std::printf("{\n  \"context\": {\n");
+  std::printf("    \"threads\": %u,\n",
+              std::max(1u, std::thread::hardware_concurrency()));
+  std::printf("    \"repetitions\": %d,\n", options.repetitions);
+  std::printf("    \"min_time\": %g\n  },\n", options.minTime);
+  std::printf("  \"benchmarks\": [");
+  for (std::size_t i = 0; i < results.size(); ++i) {
+    const auto &result = results[i];
+    std::printf("%s\n    {\"name\": \"%s\", \"iterations\": %llu, "
+                "\"ns_per_op\": %.3f, \"items_per_second\": %.1f, "
+                "\"allocs_per_op\": %.3f}",
+                i ? "," : "", result.name.c_str(),
+                static_cast<unsigned long long>(result.iterations),
+                result.nsPerOp, result.itemsPerSecond,
+                result.allocationsPerOp);
+  }
+  std::printf("\n  ]\n}\n");
+}
+
+void printUsage(std::FILE *stream) {
+  std::fputs("Usage: calc_bench [--json] [--filter TEXT] [--min-time SECONDS] "
+             "[--large]\n"
+             "  --json              Print results as JSON\n"
+             "  --filter TEXT       Only run benchmarks whose name contains "
+             "TEXT\n"
+             "  --min-time SECONDS  Minimum duration of one repetition "
+             "(default 0.2)\n"
+             "  --large             Include the 100M-expression batch run\n",
+             stream);
+}
+
+} // namespace
+
+void *operator new(std::size_t size) {
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void *memory = std::malloc(size ? size : 1)) {
+    return memory;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void *memory) noexcept { std::free(memory); }
+void operator delete(void *memory, std::size_t) noexcept { std::free(memory); }
+
+int main(int argc, char *argv[]) {
+  Options options;
+  for (int i = 1; i < argc; ++i) {
+    const std::string_view arg = argv[i];
+    if (arg == "--json") {
+      options.json = true;
+    } else if (arg == "--large") {
+      options.large = true;
+    } else if (arg == "--filter" && i + 1 < argc) {
+      options.filter = argv[++i];
+    } else if (arg == "--min-time" && i + 1 < argc) {
+      options.minTime = std::strtod(argv[++i], nullptr);
+    } else if (arg == "-h" || arg == "--help") {
+      printUsage(stdout);
+      return 0;
+    } else {
+      std::fprintf(stderr, "calc_bench: unknown option '%s'\n", argv[i]);
+      printUsage(stderr);
+      return 2;
+    }
+  }
+
+  std::vector<Benchmark> benchmarks;
+  addEngineBenchmarks(benchmarks);
+  addColumnarBenchmarks(benchmarks);
+  addStatisticsBenchmarks(benchmarks);
+  addUnitBenchmarks(benchmarks);
+  addPlotBenchmarks(benchmarks);
+  addFormatBenchmarks(benchmarks);
+  addSessionBenchmarks(benchmarks);
+  addBatchBenchmarks(benchmarks, options);
+
+  std::vector<Result> results;
+  for (const auto &benchmark : benchmarks) {
+    if (benchmark.name.find(options.filter) == std::string::npos) {
+      continue;
+    }
+    if (!options.json) {
+      std::fprintf(stderr, "running %s\n", benchmark.name.c_str());
+    }
+    results.push_back(measure(benchmark, options));
+  }
+
+  if (options.json) {
+    printJson(results, options);
+  } else {
+    printText(results);
+  }
+  return 0;
+}
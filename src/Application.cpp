@@ -1,30 +1,164 @@
 #include "Application.hpp"
+#include "HistoryPanel.hpp"
+#include "PasteWindow.hpp"
+#include "PlotWidget.hpp"
+#include "StartupTrace.hpp"
+#include "Style.hpp"
 #include "TitleBarCustomizer.h"
-#include <QtWidgets/QGridLayout>
-#include <QtWidgets/QPushButton>
+#include <QtCore/QCoreApplication>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QStandardPaths>
+#include <QtCore/QTimer>
+#include <QtGui/QClipboard>
+#include <QtGui/QGuiApplication>
+#include <QtGui/QKeyEvent>
+#include <QtGui/QShortcut>
+#include <QtWidgets/QHBoxLayout>
 #include <QtWidgets/QVBoxLayout>
 
+namespace {
+
+// Typed or pasted character to action, including the keypad's own × and ÷
+std::optional<calc::Action> actionForCharacter(QChar c) {
+  if (c == QChar(0x00D7)) { // ×
+    return calc::Action::Multiply;
+  }
+  if (c == QChar(0x00F7)) { // ÷
+    return calc::Action::Divide;
+  }
+  return calc::actionForCharacter(c.toLatin1());
+}
+
+} // namespace
+
 Calculator::Calculator(QWidget *parent) : QMainWindow(parent) {
-  // Load Font Awesome first
-  loadFontAwesome();
+  const QStringList arguments = QCoreApplication::arguments();
+
+  // One stylesheet for the whole window, set before any child exists so
+  // Qt parses it once and polishes every widget against it
+  setStyleSheet(calculatorStyleSheet());
+
+  // --fast-start paints the first frame with plain symbols and loads the
+  // icon font right after it; otherwise load Font Awesome first
+  deferIconFont = arguments.contains("--fast-start");
+  if (!deferIconFont) {
+    loadFontAwesome();
+    StartupTrace::mark("icon font");
+  }
+
+  // Exact decimal arithmetic (0.1 + 0.2 = 0.3) is opt-in
+  if (arguments.contains("--decimal")) {
+    session.setNumericBackend(calc::NumericBackend::Decimal);
+  }
+
+  // --record FILE logs every action for `Calculator --replay FILE`
+  if (const qsizetype record = arguments.indexOf("--record");
+      record != -1 && record + 1 < arguments.size()) {
+    recorder = std::make_unique<calc::Recorder>(
+        arguments[record + 1].toStdString(), session.numericBackend());
+    if (!recorder->isOpen()) {
+      qWarning("Cannot record input: %s", recorder->error().c_str());
+      recorder.reset();
+    }
+  }
+
+  // Completed calculations persist in the user's data directory unless
+  // --no-history is given; --history-file FILE logs elsewhere
+  if (!arguments.contains("--no-history")) {
+    QString path;
+    if (const qsizetype index = arguments.indexOf("--history-file");
+        index != -1 && index + 1 < arguments.size()) {
+      path = arguments[index + 1];
+    } else {
+      const QString directory = QStandardPaths::writableLocation(
+          QStandardPaths::AppDataLocation);
+      QDir().mkpath(directory);
+      path = directory + "/history.log";
+    }
+    history = std::make_unique<calc::HistoryLog>(
+        QFile::encodeName(path).toStdString());
+    if (history->isOpen()) {
+      session.setHistoryLog(history.get());
+    } else {
+      qWarning("Cannot keep history: %s", history->error().c_str());
+      history.reset();
+    }
+    StartupTrace::mark("history");
+  }
+
+  // --latency [FILE] times every input until the display has repainted
+  if (const qsizetype index = arguments.indexOf("--latency"); index != -1) {
+    latency = std::make_unique<calc::LatencyMonitor>();
+    session.setLatencyMonitor(latency.get());
+    if (index + 1 < arguments.size() &&
+        !arguments[index + 1].startsWith("--")) {
+      latencyPath = arguments[index + 1];
+    }
+  }
+
+  // --units FILE --convert FROM:TO (e.g. km:mi) shows the display's value
+  // converted; the file is watched, so edits apply without a restart
+  if (const qsizetype index = arguments.indexOf("--units");
+      index != -1 && index + 1 < arguments.size()) {
+    const QString path = QFileInfo(arguments[index + 1]).absoluteFilePath();
+    units = std::make_unique<calc::UnitFile>(
+        QFile::encodeName(path).toStdString());
+    if (const qsizetype convert = arguments.indexOf("--convert");
+        convert != -1 && convert + 1 < arguments.size()) {
+      const QStringList pair = arguments[convert + 1].split(':');
+      if (pair.size() == 2) {
+        convertFrom = pair[0];
+        convertTo = pair[1];
+      }
+    }
+    // Editors that save by renaming replace the watched file, so its
+    // directory is watched too
+    unitWatcher = new QFileSystemWatcher(this);
+    unitWatcher->addPath(path);
+    unitWatcher->addPath(QFileInfo(path).absolutePath());
+    connect(unitWatcher, &QFileSystemWatcher::fileChanged, this,
+            &Calculator::reloadUnits);
+    connect(unitWatcher, &QFileSystemWatcher::directoryChanged, this,
+            &Calculator::reloadUnits);
+    if (!units->isOpen()) {
+      unitsError = units->error();
+      qWarning("Cannot load units: %s", unitsError.c_str());
+    }
+    applyConversion();
+    StartupTrace::mark("units");
+  }
 
   setCentralWidget([this] {
+    // The calculator column, and the plot panel to its right when shown
     auto *widget = new QWidget;
-    auto *layout = new QVBoxLayout(widget);
+    auto *row = new QHBoxLayout(widget);
+    row->setContentsMargins(0, 0, 0, 0);
+    row->setSpacing(0);
+    auto *column = new QWidget;
+    column->setFixedWidth(kCalculatorWidth);
+    row->addWidget(column);
+    plotPanel = new PlotPanel;
+    plotPanel->hide();
+    row->addWidget(plotPanel);
+    if (history) {
+      historyPanel = new HistoryPanel(*history);
+      historyPanel->setFixedWidth(kHistoryWidth);
+      historyPanel->hide();
+      connect(historyPanel, &HistoryPanel::resultChosen, this,
+              &Calculator::useResult);
+      row->addWidget(historyPanel);
+    }
+
+    auto *layout = new QVBoxLayout(column);
     layout->setContentsMargins(8, 8, 8, 8);
     layout->setSpacing(4);
 
     // Preview display (shows ongoing calculation)
     previewDisplay = new QLabel("");
     previewDisplay->setAlignment(Qt::AlignRight);
-    previewDisplay->setStyleSheet(R"(QLabel {
-              background: transparent;
-              color: rgba(255, 255, 255, 0.7);
-              font-size: 14px;
-              font-weight: 300;
-              padding: 4px 16px 0px 16px;
-              margin: 0px;
-          })");
+    previewDisplay->setObjectName("preview");
     previewDisplay->setMinimumHeight(24);
     previewDisplay->setMaximumHeight(24);
     previewDisplay->setWordWrap(false);
@@ -36,190 +170,77 @@ Calculator::Calculator(QWidget *parent) : QMainWindow(parent) {
     display->setReadOnly(true);
     display->setAlignment(Qt::AlignRight);
 
-    // Platform-specific display styling
-#ifdef Q_OS_LINUX
-    display->setStyleSheet(R"(QLineEdit {
-              background: rgba(60, 60, 70, 0.95);
-              color: white;
-              font-size: 32px;
-              font-weight: 500;
-              border-radius: 8px;
-              border: 1px solid rgba(80, 80, 90, 0.8);
-              padding: 12px 4px;
-              margin: 0px;
-          })");
-#else
-    display->setStyleSheet(R"(QLineEdit {
-              background: rgba(42, 42, 53, 0.85);
-              color: white;
-              font-size: 32px;
-              font-weight: 500;
-              border-radius: 8px;
-              padding: 12px 4px;
-              margin: 0px;
-          })");
-#endif
-
+    display->setObjectName("display");
     display->setMinimumHeight(60);
     layout->addWidget(display);
+    if (latency) {
+      display->installEventFilter(this);
+    }
 
-    // Buttons with Font Awesome icons
-    auto *grid = new QGridLayout;
-    grid->setSpacing(6);
-    grid->setContentsMargins(0, 0, 0, 0);
-
-    // Button configuration: {display_text, icon_text, row, col, type}
-    const std::vector<std::tuple<QString, QString, int, int, QString>> buttons =
-        {{"AC", "AC", 0, 0, "function"},
-         {"±", "±", 0, 1, "function"},
-         {"%", QString(FontAwesome::PERCENT), 0, 2, "function"},
-         {"÷", QString(FontAwesome::DIVIDE), 0, 3, "operator"},
-
-         {"7", "7", 1, 0, "number"},
-         {"8", "8", 1, 1, "number"},
-         {"9", "9", 1, 2, "number"},
-         {"×", QString(FontAwesome::TIMES), 1, 3, "operator"},
-
-         {"4", "4", 2, 0, "number"},
-         {"5", "5", 2, 1, "number"},
-         {"6", "6", 2, 2, "number"},
-         {"-", QString(FontAwesome::MINUS), 2, 3, "operator"},
-
-         {"1", "1", 3, 0, "number"},
-         {"2", "2", 3, 1, "number"},
-         {"3", "3", 3, 2, "number"},
-         {"+", QString(FontAwesome::PLUS), 3, 3, "operator"},
-
-         {"←", QString(FontAwesome::BACKSPACE), 4, 0, "function"},
-         {"0", "0", 4, 1, "number"},
-         {".", "•", 4, 2, "number"},
-         {"=", QString(FontAwesome::EQUALS), 4, 3, "operator"}};
-
-    for (const auto &[actionKey, displayText, row, col, type] : buttons) {
-      auto *button = new QPushButton(displayText);
-
-      // Set Font Awesome font for icon buttons
-      bool useIconFont = (displayText == QString(FontAwesome::BACKSPACE) ||
-                          displayText == QString(FontAwesome::PLUS) ||
-                          displayText == QString(FontAwesome::MINUS) ||
-                          displayText == QString(FontAwesome::TIMES) ||
-                          displayText == QString(FontAwesome::DIVIDE) ||
-                          displayText == QString(FontAwesome::EQUALS) ||
-                          displayText == QString(FontAwesome::PERCENT));
-
-      if (useIconFont && !fontAwesome.family().isEmpty()) {
-        button->setFont(fontAwesome);
-      }
+    // Keys with Font Awesome icons: {action, text, icon, row, col, kind}
+    using calc::Action;
+    using Kind = KeypadWidget::Kind;
+    const QString percent(FontAwesome::PERCENT);
+    const QString divide(FontAwesome::DIVIDE);
+    const QString times(FontAwesome::TIMES);
+    const QString minus(FontAwesome::MINUS);
+    const QString plus(FontAwesome::PLUS);
+    const QString backspace(FontAwesome::BACKSPACE);
+    const QString equals(FontAwesome::EQUALS);
+    std::vector<KeypadWidget::Key> keys = {
+        {Action::AllClear, "AC", false, 0, 0, Kind::Function},
+        {Action::Negate, "±", false, 0, 1, Kind::Function},
+        {Action::Percent, percent, true, 0, 2, Kind::Function},
+        {Action::Divide, divide, true, 0, 3, Kind::Operator},
 
-      // Set fixed size for circular buttons
-      button->setFixedSize(38, 38);
+        {Action::Digit7, "7", false, 1, 0, Kind::Number},
+        {Action::Digit8, "8", false, 1, 1, Kind::Number},
+        {Action::Digit9, "9", false, 1, 2, Kind::Number},
+        {Action::Multiply, times, true, 1, 3, Kind::Operator},
 
-      QString buttonStyle;
-      if (type == "number") {
-#ifdef Q_OS_LINUX
-        buttonStyle = R"(QPushButton {
-                      background: rgba(90, 90, 95, 0.95);
-                      color: white;
-                      border: 1px solid rgba(110, 110, 115, 0.8);
-                      border-radius: 19px;
-                      font-size: 18px;
-                      font-weight: 400;
-                  }
-                  QPushButton:hover {
-                      background: rgba(115, 115, 120, 1.0);
-                      border: 1px solid rgba(130, 130, 135, 0.9);
-                  }
-                  QPushButton:pressed {
-                      background: rgba(129, 129, 135, 1.0);
-                      border: 1px solid rgba(70, 70, 75, 1.0);
-                  })";
-#else
-        buttonStyle = R"(QPushButton {
-                      background: rgba(81, 81, 83, 0.85);
-                      color: white;
-                      border: none;
-                      border-radius: 19px;
-                      font-size: 18px;
-                      font-weight: 400;
-                  }
-                  QPushButton:hover {
-                      background: rgba(115, 115, 115, 0.9);
-                  }
-                  QPushButton:pressed {
-                      background: rgba(129, 129, 132, 0.95);
-                      border: 1px solid rgba(70, 70, 70, 1.0);
-                  })";
-#endif
-      } else if (type == "function") {
-#ifdef Q_OS_LINUX
-        buttonStyle = R"(QPushButton {
-                      background: rgba(120, 120, 125, 0.95);
-                      color: white;
-                      border: 1px solid rgba(140, 140, 145, 0.8);
-                      border-radius: 19px;
-                      font-size: 17px;
-                      font-weight: 500;
-                  }
-                  QPushButton:hover {
-                      background: rgba(160, 160, 165, 1.0);
-                      border: 1px solid rgba(180, 180, 185, 0.9);
-                  }
-                  QPushButton:pressed {
-                      background: rgba(142, 142, 147, 1.0);
-                      border: 1px solid rgba(130, 130, 135, 1.0);
-                  })";
-#else
-        buttonStyle = R"(QPushButton {
-                      background: rgba(111, 112, 115, 0.85);
-                      color: white;
-                      border: none;
-                      border-radius: 19px;
-                      font-size: 17px;
-                      font-weight: 500;
-                  }
-                  QPushButton:hover {
-                      background: rgba(180, 180, 180, 0.9);
-                  }
-                  QPushButton:pressed {
-                      background: rgba(142, 142, 144, 0.95);
-                      border: 1px solid rgba(130, 130, 130, 1.0);
-                  })";
-#endif
-      } else { // operator
-        buttonStyle = R"(QPushButton {
-                      background: rgba(255, 149, 0, 0.9);
-                      color: white;
-                      border: none;
-                      border-radius: 19px;
-                      font-size: 18px;
-                      font-weight: 500;
-                  }
-                  QPushButton:hover {
-                      background: rgba(255, 165, 30, 0.95);
-                  }
-                  QPushButton:pressed {
-                      background: rgba(230, 133, 14, 1.0);
-                      border: 1px solid rgba(200, 110, 0, 1.0);
-                  })";
-      }
+        {Action::Digit4, "4", false, 2, 0, Kind::Number},
+        {Action::Digit5, "5", false, 2, 1, Kind::Number},
+        {Action::Digit6, "6", false, 2, 2, Kind::Number},
+        {Action::Subtract, minus, true, 2, 3, Kind::Operator},
 
-      button->setStyleSheet(buttonStyle);
-      grid->addWidget(button, row, col);
+        {Action::Digit1, "1", false, 3, 0, Kind::Number},
+        {Action::Digit2, "2", false, 3, 1, Kind::Number},
+        {Action::Digit3, "3", false, 3, 2, Kind::Number},
+        {Action::Add, plus, true, 3, 3, Kind::Operator},
 
-      // Connect button to action using the actionKey
-      connect(button, &QPushButton::clicked, [this, actionKey] {
-        if (actions.contains(actionKey)) {
-          actions[actionKey]();
-        }
-      });
-    }
+        {Action::Backspace, backspace, true, 4, 0, Kind::Function},
+        {Action::Digit0, "0", false, 4, 1, Kind::Number},
+        {Action::DecimalPoint, "•", false, 4, 2, Kind::Number},
+        {Action::Equals, equals, true, 4, 3, Kind::Operator}};
 
-    layout->addLayout(grid);
+    // One painted widget for all twenty keys; the action is bound to each
+    // key, so a click needs no lookup
+    keypad = new KeypadWidget(std::move(keys));
+    connect(keypad, &KeypadWidget::actionTriggered,
+            [this](calc::Action action) { trigger(action); });
+    layout->addWidget(keypad);
     return widget;
   }());
+  StartupTrace::mark("widgets");
+
+  // The display is read-only, so paste is a window-wide shortcut
+  connect(new QShortcut(QKeySequence::Paste, this), &QShortcut::activated,
+          this, &Calculator::paste);
+  // Undo and redo go through trigger() so recordings and latency see them
+  connect(new QShortcut(QKeySequence::Undo, this), &QShortcut::activated,
+          this, [this] { trigger(calc::Action::Undo); });
+  connect(new QShortcut(QKeySequence::Redo, this), &QShortcut::activated,
+          this, [this] { trigger(calc::Action::Redo); });
 
   // Set window properties
-  setFixedSize(200, 320);
+  setFixedSize(kCalculatorWidth, kWindowHeight);
+
+  // --plot EXPR opens the plot panel (F2) graphing EXPR
+  if (const qsizetype index = arguments.indexOf("--plot");
+      index != -1 && index + 1 < arguments.size()) {
+    plotPanel->setExpression(arguments[index + 1]);
+    setPlotVisible(true);
+  }
 
   // Platform-specific window setup
 #ifdef Q_OS_LINUX
@@ -245,21 +266,231 @@ Calculator::Calculator(QWidget *parent) : QMainWindow(parent) {
   // Customize title bar color using cross-platform helper
   customizeTitleBar(winId(), this);
 
-  // Platform-specific main window styling
-#ifdef Q_OS_LINUX
-  setStyleSheet(R"(
-          QMainWindow {
-              background: rgb(45, 45, 55);
-              border-radius: 8px;
-              border: 1px solid rgba(70, 70, 70, 0.8);
-          }
-      )");
-#else
-  setStyleSheet(R"(
-          QMainWindow {
-              background: rgba(45, 45, 55, 0.85);
-              border-radius: 8px;
-          }
-      )");
-#endif
-}
\ No newline at end of file
+  if (!deferIconFont) {
+    applyIconFont();
+  }
+  StartupTrace::mark("window built");
+}
+
+Calculator::~Calculator() {
+  // The history panel is a child, destroyed after the members; stopping
+  // the writer first means it no longer calls the panel's listener
+  session.setHistoryLog(nullptr);
+  history.reset();
+  if (recorder) {
+    recorder->finish(session.display());
+  }
+  if (latency) {
+    reportLatency();
+  }
+}
+
+void Calculator::trigger(calc::Action action) {
+  using Clock = calc::LatencyMonitor::Clock;
+  const Clock::time_point start = latency ? Clock::now() : Clock::time_point();
+  if (recorder) {
+    recorder->record(action);
+  }
+  session.dispatch(action);
+  {
+    const calc::ScopedLatency timer(latency.get(), calc::LatencyStage::Refresh);
+    refresh();
+  }
+  if (latency) {
+    // Inputs that arrive faster than the display repaints (a slow remote
+    // session) share one paint; the oldest of them waited longest
+    if (!paintPending) {
+      inputTime = start;
+      paintPending = true;
+    }
+    refreshTime = Clock::now();
+  }
+}
+
+void Calculator::paste() {
+  const QString text = QGuiApplication::clipboard()->text().trimmed();
+  if (text.isEmpty()) {
+    return;
+  }
+  // Several rows (a spreadsheet column, a list of expressions) are split
+  // and evaluated off the UI thread, into a window of their own
+  if (text.contains(QChar('\n'))) {
+    auto *window =
+        new PasteWindow(text.toStdString(), session.numericBackend(), this);
+    window->show();
+    return;
+  }
+  // A single number or expression is typed in as if from the keyboard
+  type(text);
+}
+
+void Calculator::type(const QString &text) {
+  for (const QChar c : text) {
+    if (const std::optional<calc::Action> action = actionForCharacter(c)) {
+      trigger(*action);
+    }
+  }
+}
+
+void Calculator::useResult(const QString &result) {
+  // Typed, a leading minus would be the subtraction key
+  if (result.startsWith('-')) {
+    type(result.mid(1));
+    trigger(calc::Action::Negate);
+  } else {
+    type(result);
+  }
+}
+
+void Calculator::setPlotVisible(bool visible) {
+  plotPanel->setVisible(visible);
+  fitPanels(visible ? plotPanel : nullptr);
+}
+
+void Calculator::setHistoryVisible(bool visible) {
+  historyPanel->setVisible(visible);
+  fitPanels(visible ? historyPanel : nullptr);
+}
+
+void Calculator::fitPanels(QWidget *focus) {
+  int width = kCalculatorWidth;
+  if (!plotPanel->isHidden()) {
+    width += kPlotWidth;
+  }
+  if (historyPanel && !historyPanel->isHidden()) {
+    width += kHistoryWidth;
+  }
+  setFixedSize(width, kWindowHeight);
+  if (focus) {
+    focus->setFocus();
+  } else {
+    display->setFocus(); // Typing goes to the keypad again
+  }
+}
+
+void Calculator::reloadUnits() {
+  const QString path = QFile::decodeName(units->path().c_str());
+  if (!unitWatcher->files().contains(path) && QFileInfo::exists(path)) {
+    unitWatcher->addPath(path);
+  }
+  // Most directory changes are other files; reload() only re-reads this
+  // one when its size or modification time moved
+  if (units->reload()) {
+    unitsError.clear();
+    applyConversion();
+    refresh();
+  } else if (!units->error().empty() && units->error() != unitsError) {
+    unitsError = units->error();
+    qWarning("Keeping the previous units: %s", unitsError.c_str());
+  }
+}
+
+void Calculator::applyConversion() {
+  std::optional<calc::Conversion> conversion;
+  if (const auto &table = units->table(); table && !convertFrom.isEmpty()) {
+    conversion = table->conversion(convertFrom.toStdString(),
+                                   convertTo.toStdString());
+    if (!conversion) {
+      qWarning("Cannot convert %s to %s", qPrintable(convertFrom),
+               qPrintable(convertTo));
+    }
+  }
+  session.setConversion(conversion);
+}
+
+bool Calculator::eventFilter(QObject *watched, QEvent *event) {
+  if (watched != display || event->type() != QEvent::Paint ||
+      !paintPending) {
+    return QMainWindow::eventFilter(watched, event);
+  }
+  // Paint now, from inside the filter, so the time includes the painting
+  static_cast<QObject *>(display)->event(event);
+  const auto now = calc::LatencyMonitor::Clock::now();
+  latency->record(calc::LatencyStage::Paint, now - refreshTime);
+  latency->record(calc::LatencyStage::Total, now - inputTime);
+  paintPending = false;
+  return true;
+}
+
+void Calculator::reportLatency() const {
+  std::FILE *out = stderr;
+  if (!latencyPath.isEmpty()) {
+    out = std::fopen(QFile::encodeName(latencyPath).constData(), "a");
+    if (!out) {
+      qWarning("Cannot write latency report to %s", qPrintable(latencyPath));
+      return;
+    }
+  }
+  latency->report(out);
+  if (out != stderr) {
+    std::fclose(out);
+  }
+}
+
+void Calculator::paintEvent(QPaintEvent *event) {
+  QMainWindow::paintEvent(event);
+  if (firstFramePainted) {
+    return;
+  }
+  // The window paints before its children, all into the same first frame
+  firstFramePainted = true;
+  StartupTrace::firstFrame();
+  if (deferIconFont) {
+    QTimer::singleShot(0, this, [this] {
+      loadFontAwesome();
+      applyIconFont();
+    });
+  }
+}
+
+void Calculator::applyIconFont() {
+  if (fontAwesome.family().isEmpty()) {
+    return; // Keep the plain symbols
+  }
+  keypad->setIconFont(fontAwesome);
+}
+
+void Calculator::keyPressEvent(QKeyEvent *event) {
+  std::optional<calc::Action> action;
+  switch (event->key()) {
+  case Qt::Key_F2:
+    setPlotVisible(plotPanel->isHidden());
+    return;
+  case Qt::Key_F3:
+    if (historyPanel) {
+      setHistoryVisible(historyPanel->isHidden());
+      return;
+    }
+    break;
+  case Qt::Key_F12:
+    if (latency) {
+      reportLatency(); // On request, without resetting the histograms
+      return;
+    }
+    break;
+  case Qt::Key_Return:
+  case Qt::Key_Enter:
+    action = calc::Action::Equals;
+    break;
+  case Qt::Key_Backspace:
+    action = calc::Action::Backspace;
+    break;
+  case Qt::Key_Escape:
+    action = calc::Action::AllClear;
+    break;
+  case Qt::Key_Delete:
+    action = calc::Action::ClearEntry;
+    break;
+  default:
+    if (const QString text = event->text(); text.size() == 1) {
+      action = actionForCharacter(text.front());
+    }
+    break;
+  }
+
+  if (action) {
+    trigger(*action);
+  } else {
+    QMainWindow::keyPressEvent(event);
+  }
+}
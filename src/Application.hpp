@@ -1,27 +1,63 @@
 #pragma once
+#include "KeypadWidget.hpp"
+#include "engine/HistoryLog.hpp"
+#include "engine/Latency.hpp"
+#include "engine/Recording.hpp"
+#include "engine/Session.hpp"
+#include "engine/Units.hpp"
+#include <QtCore/QFileSystemWatcher>
 #include <QtGui/QFont>
 #include <QtGui/QFontDatabase>
 #include <QtWidgets/QLabel>
 #include <QtWidgets/QLineEdit>
 #include <QtWidgets/QMainWindow>
-#include <functional>
-#include <unordered_map>
+#include <memory>
+
+class HistoryPanel;
+class PlotPanel;
 
 class Calculator : public QMainWindow {
   Q_OBJECT
 
 public:
   explicit Calculator(QWidget *parent = nullptr);
+  ~Calculator() override;
+
+protected:
+  void keyPressEvent(QKeyEvent *event) override;
+  void paintEvent(QPaintEvent *event) override;
+  bool eventFilter(QObject *watched, QEvent *event) override;
 
 private:
   QLabel *previewDisplay; // Shows ongoing calculation
   QLineEdit *display;     // Shows current number/result
+  KeypadWidget *keypad;   // All twenty keys
+  PlotPanel *plotPanel;   // Graph beside the keypad, toggled with F2
+  HistoryPanel *historyPanel = nullptr; // Scrollback and search, F3
   QFont fontAwesome;      // Font Awesome font
 
-  double result = 0.0;
-  QString operation;
-  bool waitingForNumber = true;
-  QString calculationHistory; // Tracks the full expression
+  calc::Session session; // Headless keypad state machine
+  std::unique_ptr<calc::Recorder> recorder; // Set by --record FILE
+  std::unique_ptr<calc::HistoryLog> history; // Every completed calculation
+
+  // --latency [FILE]: input-to-repaint histograms, reported on exit (to
+  // FILE, else stderr) and whenever F12 is pressed
+  std::unique_ptr<calc::LatencyMonitor> latency;
+  QString latencyPath;
+  calc::LatencyMonitor::Clock::time_point inputTime;   // Oldest unpainted
+  calc::LatencyMonitor::Clock::time_point refreshTime; // Latest refresh
+  bool paintPending = false;
+
+  // --units FILE --convert FROM:TO: the display converted FROM one unit TO
+  // another, following edits to FILE while the window is open
+  std::unique_ptr<calc::UnitFile> units;
+  QFileSystemWatcher *unitWatcher = nullptr;
+  QString convertFrom;
+  QString convertTo;
+  std::string unitsError; // Last load error reported, to report each once
+
+  bool deferIconFont = false;     // --fast-start: load it after first paint
+  bool firstFramePainted = false;
 
   // Font Awesome Unicode mappings
   struct FontAwesome {
@@ -49,101 +85,6 @@ private:
     static constexpr const char *NUM_9 = "9";
   };
 
-  // Function lookup table with Font Awesome icons
-  std::unordered_map<QString, std::function<void()>> actions = {
-      // Digits
-      {"0", [this] { inputDigit("0"); }},
-      {"1", [this] { inputDigit("1"); }},
-      {"2", [this] { inputDigit("2"); }},
-      {"3", [this] { inputDigit("3"); }},
-      {"4", [this] { inputDigit("4"); }},
-      {"5", [this] { inputDigit("5"); }},
-      {"6", [this] { inputDigit("6"); }},
-      {"7", [this] { inputDigit("7"); }},
-      {"8", [this] { inputDigit("8"); }},
-      {"9", [this] { inputDigit("9"); }},
-
-      // Operations
-      {".",
-       [this] {
-         if (waitingForNumber) {
-           display->setText("0.");
-         } else if (!display->text().contains('.')) {
-           display->setText(display->text() + ".");
-         }
-         waitingForNumber = false;
-       }},
-
-      {"±",
-       [this] {
-         const auto value = -display->text().toDouble();
-         display->setText(QString::number(value));
-         updatePreview();
-       }},
-
-      {"AC",
-       [this] {
-         display->setText("0");
-         result = 0.0;
-         operation = "";
-         calculationHistory = "";
-         waitingForNumber = true;
-         previewDisplay->setText("");
-         updatePreview();
-       }},
-
-      {"%",
-       [this] {
-         const auto value = display->text().toDouble();
-         display->setText(QString::number(value / 100.0));
-         waitingForNumber = true;
-         updatePreview();
-       }},
-
-      {"C",
-       [this] {
-         display->setText("0");
-         waitingForNumber = true;
-         updatePreview();
-       }},
-
-      {"CE",
-       [this] {
-         display->setText("0");
-         result = 0.0;
-         operation = "";
-         calculationHistory = "";
-         waitingForNumber = true;
-         updatePreview();
-       }},
-
-      {"←",
-       [this] {
-         const auto text = display->text();
-         display->setText(text.length() > 1 ? text.left(text.length() - 1)
-                                            : "0");
-         if (display->text() == "0") {
-           waitingForNumber = true;
-         }
-         updatePreview();
-       }},
-
-      {"=",
-       [this] {
-         if (!operation.isEmpty()) {
-           calculate();
-           operation = "";
-           calculationHistory = "";
-           waitingForNumber = true;
-           previewDisplay->setText("");
-         }
-       }},
-
-      {"+", [this] { performOperation("+"); }},
-      {"-", [this] { performOperation("-"); }},
-      {"×", [this] { performOperation("×"); }},
-      {"÷", [this] { performOperation("÷"); }}};
-
   void loadFontAwesome() {
     // Load Font Awesome from resources or file
     int fontId = QFontDatabase::addApplicationFont(":/fonts/fa-solid-900.ttf");
@@ -161,6 +102,9 @@ private:
     }
   }
 
+  // Switches icon keys to Font Awesome once it is loaded
+  void applyIconFont();
+
   QString getButtonIcon(const QString &buttonText) {
     // Map button text to Font Awesome icons
     if (buttonText == "←")
@@ -186,78 +130,64 @@ private:
     return buttonText;
   }
 
-  void inputDigit(const QString &digit) {
-    if (waitingForNumber || display->text() == "0") {
-      display->setText(digit);
-      waitingForNumber = false;
-    } else {
-      display->setText(display->text() + digit);
-    }
-    updatePreview();
-  }
-
-  void calculate() {
-    if (!operation.isEmpty()) {
-      const auto value = display->text().toDouble();
-      if (operation == "+") {
-        result = result + value;
-      } else if (operation == "-") {
-        result = result - value;
-      } else if (operation == "×") {
-        result = result * value;
-      } else if (operation == "÷" && (value != 0.0)) {
-        result = result / value;
-      } else if (operation == "÷" && (value == 0.0)) {
-        // Handle division by zero
-        display->setText("Error");
-        previewDisplay->setText("Cannot divide by zero");
-        calculationHistory = "";
-        operation = "";
-        waitingForNumber = true;
-        return;
-      }
-      display->setText(formatNumber(result));
+  // Button clicks and key presses land here with their action already
+  // resolved, so a press is one switch in Session::dispatch()
+  void trigger(calc::Action action);
+
+  // Ctrl+V (or the platform's paste key): one line is typed in, a block of
+  // lines opens a PasteWindow
+  void paste();
+  // Types `text` in as if from the keyboard, skipping what has no key
+  void type(const QString &text);
+  // An entry picked in the history panel: its result becomes the operand
+  void useResult(const QString &result);
+
+  void reportLatency() const;
+
+  // Window geometry, widened by the plot and history panels while shown
+  static constexpr int kCalculatorWidth = 200;
+  static constexpr int kPlotWidth = 280;
+  static constexpr int kHistoryWidth = 240;
+  static constexpr int kWindowHeight = 320;
+
+  void setPlotVisible(bool visible);
+  void setHistoryVisible(bool visible);
+  // Fits the window to the panels shown and focuses `focus`, or the keypad
+  void fitPanels(QWidget *focus);
+
+  // Re-reads the units file after it changed and applies the new table
+  void reloadUnits();
+  // Hands the session the FROM:TO conversion of the current table
+  void applyConversion();
+
+  // More preview text than the 200px window can show
+  static constexpr std::size_t kPreviewBytes = 48;
+
+  // Mirrors the session state into the display widgets
+  void refresh() {
+    display->setText(QString::fromStdString(session.display()));
+
+    // Long chains only convert their visible tail, plus the live result
+    const std::string_view tail = session.previewTail(kPreviewBytes);
+    QString preview =
+        QString::fromUtf8(tail.data(), static_cast<qsizetype>(tail.size()));
+    if (tail.size() < session.preview().size()) {
+      preview.prepend(QChar(0x2026)); // …
     }
-  }
-
-  void performOperation(const QString &op) {
-    if (!operation.isEmpty()) {
-      // Chain operations: complete previous calculation
-      calculationHistory += " " + display->text() + " " + operation;
-      calculate();
-    } else {
-      // First operation: start new calculation
-      result = display->text().toDouble();
-      calculationHistory = display->text();
+    if (!session.running().empty()) {
+      preview += " = ";
+      preview += QString::fromStdString(session.running());
     }
-    calculationHistory += " " + op;
-    operation = op;
-    waitingForNumber = true;
-    updatePreview();
-  }
-
-  void updatePreview() {
-    if (calculationHistory.isEmpty()) {
-      previewDisplay->setText("");
-    } else if (operation.isEmpty()) {
-      // Show completed calculation
-      previewDisplay->setText(calculationHistory);
-    } else {
-      // Show ongoing calculation
-      QString preview = calculationHistory;
-      if (!waitingForNumber) {
-        preview += " " + display->text();
+    if (!session.converted().empty()) {
+      if (!preview.isEmpty()) {
+        preview += "  ";
       }
-      previewDisplay->setText(preview);
-    }
-  }
-
-  QString formatNumber(double number) {
-    // Format number to avoid unnecessary decimals
-    if (number == (long long)number) {
-      return QString::number((long long)number);
-    } else {
-      return QString::number(number, 'g', 10);
+      preview += QChar(0x2192); // →
+      preview += ' ';
+      preview += QString::fromStdString(session.converted());
+      preview += ' ';
+      preview += convertTo;
     }
+    previewDisplay->setText(preview);
   }
 };
\ No newline at end of file
@@ -0,0 +1,135 @@
+#include "HistoryPanel.hpp"
+#include <QtCore/QMetaObject>
+#include <QtWidgets/QVBoxLayout>
+#include <algorithm>
+#include <climits>
+#include <string_view>
+
+namespace {
+
+int clampRows(std::size_t rows) {
+  return static_cast<int>(std::min<std::size_t>(rows, INT_MAX));
+}
+
+QString toQString(std::string_view text) {
+  return QString::fromUtf8(text.data(), static_cast<qsizetype>(text.size()));
+}
+
+} // namespace
+
+HistoryModel::HistoryModel(calc::HistoryLog &log, QObject *parent)
+    : QAbstractListModel(parent), log(log) {
+  // The writer thread announces new entries; a queued call hands them to
+  // the UI thread. The log is destroyed before the model (see ~Calculator),
+  // so no call arrives after it.
+  log.setListener([this] {
+    QMetaObject::invokeMethod(this, &HistoryModel::sync,
+                              Qt::QueuedConnection);
+  });
+  shown = log.size();
+}
+
+int HistoryModel::rowCount(const QModelIndex &parent) const {
+  if (parent.isValid()) {
+    return 0;
+  }
+  return clampRows(isFiltered() ? matches.size() : shown);
+}
+
+QVariant HistoryModel::data(const QModelIndex &index, int role) const {
+  if (!index.isValid() || index.row() >= rowCount()) {
+    return {};
+  }
+  switch (role) {
+  case Qt::DisplayRole: {
+    const calc::HistoryEntry entry = entryAt(index.row());
+    return toQString(entry.expression) + " = " + toQString(entry.result);
+  }
+  case Qt::ToolTipRole:
+    return toQString(entryAt(index.row()).expression);
+  default:
+    return {};
+  }
+}
+
+void HistoryModel::setFilter(const QString &needle) {
+  beginResetModel();
+  filter = needle.toStdString();
+  shown = log.size();
+  matches.clear();
+  if (isFiltered()) {
+    matches = log.search(filter);
+  }
+  endResetModel();
+  emit changed();
+}
+
+calc::HistoryEntry HistoryModel::entryAt(int row) const {
+  const auto i = static_cast<std::size_t>(row);
+  return log.entry(isFiltered() ? matches[i] : shown - 1 - i);
+}
+
+void HistoryModel::sync() {
+  const std::size_t size = log.size();
+  if (size == shown) {
+    emit changed(); // Loading may have finished without adding entries
+    return;
+  }
+  if (isFiltered()) {
+    // A search costs the entries its rarest trigram lists, not the whole
+    // log, so the new matches are simplest found by searching again
+    setFilter(QString::fromStdString(filter));
+    return;
+  }
+  // Newest first, so the new entries go above the ones already shown
+  beginInsertRows({}, 0, clampRows(size - shown) - 1);
+  shown = size;
+  endInsertRows();
+  emit changed();
+}
+
+HistoryPanel::HistoryPanel(calc::HistoryLog &log, QWidget *parent)
+    : QWidget(parent), log(log) {
+  auto *layout = new QVBoxLayout(this);
+  layout->setContentsMargins(0, 8, 8, 8);
+  layout->setSpacing(4);
+
+  search = new QLineEdit;
+  search->setObjectName("historySearch");
+  search->setPlaceholderText(tr("Search history"));
+  search->setClearButtonEnabled(true);
+  layout->addWidget(search);
+  setFocusProxy(search);
+
+  // Uniform row heights let the view skip measuring the rows it is not
+  // showing, which a long history has millions of
+  model = new HistoryModel(log, this);
+  list = new QListView;
+  list->setObjectName("history");
+  list->setModel(model);
+  list->setUniformItemSizes(true);
+  list->setWordWrap(false);
+  list->setTextElideMode(Qt::ElideLeft);
+  layout->addWidget(list, 1);
+
+  status = new QLabel;
+  status->setObjectName("historyStatus");
+  layout->addWidget(status);
+
+  connect(search, &QLineEdit::textChanged, model, &HistoryModel::setFilter);
+  connect(model, &HistoryModel::changed, this, &HistoryPanel::updateStatus);
+  connect(list, &QListView::activated, this, [this](const QModelIndex &index) {
+    emit resultChosen(toQString(model->entryAt(index.row()).result));
+  });
+  updateStatus();
+}
+
+void HistoryPanel::updateStatus() {
+  if (!log.isLoaded()) {
+    status->setText(tr("Loading history…"));
+  } else if (model->isFiltered()) {
+    status->setText(tr("%1 matches").arg(model->rowCount()));
+  } else {
+    status->setText(tr("%1 entries").arg(model->rowCount()));
+  }
+}
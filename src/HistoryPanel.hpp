@@ -0,0 +1,64 @@
+#pragma once
+#include "engine/HistoryLog.hpp"
+#include <QtCore/QAbstractListModel>
+#include <QtWidgets/QLabel>
+#include <QtWidgets/QLineEdit>
+#include <QtWidgets/QListView>
+#include <QtWidgets/QWidget>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// A HistoryLog newest first, one "expression = result" row per entry, or
+// only the entries matching a filter. Rows are read from the log as a view
+// shows them; entries the writer thread indexes are inserted at the top.
+class HistoryModel : public QAbstractListModel {
+  Q_OBJECT
+
+public:
+  explicit HistoryModel(calc::HistoryLog &log, QObject *parent = nullptr);
+
+  int rowCount(const QModelIndex &parent = {}) const override;
+  QVariant data(const QModelIndex &index, int role) const override;
+
+  // Shows only entries containing `needle`; an empty one shows them all
+  void setFilter(const QString &needle);
+  bool isFiltered() const { return !filter.empty(); }
+
+  // The log entry a row shows
+  calc::HistoryEntry entryAt(int row) const;
+
+signals:
+  void changed();
+
+private:
+  calc::HistoryLog &log;
+  std::size_t shown = 0; // Entries announced to views so far, oldest first
+  std::string filter;
+  std::vector<std::size_t> matches; // Entry numbers, newest first
+
+  // Catches up with the entries indexed since the last call; runs on the
+  // UI thread
+  void sync();
+};
+
+// The history beside the keypad: a search line, the entries newest first
+// and a count. Activating an entry types its result into the keypad.
+class HistoryPanel : public QWidget {
+  Q_OBJECT
+
+public:
+  explicit HistoryPanel(calc::HistoryLog &log, QWidget *parent = nullptr);
+
+signals:
+  void resultChosen(const QString &result);
+
+private:
+  calc::HistoryLog &log;
+  HistoryModel *model;
+  QLineEdit *search;
+  QListView *list;
+  QLabel *status;
+
+  void updateStatus();
+};
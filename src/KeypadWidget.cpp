@@ -0,0 +1,223 @@
+#include "KeypadWidget.hpp"
+#include <QtGui/QMouseEvent>
+#include <QtGui/QPaintEvent>
+#include <QtGui/QPainter>
+
+namespace {
+
+// Same geometry the QPushButton grid had: 38px round keys, 6px apart,
+// centred in their cells
+constexpr int kKeySize = 38;
+constexpr int kSpacing = 6;
+constexpr int kColumns = 4;
+constexpr int kRows = 5;
+
+QColor rgba(int red, int green, int blue, double alpha) {
+  return QColor(red, green, blue, qRound(alpha * 255));
+}
+
+QString symbolOf(calc::Action action) {
+  const std::string_view key = calc::keyOf(action);
+  return QString::fromUtf8(key.data(), static_cast<qsizetype>(key.size()));
+}
+
+} // namespace
+
+KeypadWidget::KeypadWidget(std::vector<Key> keys, QWidget *parent)
+    : QWidget(parent), keys(std::move(keys)), rects(this->keys.size()) {
+  setMouseTracking(true); // For hover highlights
+  setFocusPolicy(Qt::NoFocus);
+}
+
+void KeypadWidget::setIconFont(const QFont &font) {
+  iconFont = font;
+  glyphCache.clear();
+  update();
+}
+
+QSize KeypadWidget::sizeHint() const {
+  return {kColumns * kKeySize + (kColumns - 1) * kSpacing,
+          kRows * kKeySize + (kRows - 1) * kSpacing};
+}
+
+// Colours match the stylesheet the buttons used to have
+KeypadWidget::KeyStyle KeypadWidget::styleFor(Kind kind, bool hover,
+                                              bool down) {
+  switch (kind) {
+  case Kind::Number:
+#ifdef Q_OS_LINUX
+    if (down)
+      return {rgba(129, 129, 135, 1.0), rgba(70, 70, 75, 1.0)};
+    if (hover)
+      return {rgba(115, 115, 120, 1.0), rgba(130, 130, 135, 0.9)};
+    return {rgba(90, 90, 95, 0.95), rgba(110, 110, 115, 0.8)};
+#else
+    if (down)
+      return {rgba(129, 129, 132, 0.95), rgba(70, 70, 70, 1.0)};
+    if (hover)
+      return {rgba(115, 115, 115, 0.9), QColor()};
+    return {rgba(81, 81, 83, 0.85), QColor()};
+#endif
+  case Kind::Function:
+#ifdef Q_OS_LINUX
+    if (down)
+      return {rgba(142, 142, 147, 1.0), rgba(130, 130, 135, 1.0)};
+    if (hover)
+      return {rgba(160, 160, 165, 1.0), rgba(180, 180, 185, 0.9)};
+    return {rgba(120, 120, 125, 0.95), rgba(140, 140, 145, 0.8)};
+#else
+    if (down)
+      return {rgba(142, 142, 144, 0.95), rgba(130, 130, 130, 1.0)};
+    if (hover)
+      return {rgba(180, 180, 180, 0.9), QColor()};
+    return {rgba(111, 112, 115, 0.85), QColor()};
+#endif
+  case Kind::Operator:
+    break;
+  }
+  if (down)
+    return {rgba(230, 133, 14, 1.0), rgba(200, 110, 0, 1.0)};
+  if (hover)
+    return {rgba(255, 165, 30, 0.95), QColor()};
+  return {rgba(255, 149, 0, 0.9), QColor()};
+}
+
+QFont KeypadWidget::textFont(Kind kind) {
+  QFont font;
+  font.setPixelSize(kind == Kind::Function ? 17 : 18);
+  font.setWeight(kind == Kind::Number ? QFont::Normal : QFont::Medium);
+  return font;
+}
+
+void KeypadWidget::paintEvent(QPaintEvent *event) {
+  QPainter painter(this);
+  painter.setRenderHint(QPainter::Antialiasing);
+  for (std::size_t i = 0; i < keys.size(); ++i) {
+    const QRect &rect = rects[i];
+    if (!event->rect().intersects(rect)) {
+      continue;
+    }
+    const Key &key = keys[i];
+    const int index = static_cast<int>(i);
+    const KeyStyle style =
+        styleFor(key.kind, index == hovered, index == pressed && pressedInside);
+
+    if (style.border.isValid()) {
+      painter.setPen(QPen(style.border, 1));
+    } else {
+      painter.setPen(Qt::NoPen);
+    }
+    painter.setBrush(style.background);
+    painter.drawEllipse(QRectF(rect).adjusted(0.5, 0.5, -0.5, -0.5));
+
+    if (key.icon && !iconFont.family().isEmpty()) {
+      painter.drawPixmap(rect.topLeft(), glyph(key));
+    } else {
+      painter.setFont(textFont(key.kind));
+      painter.setPen(Qt::white);
+      painter.drawText(rect, Qt::AlignCenter,
+                       key.icon ? symbolOf(key.action) : key.label);
+    }
+  }
+}
+
+const QPixmap &KeypadWidget::glyph(const Key &key) {
+  const qreal ratio = devicePixelRatioF();
+  QFont font = iconFont;
+  font.setPixelSize(textFont(key.kind).pixelSize());
+  const QString cacheKey = QStringLiteral("%1/%2/%3")
+                               .arg(key.label)
+                               .arg(font.pixelSize())
+                               .arg(ratio);
+  auto found = glyphCache.find(cacheKey);
+  if (found == glyphCache.end()) {
+    const QSize size(kKeySize, kKeySize);
+    QPixmap pixmap(size * ratio);
+    pixmap.setDevicePixelRatio(ratio);
+    pixmap.fill(Qt::transparent);
+    QPainter painter(&pixmap);
+    painter.setRenderHint(QPainter::TextAntialiasing);
+    painter.setFont(font);
+    painter.setPen(Qt::white);
+    painter.drawText(QRect(QPoint(), size), Qt::AlignCenter, key.label);
+    painter.end();
+    found = glyphCache.insert(cacheKey, pixmap);
+  }
+  return *found;
+}
+
+void KeypadWidget::resizeEvent(QResizeEvent *event) {
+  QWidget::resizeEvent(event);
+  // Extra space is shared out between the cells like QGridLayout does
+  const int cellWidth = (width() - (kColumns - 1) * kSpacing) / kColumns;
+  const int cellHeight = (height() - (kRows - 1) * kSpacing) / kRows;
+  for (std::size_t i = 0; i < keys.size(); ++i) {
+    const int x = keys[i].column * (cellWidth + kSpacing);
+    const int y = keys[i].row * (cellHeight + kSpacing);
+    rects[i] = QRect(x + (cellWidth - kKeySize) / 2,
+                     y + (cellHeight - kKeySize) / 2, kKeySize, kKeySize);
+  }
+}
+
+int KeypadWidget::keyAt(const QPoint &position) const {
+  for (std::size_t i = 0; i < rects.size(); ++i) {
+    if (rects[i].contains(position)) {
+      return static_cast<int>(i);
+    }
+  }
+  return -1;
+}
+
+void KeypadWidget::updateKey(int index) {
+  if (index != -1) {
+    update(rects[static_cast<std::size_t>(index)]);
+  }
+}
+
+void KeypadWidget::setHovered(int index) {
+  if (index != hovered) {
+    updateKey(hovered);
+    hovered = index;
+    updateKey(hovered);
+  }
+}
+
+void KeypadWidget::mousePressEvent(QMouseEvent *event) {
+  if (event->button() != Qt::LeftButton) {
+    QWidget::mousePressEvent(event);
+    return;
+  }
+  pressed = keyAt(event->position().toPoint());
+  pressedInside = pressed != -1;
+  updateKey(pressed);
+}
+
+void KeypadWidget::mouseMoveEvent(QMouseEvent *event) {
+  const int index = keyAt(event->position().toPoint());
+  setHovered(index);
+  // Like a button, a held key only looks pressed while the cursor is on it
+  if (pressed != -1 && (index == pressed) != pressedInside) {
+    pressedInside = index == pressed;
+    updateKey(pressed);
+  }
+}
+
+void KeypadWidget::mouseReleaseEvent(QMouseEvent *event) {
+  if (event->button() != Qt::LeftButton || pressed == -1) {
+    QWidget::mouseReleaseEvent(event);
+    return;
+  }
+  const int index = pressed;
+  const bool inside = keyAt(event->position().toPoint()) == index;
+  pressed = -1;
+  pressedInside = false;
+  updateKey(index);
+  if (inside) {
+    emit actionTriggered(keys[static_cast<std::size_t>(index)].action);
+  }
+}
+
+void KeypadWidget::leaveEvent(QEvent *event) {
+  setHovered(-1);
+  QWidget::leaveEvent(event);
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include "engine/Action.hpp"
+#include <QtCore/QHash>
+#include <QtCore/QRect>
+#include <QtGui/QColor>
+#include <QtGui/QFont>
+#include <QtGui/QPixmap>
+#include <QtWidgets/QWidget>
+#include <vector>
+
+// The whole keypad as one widget: every key is painted in a single
+// paintEvent and hit-tested here, instead of twenty stylesheet-driven
+// QPushButtons each with its own QStyleSheetStyle repaint. Only the keys
+// whose hover or pressed state changes are repainted.
+class KeypadWidget : public QWidget {
+  Q_OBJECT
+
+public:
+  enum class Kind { Number, Function, Operator };
+
+  struct Key {
+    calc::Action action;
+    QString label; // Font Awesome glyph when `icon` is set
+    bool icon;
+    int row;
+    int column;
+    Kind kind;
+  };
+
+  explicit KeypadWidget(std::vector<Key> keys, QWidget *parent = nullptr);
+
+  // Icon keys show their action's plain symbol until this font is set
+  void setIconFont(const QFont &font);
+
+  QSize sizeHint() const override;
+
+signals:
+  void actionTriggered(calc::Action action);
+
+protected:
+  void paintEvent(QPaintEvent *event) override;
+  void resizeEvent(QResizeEvent *event) override;
+  void mousePressEvent(QMouseEvent *event) override;
+  void mouseMoveEvent(QMouseEvent *event) override;
+  void mouseReleaseEvent(QMouseEvent *event) override;
+  void leaveEvent(QEvent *event) override;
+
+private:
+  // Colours of one key kind in one state
+  struct KeyStyle {
+    QColor background;
+    QColor border; // Invalid for no border
+  };
+
+  std::vector<Key> keys;
+  std::vector<QRect> rects; // Parallel to `keys`
+  QFont iconFont;
+  QHash<QString, QPixmap> glyphCache; // Icon glyphs by label, size and DPR
+  int hovered = -1;
+  int pressed = -1;
+  bool pressedInside = false;
+
+  static KeyStyle styleFor(Kind kind, bool hover, bool down);
+  static QFont textFont(Kind kind);
+
+  int keyAt(const QPoint &position) const;
+  void updateKey(int index);
+  void setHovered(int index);
+  const QPixmap &glyph(const Key &key);
+};
@@ -0,0 +1,139 @@
+#include "PasteWindow.hpp"
+#include <QtCore/QMetaObject>
+#include <QtGui/QClipboard>
+#include <QtGui/QGuiApplication>
+#include <QtWidgets/QHBoxLayout>
+#include <QtWidgets/QHeaderView>
+#include <QtWidgets/QTableView>
+#include <QtWidgets/QVBoxLayout>
+#include <algorithm>
+#include <climits>
+
+namespace {
+
+int clampRows(std::size_t rows) {
+  return static_cast<int>(std::min<std::size_t>(rows, INT_MAX));
+}
+
+QString toQString(std::string_view text) {
+  return QString::fromUtf8(text.data(), static_cast<qsizetype>(text.size()));
+}
+
+} // namespace
+
+PasteResultsModel::PasteResultsModel(std::string text,
+                                     calc::NumericBackend backend,
+                                     QObject *parent)
+    : QAbstractTableModel(parent) {
+  // Progress arrives on the background thread; a queued call hands it to
+  // the UI thread, and calls still queued when the model is destroyed are
+  // dropped with it
+  bulk = std::make_unique<calc::BulkEvaluation>(
+      std::move(text), backend, [this] {
+        QMetaObject::invokeMethod(this, &PasteResultsModel::sync,
+                                  Qt::QueuedConnection);
+      });
+}
+
+int PasteResultsModel::rowCount(const QModelIndex &parent) const {
+  return parent.isValid() ? 0 : shown;
+}
+
+int PasteResultsModel::columnCount(const QModelIndex &parent) const {
+  return parent.isValid() ? 0 : 2;
+}
+
+QVariant PasteResultsModel::data(const QModelIndex &index, int role) const {
+  if (!index.isValid() || index.row() >= shown) {
+    return {};
+  }
+  const auto row = static_cast<std::size_t>(index.row());
+  switch (role) {
+  case Qt::DisplayRole:
+    return toQString(index.column() == 0 ? bulk->expression(row)
+                                         : bulk->result(row));
+  case Qt::TextAlignmentRole:
+    return static_cast<int>(Qt::AlignVCenter |
+                            (index.column() == 0 ? Qt::AlignLeft
+                                                 : Qt::AlignRight));
+  default:
+    return {};
+  }
+}
+
+QVariant PasteResultsModel::headerData(int section, Qt::Orientation orientation,
+                                       int role) const {
+  if (role != Qt::DisplayRole) {
+    return {};
+  }
+  if (orientation == Qt::Vertical) {
+    return section + 1; // Spreadsheet row numbers
+  }
+  return section == 0 ? tr("Expression") : tr("Result");
+}
+
+void PasteResultsModel::sync() {
+  const int ready = clampRows(bulk->ready());
+  if (ready > shown) {
+    beginInsertRows({}, shown, ready - 1);
+    shown = ready;
+    endInsertRows();
+  }
+  emit progressed();
+}
+
+PasteWindow::PasteWindow(std::string text, calc::NumericBackend backend,
+                         QWidget *parent)
+    : QWidget(parent, Qt::Window) {
+  setAttribute(Qt::WA_DeleteOnClose);
+  setWindowTitle(tr("Pasted rows"));
+  resize(360, 480);
+
+  model = new PasteResultsModel(std::move(text), backend, this);
+
+  auto *layout = new QVBoxLayout(this);
+  layout->setContentsMargins(8, 8, 8, 8);
+  layout->setSpacing(4);
+
+  // The view only asks for the rows it shows. Fixed row heights keep it
+  // from measuring the other 100k as they are inserted or scrolled past.
+  auto *view = new QTableView;
+  view->setModel(model);
+  view->setWordWrap(false);
+  view->setSelectionBehavior(QAbstractItemView::SelectRows);
+  view->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+  view->verticalHeader()->setDefaultSectionSize(view->fontMetrics().height() +
+                                                6);
+  view->horizontalHeader()->setSectionResizeMode(QHeaderView::Stretch);
+  layout->addWidget(view);
+
+  auto *footer = new QHBoxLayout;
+  status = new QLabel;
+  copyButton = new QPushButton(tr("Copy results"));
+  copyButton->setEnabled(false);
+  footer->addWidget(status, 1);
+  footer->addWidget(copyButton);
+  layout->addLayout(footer);
+
+  connect(model, &PasteResultsModel::progressed, this,
+          &PasteWindow::updateStatus);
+  connect(copyButton, &QPushButton::clicked, this, [this] {
+    QGuiApplication::clipboard()->setText(
+        QString::fromStdString(model->evaluation().results()));
+  });
+  updateStatus();
+}
+
+void PasteWindow::updateStatus() {
+  const calc::BulkEvaluation &bulk = model->evaluation();
+  if (bulk.finished()) {
+    status->setText(
+        tr("%1 rows, %2 errors").arg(bulk.ready()).arg(bulk.errors()));
+    copyButton->setEnabled(true);
+  } else if (bulk.rows() == 0) {
+    status->setText(tr("Reading rows…"));
+  } else {
+    status->setText(
+        tr("%1 of %2 rows").arg(bulk.ready()).arg(bulk.rows()));
+  }
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include "engine/BulkEvaluation.hpp"
+#include <QtCore/QAbstractTableModel>
+#include <QtWidgets/QLabel>
+#include <QtWidgets/QPushButton>
+#include <QtWidgets/QWidget>
+#include <memory>
+#include <string>
+
+// The rows of a BulkEvaluation as a two-column table, expression and
+// result. Rows are inserted as the background thread publishes them, so a
+// view shows the first results while the rest are still being evaluated.
+class PasteResultsModel : public QAbstractTableModel {
+  Q_OBJECT
+
+public:
+  PasteResultsModel(std::string text, calc::NumericBackend backend,
+                    QObject *parent = nullptr);
+
+  int rowCount(const QModelIndex &parent = {}) const override;
+  int columnCount(const QModelIndex &parent = {}) const override;
+  QVariant data(const QModelIndex &index, int role) const override;
+  QVariant headerData(int section, Qt::Orientation orientation,
+                      int role) const override;
+
+  const calc::BulkEvaluation &evaluation() const { return *bulk; }
+
+signals:
+  void progressed();
+
+private:
+  int shown = 0; // Rows announced to views so far
+  std::unique_ptr<calc::BulkEvaluation> bulk;
+
+  // Inserts the rows published since the last call; runs on the UI thread
+  void sync();
+};
+
+// Separate window for a pasted block of rows: the results table, a status
+// line and a button that copies the results back to the clipboard
+class PasteWindow : public QWidget {
+  Q_OBJECT
+
+public:
+  PasteWindow(std::string text, calc::NumericBackend backend,
+              QWidget *parent = nullptr);
+
+private:
+  PasteResultsModel *model;
+  QLabel *status;
+  QPushButton *copyButton;
+
+  void updateStatus();
+};
@@ -0,0 +1,369 @@
+#include "PlotWidget.hpp"
+#include <QtCore/QMetaObject>
+#include <QtGui/QMouseEvent>
+#include <QtGui/QWheelEvent>
+#include <QtWidgets/QVBoxLayout>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+constexpr double kBasePixel = 1.0 / 32.0; // Level 0: 32 pixels per unit
+constexpr int kLevelsPerOctave = 4;
+// Pixels from 2^-40 to 2^40 units, so tile indices stay far from overflow
+constexpr int kMinLevel = -40 * kLevelsPerOctave;
+constexpr int kMaxLevel = 40 * kLevelsPerOctave;
+constexpr int kStandInLevels = kLevelsPerOctave; // Up to twice as coarse
+constexpr int kCachedTiles = 64; // 256 KB each
+constexpr double kGridSpacing = 48.0; // Least pixels between grid lines
+
+const QColor kBackground(36, 36, 44);
+const QColor kGridColor(255, 255, 255, 20);
+const QColor kAxisColor(255, 255, 255, 90);
+const QColor kLabelColor(255, 255, 255, 130);
+constexpr std::uint32_t kCurveColor = 0xFFE6850E; // The operator keys'
+
+} // namespace
+
+PlotWidget::PlotWidget(QWidget *parent) : QWidget(parent) {
+  tiles.setMaxCost(kCachedTiles);
+  setAttribute(Qt::WA_OpaquePaintEvent); // Every pixel is painted
+  setCursor(Qt::OpenHandCursor);
+  QFont labels = font();
+  labels.setPixelSize(10);
+  setFont(labels);
+}
+
+PlotWidget::~PlotWidget() {
+  // Queued tasks skip their tile, and the pool waits for running ones
+  // while the members they touch still exist
+  ++generation;
+  pool.reset();
+}
+
+void PlotWidget::setProgram(std::shared_ptr<const calc::Program> next) {
+  program = std::move(next);
+  ++generation;
+  tiles.clear();
+  pending.clear();
+  if (program && !pool) {
+    pool = std::make_unique<calc::ThreadPool>();
+  }
+  update();
+}
+
+void PlotWidget::resetView() {
+  level = 0;
+  centerX = 0.0;
+  centerY = 0.0;
+  update();
+}
+
+double PlotWidget::pixelSize(int level) {
+  return kBasePixel *
+         std::exp2(static_cast<double>(level) / kLevelsPerOctave);
+}
+
+calc::PlotArea PlotWidget::areaOf(const TileKey &key) const {
+  const double span = calc::kTileSize * pixelSize(key.level);
+  return {static_cast<double>(key.x) * span,
+          -static_cast<double>(key.y) * span, pixelSize(key.level)};
+}
+
+QPointF PlotWidget::origin() const {
+  const double pixel = pixelSize(level);
+  return {width() / 2.0 - centerX / pixel, height() / 2.0 + centerY / pixel};
+}
+
+void PlotWidget::clampCenter() {
+  const double limit = std::exp2(50.0) * pixelSize(level);
+  centerX = std::clamp(centerX, -limit, limit);
+  centerY = std::clamp(centerY, -limit, limit);
+}
+
+void PlotWidget::paintEvent(QPaintEvent *) {
+  QPainter painter(this);
+  painter.fillRect(rect(), kBackground);
+  const QPointF at = origin();
+  drawGrid(painter, at);
+  if (!program) {
+    return;
+  }
+
+  // Tiles sit at whole pixels: the origin's floor plus a multiple of the
+  // tile size, so neighbours always meet without a seam
+  const auto corner = [](double origin, qint64 index) {
+    const auto offset = static_cast<double>(index * calc::kTileSize);
+    return static_cast<int>(std::floor(origin + offset));
+  };
+  const auto firstTile = [](double origin) {
+    return static_cast<qint64>(std::floor(-origin / calc::kTileSize));
+  };
+  const auto lastTile = [](double origin, int extent) {
+    return static_cast<qint64>(std::floor((extent - 1 - origin) /
+                                          calc::kTileSize));
+  };
+  std::vector<TileKey> missing;
+  for (qint64 y = firstTile(at.y()); y <= lastTile(at.y(), height()); ++y) {
+    for (qint64 x = firstTile(at.x()); x <= lastTile(at.x(), width()); ++x) {
+      const TileKey key{level, x, y};
+      if (const QImage *image = tiles.object(key)) {
+        painter.drawImage(QPoint(corner(at.x(), x), corner(at.y(), y)),
+                          *image);
+      } else {
+        drawStandIn(painter, key, at);
+        missing.push_back(key);
+      }
+    }
+  }
+  requestTiles(std::move(missing));
+}
+
+void PlotWidget::drawGrid(QPainter &painter, QPointF at) const {
+  const double pixel = pixelSize(level);
+  // The smallest 1, 2 or 5 × 10^n units at least kGridSpacing apart
+  const double least = kGridSpacing * pixel;
+  double step = std::pow(10.0, std::floor(std::log10(least)));
+  for (const double factor : {1.0, 2.0, 5.0, 10.0}) {
+    if (step * factor >= least) {
+      step *= factor;
+      break;
+    }
+  }
+  const double left = -at.x() * pixel;
+  const double right = (width() - at.x()) * pixel;
+  const double bottom = (at.y() - height()) * pixel;
+  const double top = at.y() * pixel;
+
+  // Labels follow the axes, and stay at the edges once an axis scrolls
+  // out of view
+  const double labelY = std::clamp(at.y() + 12.0, 12.0, height() - 3.0);
+  const double labelX = std::clamp(at.x() + 3.0, 3.0, width() - 40.0);
+  for (double k = std::ceil(left / step); k * step <= right; ++k) {
+    const double x = at.x() + k * step / pixel;
+    painter.setPen(k == 0.0 ? kAxisColor : kGridColor);
+    painter.drawLine(QLineF(x, 0.0, x, height()));
+    if (k != 0.0) {
+      painter.setPen(kLabelColor);
+      painter.drawText(QPointF(x + 3.0, labelY),
+                       QString::number(k * step, 'g', 6));
+    }
+  }
+  for (double k = std::ceil(bottom / step); k * step <= top; ++k) {
+    const double y = at.y() - k * step / pixel;
+    painter.setPen(k == 0.0 ? kAxisColor : kGridColor);
+    painter.drawLine(QLineF(0.0, y, width(), y));
+    if (k != 0.0) {
+      painter.setPen(kLabelColor);
+      painter.drawText(QPointF(labelX, y - 3.0),
+                       QString::number(k * step, 'g', 6));
+    }
+  }
+}
+
+void PlotWidget::drawStandIn(QPainter &painter, const TileKey &key,
+                             QPointF at) {
+  const double pixel = pixelSize(key.level);
+  const double span = calc::kTileSize * pixel;
+  // The tile in world units, y downwards like the tile indices
+  const double left = static_cast<double>(key.x) * span;
+  const double top = static_cast<double>(key.y) * span;
+  const QRectF square(at.x() + left / pixel, at.y() + top / pixel,
+                      calc::kTileSize, calc::kTileSize);
+
+  // The nearest levels first, coarser before finer at each distance
+  for (int distance = 1; distance <= kStandInLevels; ++distance) {
+    for (const int other : {key.level + distance, key.level - distance}) {
+      if (other < kMinLevel || other > kMaxLevel) {
+        continue;
+      }
+      const double otherSpan = calc::kTileSize * pixelSize(other);
+      const double size = otherSpan / pixel; // On screen
+      const auto first = [otherSpan](double from) {
+        return static_cast<qint64>(std::floor(from / otherSpan));
+      };
+      const auto last = [otherSpan](double to) {
+        return static_cast<qint64>(std::ceil(to / otherSpan)) - 1;
+      };
+      bool drawn = false;
+      painter.save();
+      painter.setClipRect(square);
+      for (qint64 y = first(top); y <= last(top + span); ++y) {
+        for (qint64 x = first(left); x <= last(left + span); ++x) {
+          if (const QImage *image = tiles.object({other, x, y})) {
+            const QRectF target(at.x() + static_cast<double>(x) * size,
+                                at.y() + static_cast<double>(y) * size,
+                                size, size);
+            painter.drawImage(target, *image);
+            drawn = true;
+          }
+        }
+      }
+      painter.restore();
+      if (drawn) {
+        return;
+      }
+    }
+  }
+}
+
+void PlotWidget::requestTiles(std::vector<TileKey> missing) {
+  const QPointF middle(width() / 2.0, height() / 2.0);
+  const QPointF at = origin();
+  const auto distance = [&](const TileKey &key) {
+    const QPointF centre(
+        at.x() + (static_cast<double>(key.x) + 0.5) * calc::kTileSize,
+        at.y() + (static_cast<double>(key.y) + 0.5) * calc::kTileSize);
+    return (centre - middle).manhattanLength();
+  };
+  std::sort(missing.begin(), missing.end(),
+            [&](const TileKey &a, const TileKey &b) {
+              return distance(a) < distance(b);
+            });
+
+  const qsizetype limit = 2 * static_cast<qsizetype>(pool->size());
+  for (const TileKey &key : missing) {
+    if (pending.size() >= limit) {
+      break;
+    }
+    if (pending.contains(key)) {
+      continue;
+    }
+    pending.insert(key);
+    const quint64 expected = generation.load();
+    pool->submit([this, key, expected, area = areaOf(key),
+                  plotted = program] {
+      if (generation.load() != expected) {
+        return; // Another program replaced this one while queued
+      }
+      QImage image(calc::kTileSize, calc::kTileSize,
+                   QImage::Format_ARGB32_Premultiplied);
+      thread_local std::vector<calc::CurvePoint> points;
+      calc::sampleCurve(*plotted, area, points);
+      calc::renderCurve(points, area, kCurveColor,
+                        reinterpret_cast<std::uint32_t *>(image.bits()),
+                        static_cast<std::size_t>(image.bytesPerLine()) / 4);
+      // Calls still queued when the widget is destroyed are dropped
+      QMetaObject::invokeMethod(
+          this,
+          [this, key, expected, image] { tileReady(key, expected, image); },
+          Qt::QueuedConnection);
+    });
+  }
+}
+
+void PlotWidget::tileReady(TileKey key, quint64 forGeneration,
+                           const QImage &image) {
+  if (forGeneration != generation.load()) {
+    return; // `pending` was cleared with the old program
+  }
+  pending.remove(key);
+  tiles.insert(key, new QImage(image));
+  update(); // Which also queues the next missing tiles
+}
+
+void PlotWidget::mousePressEvent(QMouseEvent *event) {
+  if (event->button() != Qt::LeftButton) {
+    QWidget::mousePressEvent(event);
+    return;
+  }
+  dragging = true;
+  dragFrom = event->position();
+  setCursor(Qt::ClosedHandCursor);
+}
+
+void PlotWidget::mouseMoveEvent(QMouseEvent *event) {
+  if (!dragging) {
+    QWidget::mouseMoveEvent(event);
+    return;
+  }
+  // Moving by whole tiles costs nothing; only the exposed edge renders
+  const QPointF delta = event->position() - dragFrom;
+  dragFrom = event->position();
+  const double pixel = pixelSize(level);
+  centerX -= delta.x() * pixel;
+  centerY += delta.y() * pixel;
+  clampCenter();
+  update();
+}
+
+void PlotWidget::mouseReleaseEvent(QMouseEvent *event) {
+  if (event->button() != Qt::LeftButton || !dragging) {
+    QWidget::mouseReleaseEvent(event);
+    return;
+  }
+  dragging = false;
+  setCursor(Qt::OpenHandCursor);
+}
+
+void PlotWidget::mouseDoubleClickEvent(QMouseEvent *) { resetView(); }
+
+void PlotWidget::wheelEvent(QWheelEvent *event) {
+  // Touchpads scroll in fractions of a notch; a level per whole notch
+  wheelAngle += event->angleDelta().y();
+  const int steps = wheelAngle / 120;
+  wheelAngle -= steps * 120;
+  if (steps == 0) {
+    return;
+  }
+  // The point under the pointer stays under it
+  const QPointF offset =
+      event->position() - QPointF(width() / 2.0, height() / 2.0);
+  const double before = pixelSize(level);
+  const double x = centerX + offset.x() * before;
+  const double y = centerY - offset.y() * before;
+  level = std::clamp(level - steps, kMinLevel, kMaxLevel);
+  const double after = pixelSize(level);
+  centerX = x - offset.x() * after;
+  centerY = y + offset.y() * after;
+  clampCenter();
+  update();
+}
+
+PlotPanel::PlotPanel(QWidget *parent) : QWidget(parent) {
+  auto *layout = new QVBoxLayout(this);
+  layout->setContentsMargins(0, 8, 8, 8);
+  layout->setSpacing(4);
+
+  expression = new QLineEdit;
+  expression->setObjectName("plot");
+  expression->setPlaceholderText(tr("f(x), e.g. 1 / (x - 1)"));
+  layout->addWidget(expression);
+  setFocusProxy(expression);
+
+  plot = new PlotWidget;
+  layout->addWidget(plot, 1);
+
+  status = new QLabel;
+  status->setObjectName("plotStatus");
+  layout->addWidget(status);
+
+  connect(expression, &QLineEdit::textChanged, this,
+          &PlotPanel::compileExpression);
+}
+
+void PlotPanel::setExpression(const QString &text) {
+  expression->setText(text);
+}
+
+void PlotPanel::compileExpression() {
+  const std::string source = expression->text().trimmed().toStdString();
+  if (source.empty()) {
+    status->clear();
+    plot->setProgram(nullptr);
+    return;
+  }
+  // While an expression is half typed the last complete one stays plotted
+  calc::CompileError error;
+  std::optional<calc::Program> program = calc::compile(source, &error);
+  if (!program) {
+    status->setText(QString::fromStdString(error.message));
+    return;
+  }
+  if (program->variables.size() > 1) {
+    status->setText(tr("Plot needs an expression in one variable"));
+    return;
+  }
+  status->clear();
+  plot->setProgram(std::make_shared<const calc::Program>(std::move(*program)));
+}
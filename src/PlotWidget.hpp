@@ -0,0 +1,108 @@
+#pragma once
+#include "engine/Plot.hpp"
+#include "engine/ThreadPool.hpp"
+#include <QtCore/QCache>
+#include <QtCore/QHashFunctions>
+#include <QtCore/QSet>
+#include <QtGui/QImage>
+#include <QtGui/QPainter>
+#include <QtWidgets/QLabel>
+#include <QtWidgets/QLineEdit>
+#include <QtWidgets/QWidget>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+// Graph of a program in one variable, assembled from square tiles. Each
+// tile is sampled and drawn once on a worker thread and cached as a
+// QImage, so a pan renders only the tiles it exposes and a repaint is a
+// few image copies, which the raster engine does at full frame rate
+// without a GPU. Zoom steps through levels a quarter octave apart; while
+// a level's tiles are rendering, tiles of nearby levels are scaled into
+// their place.
+class PlotWidget : public QWidget {
+  Q_OBJECT
+
+public:
+  explicit PlotWidget(QWidget *parent = nullptr);
+  ~PlotWidget() override;
+
+  // Plots `next`, which has at most one variable; nullptr clears the
+  // plot. The view is kept, so editing an expression does not lose it.
+  void setProgram(std::shared_ptr<const calc::Program> next);
+
+  // Back to the origin at the default scale (also on double click)
+  void resetView();
+
+protected:
+  void paintEvent(QPaintEvent *event) override;
+  void mousePressEvent(QMouseEvent *event) override;
+  void mouseMoveEvent(QMouseEvent *event) override;
+  void mouseReleaseEvent(QMouseEvent *event) override;
+  void mouseDoubleClickEvent(QMouseEvent *event) override;
+  void wheelEvent(QWheelEvent *event) override;
+
+private:
+  // Tile `x`, `y` of zoom `level`; tile (0, 0) has the origin at its top
+  // left corner and y grows downwards, as on screen
+  struct TileKey {
+    int level;
+    qint64 x;
+    qint64 y;
+
+    bool operator==(const TileKey &) const = default;
+    friend size_t qHash(const TileKey &key, size_t seed = 0) {
+      return qHashMulti(seed, key.level, key.x, key.y);
+    }
+  };
+
+  std::shared_ptr<const calc::Program> program;
+  std::unique_ptr<calc::ThreadPool> pool; // Started by the first plot
+  QCache<TileKey, QImage> tiles;          // Least recently drawn go first
+  QSet<TileKey> pending;                  // Queued or rendering
+  // Bumped with every program, so tiles of the previous one are dropped;
+  // atomic because queued tasks check it before starting
+  std::atomic<quint64> generation{0};
+
+  // Zoom: world units per pixel double every 4 levels
+  int level = 0;
+  // World point at the centre of the widget
+  double centerX = 0.0;
+  double centerY = 0.0;
+  QPointF dragFrom;
+  bool dragging = false;
+  int wheelAngle = 0; // Eighths of a degree not yet zoomed by
+
+  static double pixelSize(int level);
+  calc::PlotArea areaOf(const TileKey &key) const;
+  // Screen position of the world origin at the current level
+  QPointF origin() const;
+  void clampCenter();
+
+  void drawGrid(QPainter &painter, QPointF origin) const;
+  // Fills a missing tile's square from cached tiles of the nearest level
+  // that has any
+  void drawStandIn(QPainter &painter, const TileKey &key, QPointF origin);
+  // Queues the missing tiles nearest the centre first, a few at a time, so
+  // tiles scrolled past before their turn are never rendered
+  void requestTiles(std::vector<TileKey> missing);
+  void tileReady(TileKey key, quint64 forGeneration, const QImage &image);
+};
+
+// The plot beside the keypad: a line for the expression, f(x) in any one
+// variable, the graph below it and a line for compile errors
+class PlotPanel : public QWidget {
+  Q_OBJECT
+
+public:
+  explicit PlotPanel(QWidget *parent = nullptr);
+
+  void setExpression(const QString &text);
+
+private:
+  QLineEdit *expression;
+  PlotWidget *plot;
+  QLabel *status;
+
+  void compileExpression();
+};
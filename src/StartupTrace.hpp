@@ -0,0 +1,50 @@
+#pragma once
+#include <chrono>
+#include <cstdio>
+
+// Startup timing, enabled with --startup-trace. main() starts the clock,
+// each phase calls mark() when it ends, and the first painted frame prints
+// the timeline to stderr.
+class StartupTrace {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  static void start(bool enable) {
+    enabled() = enable;
+    origin() = previous() = Clock::now();
+  }
+
+  static void mark(const char *phase) {
+    if (!enabled()) {
+      return;
+    }
+    const auto now = Clock::now();
+    std::fprintf(stderr, "startup: %-22s %8.2f ms (+%.2f ms)\n", phase,
+                 milliseconds(now - origin()),
+                 milliseconds(now - previous()));
+    previous() = now;
+  }
+
+  // Marks time-to-first-frame once; later calls do nothing
+  static void firstFrame() {
+    mark("first frame");
+    enabled() = false;
+  }
+
+private:
+  static bool &enabled() {
+    static bool value = false;
+    return value;
+  }
+  static Clock::time_point &origin() {
+    static Clock::time_point value;
+    return value;
+  }
+  static Clock::time_point &previous() {
+    static Clock::time_point value;
+    return value;
+  }
+  static double milliseconds(Clock::duration duration) {
+    return std::chrono::duration<double, std::milli>(duration).count();
+  }
+};
@@ -0,0 +1,121 @@
+#pragma once
+#include <QtCore/QString>
+
+// The whole window's stylesheet, set once on Calculator so Qt parses a
+// single sheet instead of one per widget. The keypad paints itself (see
+// KeypadWidget), as does the plot, so only the window, the two displays,
+// the plot panel's expression line and the history panel are styled here.
+inline QString calculatorStyleSheet() {
+#ifdef Q_OS_LINUX
+  return QStringLiteral(R"(
+      QMainWindow {
+          background: rgb(45, 45, 55);
+          border-radius: 8px;
+          border: 1px solid rgba(70, 70, 70, 0.8);
+      }
+      QLabel#preview {
+          background: transparent;
+          color: rgba(255, 255, 255, 0.7);
+          font-size: 14px;
+          font-weight: 300;
+          padding: 4px 16px 0px 16px;
+          margin: 0px;
+      }
+      QLineEdit#display {
+          background: rgba(60, 60, 70, 0.95);
+          color: white;
+          font-size: 32px;
+          font-weight: 500;
+          border-radius: 8px;
+          border: 1px solid rgba(80, 80, 90, 0.8);
+          padding: 12px 4px;
+          margin: 0px;
+      }
+      QLineEdit#plot {
+          background: rgba(60, 60, 70, 0.95);
+          color: white;
+          font-size: 14px;
+          border-radius: 6px;
+          border: 1px solid rgba(80, 80, 90, 0.8);
+          padding: 4px 6px;
+      }
+      QLabel#plotStatus {
+          color: rgba(255, 160, 120, 0.9);
+          font-size: 11px;
+      }
+      QLineEdit#historySearch {
+          background: rgba(60, 60, 70, 0.95);
+          color: white;
+          font-size: 14px;
+          border-radius: 6px;
+          border: 1px solid rgba(80, 80, 90, 0.8);
+          padding: 4px 6px;
+      }
+      QListView#history {
+          background: rgba(60, 60, 70, 0.95);
+          color: white;
+          font-size: 13px;
+          border-radius: 6px;
+          border: 1px solid rgba(80, 80, 90, 0.8);
+          selection-background-color: rgba(255, 149, 0, 0.8);
+      }
+      QLabel#historyStatus {
+          color: rgba(255, 255, 255, 0.7);
+          font-size: 11px;
+      }
+  )");
+#else
+  return QStringLiteral(R"(
+      QMainWindow {
+          background: rgba(45, 45, 55, 0.85);
+          border-radius: 8px;
+      }
+      QLabel#preview {
+          background: transparent;
+          color: rgba(255, 255, 255, 0.7);
+          font-size: 14px;
+          font-weight: 300;
+          padding: 4px 16px 0px 16px;
+          margin: 0px;
+      }
+      QLineEdit#display {
+          background: rgba(42, 42, 53, 0.85);
+          color: white;
+          font-size: 32px;
+          font-weight: 500;
+          border-radius: 8px;
+          padding: 12px 4px;
+          margin: 0px;
+      }
+      QLineEdit#plot {
+          background: rgba(42, 42, 53, 0.85);
+          color: white;
+          font-size: 14px;
+          border-radius: 6px;
+          padding: 4px 6px;
+      }
+      QLabel#plotStatus {
+          color: rgba(255, 160, 120, 0.9);
+          font-size: 11px;
+      }
+      QLineEdit#historySearch {
+          background: rgba(42, 42, 53, 0.85);
+          color: white;
+          font-size: 14px;
+          border-radius: 6px;
+          padding: 4px 6px;
+      }
+      QListView#history {
+          background: rgba(42, 42, 53, 0.85);
+          color: white;
+          font-size: 13px;
+          border-radius: 6px;
+          selection-background-color: rgba(255, 149, 0, 0.8);
+      }
+      QLabel#historyStatus {
+          color: rgba(255, 255, 255, 0.7);
+          font-size: 11px;
+      }
+  )");
+#endif
+}
@@ -0,0 +1,103 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+namespace calc {
+
+// Every keypad button and keyboard command, in the order of kActionKeys.
+// Digit0..Digit9 are contiguous so digits convert with arithmetic.
+enum class Action : std::uint8_t {
+  Digit0,
+  Digit1,
+  Digit2,
+  Digit3,
+  Digit4,
+  Digit5,
+  Digit6,
+  Digit7,
+  Digit8,
+  Digit9,
+  DecimalPoint,
+  Negate,
+  AllClear,
+  Percent,
+  Clear,
+  ClearEntry,
+  Backspace,
+  Equals,
+  Add,
+  Subtract,
+  Multiply,
+  Divide,
+  Undo, // Keyboard only, like everything after Divide
+  Redo,
+};
+
+inline constexpr std::size_t kActionCount =
+    static_cast<std::size_t>(Action::Redo) + 1;
+
+// Key text of each action, indexed by Action
+inline constexpr std::array<std::string_view, kActionCount> kActionKeys = {
+    "0", "1", "2", "3",  "4", "5", "6", "7", "8", "9", ".",   "±",
+    "AC", "%", "C", "CE", "←", "=", "+", "-", "×", "÷", "↶", "↷"};
+
+constexpr std::string_view keyOf(Action action) {
+  return kActionKeys[static_cast<std::size_t>(action)];
+}
+
+// Looks up the action for a key text; meant for resolving a button once
+// when it is created, not on every press
+constexpr std::optional<Action> parseAction(std::string_view key) {
+  for (std::size_t i = 0; i < kActionCount; ++i) {
+    if (kActionKeys[i] == key) {
+      return static_cast<Action>(i);
+    }
+  }
+  return std::nullopt;
+}
+
+constexpr Action digitAction(int digit) {
+  return static_cast<Action>(static_cast<int>(Action::Digit0) + digit);
+}
+
+// Action for a typed character (digits, operators, '=' ...); keys without a
+// character such as Backspace and Escape are mapped by the UI
+constexpr std::optional<Action> actionForCharacter(char c) {
+  if (c >= '0' && c <= '9') {
+    return digitAction(c - '0');
+  }
+  switch (c) {
+  case '.':
+  case ',':
+    return Action::DecimalPoint;
+  case '%':
+    return Action::Percent;
+  case '=':
+  case '\n':
+  case '\r':
+    return Action::Equals;
+  case '+':
+    return Action::Add;
+  case '-':
+    return Action::Subtract;
+  case '*':
+  case 'x':
+  case 'X':
+    return Action::Multiply;
+  case '/':
+    return Action::Divide;
+  default:
+    return std::nullopt;
+  }
+}
+
+// kActionKeys must stay in enum order
+static_assert(keyOf(Action::Divide) == "÷");
+static_assert(keyOf(Action::Redo) == "↷");
+static_assert(parseAction("CE") == Action::ClearEntry);
+static_assert(actionForCharacter('7') == Action::Digit7);
+
+} // namespace calc
@@ -0,0 +1,42 @@
+#pragma once
+#include <cstddef>
+#include <memory_resource>
+
+namespace calc {
+
+namespace detail {
+
+// Separate base so the buffer exists before the resource that points at it
+template <std::size_t Bytes> struct ArenaBuffer {
+  alignas(std::max_align_t) std::byte bytes[Bytes];
+};
+
+} // namespace detail
+
+// Monotonic memory for the temporaries of one evaluation, used through
+// std::pmr containers:
+//
+//   Arena<512> arena;
+//   std::pmr::vector<std::uint32_t> limbs(size, &arena);
+//
+// The first `Bytes` come from a buffer inside the arena, so an arena that
+// is a local variable puts them on the stack; only what does not fit goes
+// to the heap. Nothing is freed piecemeal: everything is released at once
+// when the arena is destroyed or reset().
+template <std::size_t Bytes>
+class Arena : private detail::ArenaBuffer<Bytes>,
+              public std::pmr::monotonic_buffer_resource {
+public:
+  Arena()
+      : std::pmr::monotonic_buffer_resource(this->bytes, Bytes,
+                                            std::pmr::new_delete_resource()) {
+  }
+
+  Arena(const Arena &) = delete;
+  Arena &operator=(const Arena &) = delete;
+
+  // Frees everything at once; later allocations start over in the buffer
+  void reset() { release(); }
+};
+
+} // namespace calc
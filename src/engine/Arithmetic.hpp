@@ -0,0 +1,60 @@
+#pragma once
+#include <optional>
+#include <string_view>
+
+namespace calc {
+
+// Binary operators available on the keypad
+enum class Operator : unsigned char { None, Add, Subtract, Multiply, Divide };
+
+// Maps a keypad symbol ("+", "-", "×", "÷") to its operator
+constexpr Operator parseOperator(std::string_view symbol) {
+  if (symbol == "+")
+    return Operator::Add;
+  if (symbol == "-")
+    return Operator::Subtract;
+  if (symbol == "×")
+    return Operator::Multiply;
+  if (symbol == "÷")
+    return Operator::Divide;
+  return Operator::None;
+}
+
+constexpr std::string_view symbolOf(Operator op) {
+  switch (op) {
+  case Operator::Add:
+    return "+";
+  case Operator::Subtract:
+    return "-";
+  case Operator::Multiply:
+    return "×";
+  case Operator::Divide:
+    return "÷";
+  case Operator::None:
+    break;
+  }
+  return "";
+}
+
+// Applies `op` to both operands. Division by zero yields std::nullopt, which
+// the keypad shows as "Error"; Operator::None leaves `lhs` untouched.
+constexpr std::optional<double> apply(Operator op, double lhs, double rhs) {
+  switch (op) {
+  case Operator::Add:
+    return lhs + rhs;
+  case Operator::Subtract:
+    return lhs - rhs;
+  case Operator::Multiply:
+    return lhs * rhs;
+  case Operator::Divide:
+    if (rhs == 0.0) {
+      return std::nullopt;
+    }
+    return lhs / rhs;
+  case Operator::None:
+    break;
+  }
+  return lhs;
+}
+
+} // namespace calc
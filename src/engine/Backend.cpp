@@ -0,0 +1,34 @@
+#include "engine/Backend.hpp"
+#include "engine/Decimal.hpp"
+#include "engine/Format.hpp"
+
+namespace calc {
+
+std::optional<std::string> evaluateToText(const Program &program,
+                                          NumericBackend backend) {
+  std::string text;
+  if (!appendResult(text, program, backend)) {
+    return std::nullopt;
+  }
+  return text;
+}
+
+bool appendResult(std::string &out, const Program &program,
+                  NumericBackend backend) {
+  if (backend == NumericBackend::Decimal) {
+    const auto value = evaluateDecimal(program);
+    if (!value) {
+      return false;
+    }
+    value->appendTo(out);
+    return true;
+  }
+  const auto value = evaluate(program);
+  if (!value) {
+    return false;
+  }
+  appendNumber(out, *value);
+  return true;
+}
+
+} // namespace calc
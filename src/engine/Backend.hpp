@@ -0,0 +1,25 @@
+#pragma once
+#include "engine/Expression.hpp"
+#include <cstdint>
+#include <optional>
+#include <string>
+
+namespace calc {
+
+// Number types the evaluator can run on
+enum class NumericBackend : std::uint8_t {
+  Double,  // IEEE double, results shown with up to 10 significant digits
+  Decimal, // Exact decimal (see Decimal), results shown with every digit
+};
+
+// Evaluates `program` with `backend` and formats the result the way the
+// keypad displays it. std::nullopt stands for "Error".
+std::optional<std::string> evaluateToText(const Program &program,
+                                          NumericBackend backend);
+
+// Same as evaluateToText() but appends the text to `out`; returns false and
+// leaves `out` untouched on error
+bool appendResult(std::string &out, const Program &program,
+                  NumericBackend backend);
+
+} // namespace calc
@@ -0,0 +1,789 @@
+#include "engine/Batch.hpp"
+#include "engine/Columnar.hpp"
+#include "engine/Decimal.hpp"
+#include "engine/Expression.hpp"
+#include "engine/Format.hpp"
+#include "engine/Jit.hpp"
+#include "engine/MappedFile.hpp"
+#include "engine/ResultCache.hpp"
+#include "engine/ThreadPool.hpp"
+#include "engine/Units.hpp"
+#include <algorithm>
+#include <charconv>
+#include <climits>
+#include <cerrno>
+#include <cmath>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace calc {
+
+OutputStream::OutputStream(std::FILE *stream, std::size_t capacity)
+    : stream(stream), buffer(capacity) {}
+
+OutputStream::~OutputStream() { flush(); }
+
+void OutputStream::write(std::string_view text) {
+  if (text.size() > buffer.size() - used) {
+    flush();
+    if (text.size() > buffer.size()) {
+      failed |= std::fwrite(text.data(), 1, text.size(), stream) != text.size();
+      return;
+    }
+  }
+  std::memcpy(buffer.data() + used, text.data(), text.size());
+  used += text.size();
+}
+
+void OutputStream::put(char c) {
+  if (used == buffer.size()) {
+    flush();
+  }
+  buffer[used++] = c;
+}
+
+bool OutputStream::flush() {
+  if (used > 0) {
+    failed |= std::fwrite(buffer.data(), 1, used, stream) != used;
+    used = 0;
+  }
+  failed |= std::fflush(stream) != 0;
+  return !failed;
+}
+
+namespace {
+
+bool isBlank(std::string_view line) {
+  return line.find_first_not_of(" \t\r") == std::string_view::npos;
+}
+
+// Calls evaluate(line) for every complete line in `input`, and for a
+// trailing line without '\n' when `final` is set. Returns the number of
+// bytes consumed.
+template <typename Evaluate>
+std::size_t forEachLine(std::string_view input, bool final,
+                        Evaluate &&evaluate) {
+  std::size_t consumed = 0;
+  while (consumed < input.size()) {
+    const void *newline = std::memchr(input.data() + consumed, '\n',
+                                      input.size() - consumed);
+    if (!newline) {
+      if (final) {
+        evaluate(input.substr(consumed));
+        consumed = input.size();
+      }
+      break;
+    }
+    const auto end =
+        static_cast<std::size_t>(static_cast<const char *>(newline) -
+                                 input.data());
+    evaluate(input.substr(consumed, end - consumed));
+    consumed = end + 1;
+  }
+  return consumed;
+}
+
+// Adds one `--stats` result. Overflow to infinity and NaN would poison
+// every statistic, so non-finite results are counted as errors instead.
+void addResult(BatchStats &stats, double value) {
+  if (std::isfinite(value)) {
+    stats.values.add(value);
+  } else {
+    ++stats.errors;
+  }
+}
+
+} // namespace
+
+void evaluateLine(std::string_view line, std::string &out, BatchStats &stats,
+                  NumericBackend backend, ResultCache *cache,
+                  const UnitTable *units) {
+  ++stats.lines;
+  if (!line.empty() && line.back() == '\r') {
+    line.remove_suffix(1);
+  }
+  if (isBlank(line)) {
+    out += '\n';
+    return;
+  }
+
+  // Reused across lines so cache lookups and compiling do not allocate
+  thread_local std::string key;
+  thread_local CachedResult cached;
+  thread_local Program program;
+  if (cache) {
+    normalizeExpression(line, key);
+    if (cache->find(key, cached)) {
+      stats.errors += cached.failed;
+      out += cached.text;
+      out += '\n';
+      return;
+    }
+  }
+
+  const std::size_t start = out.size();
+  const bool failed =
+      !compile(line, program, nullptr, units) ||
+      !appendResult(out, program, backend);
+  if (failed) {
+    ++stats.errors;
+    out += "Error";
+  }
+  if (cache) {
+    cached.text.assign(out, start);
+    cached.failed = failed;
+    cache->insert(key, cached);
+  }
+  out += '\n';
+}
+
+std::size_t evaluateLines(std::string_view input, bool final, std::string &out,
+                          BatchStats &stats, NumericBackend backend,
+                          ResultCache *cache, const UnitTable *units) {
+  return forEachLine(input, final, [&](std::string_view line) {
+    evaluateLine(line, out, stats, backend, cache, units);
+  });
+}
+
+void summarizeLine(std::string_view line, BatchStats &stats,
+                   NumericBackend backend, const UnitTable *units) {
+  ++stats.lines;
+  if (isBlank(line)) {
+    return;
+  }
+  thread_local Program program;
+  std::optional<double> value;
+  if (compile(line, program, nullptr, units)) {
+    if (backend == NumericBackend::Decimal) {
+      if (const auto exact = evaluateDecimal(program)) {
+        value = exact->toDouble();
+      }
+    } else {
+      value = evaluate(program);
+    }
+  }
+  if (value) {
+    addResult(stats, *value);
+  } else {
+    ++stats.errors;
+  }
+}
+
+std::size_t summarizeLines(std::string_view input, bool final,
+                           BatchStats &stats, NumericBackend backend,
+                           const UnitTable *units) {
+  return forEachLine(input, final, [&](std::string_view line) {
+    summarizeLine(line, stats, backend, units);
+  });
+}
+
+namespace {
+
+// Rows gathered per columnar evaluation in --formula mode
+constexpr std::size_t kFormulaRows = 1024;
+
+enum class RowKind : std::uint8_t { Values, Blank, Malformed };
+
+bool isFieldSeparator(char c) {
+  return c == ',' || c == ';' || c == ' ' || c == '\t' || c == '\r';
+}
+
+// Splits one row into `width` operand fields, handing each to
+// store(index, text), which returns false for a field it cannot parse
+template <typename Store>
+RowKind parseRow(std::string_view line, std::size_t width, Store &&store) {
+  if (line.find_first_not_of(" \t\r") == std::string_view::npos) {
+    return RowKind::Blank;
+  }
+  std::size_t pos = 0;
+  std::size_t field = 0;
+  for (;;) {
+    while (pos < line.size() && isFieldSeparator(line[pos])) {
+      ++pos;
+    }
+    if (pos == line.size()) {
+      break;
+    }
+    if (field == width) {
+      return RowKind::Malformed;
+    }
+    std::size_t end = pos;
+    while (end < line.size() && !isFieldSeparator(line[end])) {
+      ++end;
+    }
+    if (!store(field, line.substr(pos, end - pos))) {
+      return RowKind::Malformed;
+    }
+    ++field;
+    pos = end;
+  }
+  return field == width ? RowKind::Values : RowKind::Malformed;
+}
+
+bool parseField(std::string_view text, double &value) {
+  if (text.front() == '+') {
+    text.remove_prefix(1);
+  }
+  const auto [end, ec] =
+      std::from_chars(text.data(), text.data() + text.size(), value);
+  return ec == std::errc() && end == text.data() + text.size();
+}
+
+// Exact decimal rows are evaluated one at a time on the interpreter
+template <typename Sink>
+std::size_t forEachDecimalFormulaRow(const Program &program,
+                                     std::string_view input, bool final,
+                                     BatchStats &stats, Sink &&sink) {
+  std::vector<Decimal> row(program.variables.size());
+  std::size_t consumed = 0;
+  while (consumed < input.size()) {
+    std::size_t end = input.find('\n', consumed);
+    std::size_t next = end + 1;
+    if (end == std::string_view::npos) {
+      if (!final) {
+        break;
+      }
+      end = next = input.size();
+    }
+    const auto kind = parseRow(
+        input.substr(consumed, end - consumed), row.size(),
+        [&row](std::size_t field, std::string_view text) {
+          auto value = Decimal::parse(text);
+          if (value) {
+            row[field] = std::move(*value);
+          }
+          return value.has_value();
+        });
+    const auto value = kind == RowKind::Values
+                           ? evaluateDecimal(program, row)
+                           : std::nullopt;
+    sink(kind, value ? &*value : nullptr);
+    ++stats.lines;
+    consumed = next;
+  }
+  return consumed;
+}
+
+// Parses rows of operands and hands every row's kind and result (nullptr
+// for an error) to sink(kind, value), where value points at a double or,
+// for the Decimal backend, a Decimal
+template <typename Sink>
+std::size_t forEachFormulaRow(HotProgram &formula, std::string_view input,
+                              bool final, BatchStats &stats,
+                              NumericBackend backend, Sink &&sink) {
+  const Program &program = formula.program();
+  if (backend == NumericBackend::Decimal) {
+    return forEachDecimalFormulaRow(program, input, final, stats, sink);
+  }
+
+  const std::size_t width = program.variables.size();
+  std::vector<double> columns(width * kFormulaRows);
+  std::vector<const double *> operands(width);
+  for (std::size_t i = 0; i < width; ++i) {
+    operands[i] = columns.data() + i * kFormulaRows;
+  }
+  std::vector<double> values(kFormulaRows);
+  std::vector<std::uint8_t> errors(kFormulaRows);
+  std::vector<RowKind> kinds(kFormulaRows);
+
+  std::size_t consumed = 0;
+  for (;;) {
+    std::size_t rows = 0;
+    while (rows < kFormulaRows && consumed < input.size()) {
+      std::size_t end = input.find('\n', consumed);
+      std::size_t next = end + 1;
+      if (end == std::string_view::npos) {
+        if (!final) {
+          break;
+        }
+        end = next = input.size();
+      }
+      kinds[rows] = parseRow(
+          input.substr(consumed, end - consumed), width,
+          [&columns, rows](std::size_t field, std::string_view text) {
+            return parseField(text, columns[field * kFormulaRows + rows]);
+          });
+      ++rows;
+      consumed = next;
+    }
+    if (rows == 0) {
+      return consumed;
+    }
+
+    formula.evaluateColumns(operands, rows, values.data(), errors.data());
+    for (std::size_t row = 0; row < rows; ++row) {
+      const bool valid = kinds[row] == RowKind::Values && !errors[row];
+      sink(kinds[row], valid ? &values[row] : nullptr);
+    }
+    stats.lines += rows;
+  }
+}
+
+void appendValue(std::string &out, double value) { appendNumber(out, value); }
+void appendValue(std::string &out, const Decimal &value) {
+  value.appendTo(out);
+}
+
+double toDouble(double value) { return value; }
+double toDouble(const Decimal &value) { return value.toDouble(); }
+
+} // namespace
+
+std::size_t evaluateFormulaLines(HotProgram &formula, std::string_view input,
+                                 bool final, std::string &out,
+                                 BatchStats &stats, NumericBackend backend) {
+  return forEachFormulaRow(
+      formula, input, final, stats, backend,
+      [&out, &stats](RowKind kind, const auto *value) {
+        if (value) {
+          appendValue(out, *value);
+        } else if (kind != RowKind::Blank) {
+          ++stats.errors;
+          out += "Error";
+        }
+        out += '\n';
+      });
+}
+
+std::size_t summarizeFormulaLines(HotProgram &formula, std::string_view input,
+                                  bool final, BatchStats &stats,
+                                  NumericBackend backend) {
+  return forEachFormulaRow(formula, input, final, stats, backend,
+                           [&stats](RowKind kind, const auto *value) {
+                             if (value) {
+                               addResult(stats, toDouble(*value));
+                             } else if (kind != RowKind::Blank) {
+                               ++stats.errors;
+                             }
+                           });
+}
+
+namespace {
+
+constexpr std::size_t kReadChunk = 1 << 20;
+// Input handed to one parallel task; large enough to amortize scheduling
+constexpr std::size_t kTaskChunk = 256 << 10;
+// Chunks in flight per worker while results are written in order
+constexpr std::size_t kChunksPerWorker = 4;
+
+struct Chunk {
+  std::string_view input;
+  bool final = false;
+  std::string output;
+  BatchStats stats;
+  bool done = false;
+};
+
+// Splits `input` into pieces of roughly kTaskChunk bytes that end on a
+// newline. Without `final`, a trailing partial line is not included.
+std::vector<Chunk> splitChunks(std::string_view input, bool final) {
+  std::vector<Chunk> chunks;
+  std::size_t begin = 0;
+  while (begin < input.size()) {
+    std::size_t end = std::min(begin + kTaskChunk, input.size());
+    if (end < input.size()) {
+      const auto newline = input.find('\n', end - 1);
+      end = newline == std::string_view::npos ? input.size() : newline + 1;
+    }
+    if (end == input.size() && input.back() != '\n') {
+      const auto lastNewline = input.rfind('\n', end - 1);
+      if (!final) {
+        // Leave the unfinished line to the caller
+        if (lastNewline == std::string_view::npos || lastNewline < begin) {
+          break;
+        }
+        end = lastNewline + 1;
+      }
+    }
+    Chunk &chunk = chunks.emplace_back();
+    chunk.input = input.substr(begin, end - begin);
+    chunk.final = final;
+    begin = end;
+  }
+  return chunks;
+}
+
+} // namespace
+
+std::size_t evaluateLinesParallel(std::string_view input, bool final,
+                                  OutputStream &out, BatchStats &stats,
+                                  ThreadPool &pool,
+                                  const LineEvaluator &evaluate) {
+  std::vector<Chunk> chunks = splitChunks(input, final);
+  std::mutex mutex;
+  std::condition_variable chunkDone;
+
+  const auto schedule = [&](std::size_t index) {
+    pool.submit([&, index] {
+      Chunk &chunk = chunks[index];
+      chunk.output.reserve(chunk.input.size());
+      evaluate(chunk.input, chunk.final, chunk.output, chunk.stats);
+      // Notify under the lock: the waiter may return and destroy the
+      // condition variable as soon as it can observe `done`
+      const std::lock_guard lock(mutex);
+      chunk.done = true;
+      chunkDone.notify_all();
+    });
+  };
+
+  const std::size_t window = kChunksPerWorker * pool.size();
+  for (std::size_t i = 0; i < std::min(window, chunks.size()); ++i) {
+    schedule(i);
+  }
+
+  std::size_t consumed = 0;
+  for (std::size_t i = 0; i < chunks.size(); ++i) {
+    Chunk &chunk = chunks[i];
+    {
+      std::unique_lock lock(mutex);
+      chunkDone.wait(lock, [&chunk] { return chunk.done; });
+    }
+    out.write(chunk.output);
+    std::string().swap(chunk.output);
+    stats += chunk.stats;
+    chunk.stats = {}; // Frees the chunk's t-digest before the next merges
+    consumed += chunk.input.size();
+    if (i + window < chunks.size()) {
+      schedule(i + window);
+    }
+  }
+  return consumed;
+}
+
+namespace {
+
+void evaluateStream(std::FILE *stream, OutputStream &out, BatchStats &stats,
+                    ThreadPool *pool, const LineEvaluator &evaluate) {
+  // Parallel runs read enough per call to give every worker a full window
+  const std::size_t readSize =
+      pool ? kTaskChunk * kChunksPerWorker * pool->size() : kReadChunk;
+  std::vector<char> buffer(readSize);
+  std::string results;
+  std::size_t pending = 0; // Bytes of an unfinished line kept from last read
+  for (;;) {
+    if (buffer.size() - pending < readSize / 2) {
+      buffer.resize(buffer.size() * 2); // A single line outgrew the buffer
+    }
+    const std::size_t read = std::fread(buffer.data() + pending, 1,
+                                        buffer.size() - pending, stream);
+    const bool final = read == 0;
+    const std::size_t available = pending + read;
+    const std::string_view input(buffer.data(), available);
+
+    std::size_t consumed = 0;
+    if (pool) {
+      consumed =
+          evaluateLinesParallel(input, final, out, stats, *pool, evaluate);
+    } else {
+      consumed = evaluate(input, final, results, stats);
+      out.write(results);
+      results.clear();
+    }
+    pending = available - consumed;
+    if (final) {
+      return;
+    }
+    std::memmove(buffer.data(), buffer.data() + consumed, pending);
+  }
+}
+
+void evaluateMapped(std::string_view input, OutputStream &out,
+                    BatchStats &stats, ThreadPool *pool,
+                    const LineEvaluator &evaluate) {
+  if (pool) {
+    evaluateLinesParallel(input, true, out, stats, *pool, evaluate);
+    return;
+  }
+  std::string results;
+  while (!input.empty()) {
+    const std::size_t consumed =
+        evaluate(input.substr(0, kReadChunk), false, results, stats);
+    if (consumed == 0) {
+      // A line longer than the chunk: take everything up to its end
+      evaluate(input, true, results, stats);
+      input = {};
+    } else {
+      input.remove_prefix(consumed);
+    }
+    out.write(results);
+    results.clear();
+  }
+}
+
+void printUsage(std::FILE *stream) {
+  std::fputs("Usage: Calculator --batch [--jobs N] [--formula EXPR] "
+             "[--no-jit] [--decimal] [--cache N] [--stats] [--units FILE] "
+             "[FILE...]\n"
+             "Evaluates one expression per line and prints one result per "
+             "line.\n"
+             "Reads standard input when no FILE (or \"-\") is given.\n"
+             "  -j, --jobs N          Worker threads (default: one per "
+             "core)\n"
+             "  -f, --formula EXPR    Evaluate EXPR for every line, which "
+             "lists the values of\n"
+             "                        EXPR's variables in order of first use "
+             "(e.g. \"a × b + c\"\n"
+             "                        reads lines like \"2, 3, 4\")\n"
+             "      --no-jit          Interpret the formula instead of "
+             "compiling it to native\n"
+             "                        code once it has run enough rows\n"
+             "      --decimal         Exact decimal arithmetic instead of "
+             "double\n"
+             "      --cache N         Remember the results of up to N distinct "
+             "expressions\n"
+             "                        (not used with --formula or --stats)\n"
+             "      --stats           Print the count, sum, mean, variance, "
+             "extremes and\n"
+             "                        percentiles of the results instead of "
+             "the results\n"
+             "                        (infinite and NaN results count as "
+             "errors; percentiles\n"
+             "                        are estimates beyond about 100 "
+             "results)\n"
+             "      --units FILE      Allow the units FILE defines in "
+             "expressions and\n"
+             "                        formulas, as in \"5 km + 300 m to mi\"\n",
+             stream);
+}
+
+void printSummary(OutputStream &out, const BatchStats &stats) {
+  const Statistics &values = stats.values;
+  std::string text;
+  const auto line = [&text](std::string_view name, double value) {
+    text += name;
+    text.append(10 - name.size(), ' ');
+    appendNumber(text, value);
+    text += '\n';
+  };
+  line("count", static_cast<double>(values.count()));
+  line("errors", static_cast<double>(stats.errors));
+  line("sum", values.sum());
+  line("mean", values.mean());
+  line("variance", values.variance());
+  line("stddev", values.standardDeviation());
+  line("min", values.minimum());
+  line("max", values.maximum());
+  line("p50", values.percentile(50.0));
+  line("p90", values.percentile(90.0));
+  line("p99", values.percentile(99.0));
+  line("p99.9", values.percentile(99.9));
+  out.write(text);
+}
+
+} // namespace
+
+std::optional<std::size_t> parseCount(std::string_view text) {
+  std::size_t value = 0;
+  const auto [end, ec] =
+      std::from_chars(text.data(), text.data() + text.size(), value);
+  if (ec != std::errc() || text.empty() || end != text.data() + text.size()) {
+    return std::nullopt;
+  }
+  return value;
+}
+
+int runBatch(int argc, char *argv[]) {
+  std::vector<std::string> files;
+  unsigned jobs = 0;
+  const char *formulaSource = nullptr;
+  std::unique_ptr<UnitFile> units;
+  bool jit = true;
+  NumericBackend backend = NumericBackend::Double;
+  std::size_t cacheEntries = 0;
+  bool summarize = false;
+  for (int i = 0; i < argc; ++i) {
+    const std::string_view arg = argv[i];
+    if (arg == "-h" || arg == "--help") {
+      printUsage(stdout);
+      return 0;
+    }
+    if (arg == "-j" || arg == "--jobs") {
+      if (i + 1 == argc) {
+        std::fprintf(stderr, "Calculator: %s needs a thread count\n", argv[i]);
+        return 2;
+      }
+      const std::optional<std::size_t> count = parseCount(argv[++i]);
+      if (!count || *count > UINT_MAX) {
+        std::fprintf(stderr, "Calculator: invalid thread count '%s'\n",
+                     argv[i]);
+        printUsage(stderr);
+        return 2;
+      }
+      jobs = static_cast<unsigned>(*count);
+      continue;
+    }
+    if (arg == "--decimal") {
+      backend = NumericBackend::Decimal;
+      continue;
+    }
+    if (arg == "--no-jit") {
+      jit = false;
+      continue;
+    }
+    if (arg == "--stats") {
+      summarize = true;
+      continue;
+    }
+    if (arg == "--cache") {
+      if (i + 1 == argc) {
+        std::fprintf(stderr, "Calculator: %s needs an entry count\n",
+                     argv[i]);
+        return 2;
+      }
+      const std::optional<std::size_t> count = parseCount(argv[++i]);
+      if (!count) {
+        std::fprintf(stderr, "Calculator: invalid entry count '%s'\n",
+                     argv[i]);
+        printUsage(stderr);
+        return 2;
+      }
+      cacheEntries = *count;
+      continue;
+    }
+    if (arg == "--units") {
+      if (i + 1 == argc) {
+        std::fprintf(stderr, "Calculator: %s needs a file\n", argv[i]);
+        return 2;
+      }
+      units = std::make_unique<UnitFile>(argv[++i]);
+      if (!units->isOpen()) {
+        std::fprintf(stderr, "Calculator: %s\n", units->error().c_str());
+        return 2;
+      }
+      continue;
+    }
+    if (arg == "-f" || arg == "--formula") {
+      if (i + 1 == argc) {
+        std::fprintf(stderr, "Calculator: %s needs an expression\n", argv[i]);
+        return 2;
+      }
+      formulaSource = argv[++i];
+      continue;
+    }
+    if (arg.size() > 1 && arg.front() == '-') {
+      std::fprintf(stderr, "Calculator: unknown batch option '%s'\n", argv[i]);
+      printUsage(stderr);
+      return 2;
+    }
+    files.emplace_back(arg);
+  }
+  if (files.empty()) {
+    files.emplace_back("-");
+  }
+
+  // The table is fixed for the whole run; batches do not hot-reload
+  const UnitTable *unitTable = units ? units->table().get() : nullptr;
+  std::optional<Program> formula;
+  if (formulaSource) {
+    CompileError error;
+    formula = compile(formulaSource, &error, unitTable);
+    if (!formula) {
+      std::fprintf(stderr, "Calculator: formula error at %zu: %s\n",
+                   error.position, error.message.c_str());
+      return 2;
+    }
+  }
+  if (jobs == 0) {
+    jobs = std::max(1U, std::thread::hardware_concurrency());
+  }
+
+  std::unique_ptr<ThreadPool> pool;
+  if (jobs > 1) {
+    pool = std::make_unique<ThreadPool>(jobs);
+  }
+
+  std::unique_ptr<ResultCache> cache;
+  if (cacheEntries > 0 && !formula && !summarize) {
+    cache = std::make_unique<ResultCache>(cacheEntries);
+  }
+
+  LineEvaluator evaluate = [backend, &cache, unitTable](
+                               std::string_view input, bool final,
+                               std::string &out, BatchStats &stats) {
+    return evaluateLines(input, final, out, stats, backend, cache.get(),
+                         unitTable);
+  };
+  std::unique_ptr<HotProgram> hotFormula;
+  if (formula) {
+    hotFormula = std::make_unique<HotProgram>(std::move(*formula), jit);
+    evaluate = [&hotFormula, backend](std::string_view input, bool final,
+                                      std::string &out, BatchStats &stats) {
+      return evaluateFormulaLines(*hotFormula, input, final, out, stats,
+                                  backend);
+    };
+  }
+  // --stats prints nothing per line; each chunk's statistics are merged
+  // into the total along with its counts
+  if (summarize) {
+    evaluate = [&hotFormula, backend, unitTable](std::string_view input,
+                                                 bool final, std::string &,
+                                                 BatchStats &stats) {
+      return hotFormula
+                 ? summarizeFormulaLines(*hotFormula, input, final, stats,
+                                         backend)
+                 : summarizeLines(input, final, stats, backend, unitTable);
+    };
+  }
+
+  OutputStream out(stdout);
+  BatchStats stats;
+  int status = 0;
+  for (const auto &file : files) {
+    if (file == "-") {
+      evaluateStream(stdin, out, stats, pool.get(), evaluate);
+      continue;
+    }
+    // Pipes, FIFOs and terminals, such as <(command), have no size to map
+    // and are streamed like standard input. Only stat() them here: opening a FIFO
+    // twice could drop what its writer sent in between.
+    std::error_code ignored;
+    const auto type = std::filesystem::status(file, ignored).type();
+    if (type == std::filesystem::file_type::fifo ||
+        type == std::filesystem::file_type::character) {
+      std::FILE *stream = std::fopen(file.c_str(), "rb");
+      if (!stream) {
+        std::fprintf(stderr, "Calculator: %s: %s\n", file.c_str(),
+                     std::strerror(errno));
+        status = 1;
+        continue;
+      }
+      evaluateStream(stream, out, stats, pool.get(), evaluate);
+      if (std::ferror(stream)) {
+        std::fprintf(stderr, "Calculator: failed to read %s\n", file.c_str());
+        status = 1;
+      }
+      std::fclose(stream);
+      continue;
+    }
+    const MappedFile input(file);
+    if (!input.isOpen()) {
+      std::fprintf(stderr, "Calculator: %s\n", input.error().c_str());
+      status = 1;
+      continue;
+    }
+    evaluateMapped(input.view(), out, stats, pool.get(), evaluate);
+  }
+  if (summarize) {
+    printSummary(out, stats);
+  }
+  if (!out.flush()) {
+    std::fprintf(stderr, "Calculator: failed to write results\n");
+    return 1;
+  }
+  if (cache) {
+    const CacheStats counters = cache->stats();
+    std::fprintf(stderr,
+                 "Calculator: cache %llu hits, %llu misses, %llu evictions\n",
+                 static_cast<unsigned long long>(counters.hits),
+                 static_cast<unsigned long long>(counters.misses),
+                 static_cast<unsigned long long>(counters.evictions));
+  }
+  return status;
+}
+
+} // namespace calc
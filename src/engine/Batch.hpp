@@ -0,0 +1,118 @@
+#pragma once
+#include "engine/Backend.hpp"
+#include "engine/Statistics.hpp"
+#include <cstddef>
+#include <cstdio>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace calc {
+
+// Buffered writer over a stdio stream; output is only handed to the C
+// library once the buffer fills up or flush() is called
+class OutputStream {
+public:
+  explicit OutputStream(std::FILE *stream, std::size_t capacity = 1 << 20);
+  ~OutputStream();
+
+  OutputStream(const OutputStream &) = delete;
+  OutputStream &operator=(const OutputStream &) = delete;
+
+  void write(std::string_view text);
+  void put(char c);
+  bool flush();
+
+private:
+  std::FILE *stream;
+  std::vector<char> buffer;
+  std::size_t used = 0;
+  bool failed = false;
+};
+
+struct BatchStats {
+  std::size_t lines = 0;
+  std::size_t errors = 0;
+  Statistics values; // Every result, filled by the summarize functions
+
+  BatchStats &operator+=(const BatchStats &other) {
+    lines += other.lines;
+    errors += other.errors;
+    values.merge(other.values);
+    return *this;
+  }
+};
+
+class HotProgram;
+class ResultCache;
+class ThreadPool;
+class UnitTable;
+
+// Evaluates one expression and appends its result (or "Error") followed by
+// a newline. Blank lines are echoed as blank lines so output stays aligned
+// with input. With a `cache`, repeated expressions skip compile and
+// evaluation; with `units`, expressions may use them (see compile()).
+void evaluateLine(std::string_view line, std::string &out, BatchStats &stats,
+                  NumericBackend backend = NumericBackend::Double,
+                  ResultCache *cache = nullptr,
+                  const UnitTable *units = nullptr);
+
+// Evaluates every complete line in `input`. Returns the number of bytes
+// consumed; a trailing line without '\n' is left for the caller unless
+// `final` is set.
+std::size_t evaluateLines(std::string_view input, bool final, std::string &out,
+                          BatchStats &stats,
+                          NumericBackend backend = NumericBackend::Double,
+                          ResultCache *cache = nullptr,
+                          const UnitTable *units = nullptr);
+
+// Columnar variant for `--formula`: every line supplies the values of
+// formula.program().variables (in order, separated by commas or
+// whitespace) and the compiled formula is evaluated over blocks of rows at
+// once, in native code once it is hot (row by row on the interpreter for
+// the Decimal backend)
+std::size_t evaluateFormulaLines(
+    HotProgram &formula, std::string_view input, bool final,
+    std::string &out, BatchStats &stats,
+    NumericBackend backend = NumericBackend::Double);
+
+// `--stats` counterparts of evaluateLines() and evaluateFormulaLines():
+// results are added to stats.values instead of being printed. Results that
+// overflow to infinity or are NaN count as errors, so the statistics are
+// always over finite values.
+void summarizeLine(std::string_view line, BatchStats &stats,
+                   NumericBackend backend = NumericBackend::Double,
+                   const UnitTable *units = nullptr);
+std::size_t summarizeLines(std::string_view input, bool final,
+                           BatchStats &stats,
+                           NumericBackend backend = NumericBackend::Double,
+                           const UnitTable *units = nullptr);
+std::size_t summarizeFormulaLines(
+    HotProgram &formula, std::string_view input, bool final,
+    BatchStats &stats, NumericBackend backend = NumericBackend::Double);
+
+// Signature of evaluateLines() / evaluateFormulaLines() with their other
+// arguments bound
+using LineEvaluator = std::function<std::size_t(
+    std::string_view input, bool final, std::string &out, BatchStats &stats)>;
+
+// Same as `evaluate`, but splits `input` into line-aligned chunks that are
+// evaluated on `pool` and written to `out` in input order
+std::size_t evaluateLinesParallel(std::string_view input, bool final,
+                                  OutputStream &out, BatchStats &stats,
+                                  ThreadPool &pool,
+                                  const LineEvaluator &evaluate);
+
+// A whole decimal count such as "8", as command-line options take them;
+// std::nullopt for anything else, including signs, blanks and overflow
+std::optional<std::size_t> parseCount(std::string_view text);
+
+// Entry point for `Calculator --batch [--jobs N] [--formula EXPR] [--no-jit]
+// [--decimal] [--cache N] [--stats] [--units FILE] [FILE...]`.
+// Regular files are memory-mapped; pipes and FIFOs are streamed, as is
+// standard input, which "-" or no file at all reads.
+int runBatch(int argc, char *argv[]);
+
+} // namespace calc
@@ -0,0 +1,97 @@
+#include "engine/BulkEvaluation.hpp"
+#include "engine/Batch.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace calc {
+
+BulkEvaluation::BulkEvaluation(std::string text, NumericBackend backend,
+                               Progress progress)
+    : text(std::move(text)), backend(backend), progress(std::move(progress)),
+      worker([this] { run(); }) {}
+
+BulkEvaluation::~BulkEvaluation() {
+  cancel();
+  worker.join();
+}
+
+std::string_view BulkEvaluation::line(std::size_t row) const {
+  // A missing final '\n' is treated as if it were at text.size()
+  const std::size_t start = lineStarts[row];
+  const std::size_t end = std::min(lineStarts[row + 1] - 1, text.size());
+  return std::string_view(text).substr(start, end - start);
+}
+
+std::string_view BulkEvaluation::expression(std::size_t row) const {
+  std::string_view source = line(row);
+  if (!source.empty() && source.back() == '\r') {
+    source.remove_suffix(1);
+  }
+  return source;
+}
+
+std::string_view BulkEvaluation::result(std::size_t row) const {
+  const Block &block = blocks[row / kBlockRows];
+  const std::size_t index = row % kBlockRows;
+  const std::size_t start = index == 0 ? 0 : block.ends[index - 1];
+  return std::string_view(block.results)
+      .substr(start, block.ends[index] - 1 - start);
+}
+
+std::string BulkEvaluation::results() const {
+  const std::size_t count =
+      (ready() + kBlockRows - 1) / kBlockRows; // Blocks are published whole
+  std::size_t size = 0;
+  for (std::size_t i = 0; i < count; ++i) {
+    size += blocks[i].results.size();
+  }
+  std::string out;
+  out.reserve(size);
+  for (std::size_t i = 0; i < count; ++i) {
+    out += blocks[i].results;
+  }
+  return out;
+}
+
+void BulkEvaluation::run() {
+  // Split first, so a view knows how many rows are coming
+  std::size_t start = 0;
+  while (start < text.size()) {
+    lineStarts.push_back(start);
+    const void *newline =
+        std::memchr(text.data() + start, '\n', text.size() - start);
+    start = newline ? static_cast<std::size_t>(
+                          static_cast<const char *>(newline) - text.data()) +
+                          1
+                    : text.size() + 1;
+  }
+  lineStarts.push_back(start);
+  const std::size_t total = lineStarts.size() - 1;
+  blocks.resize((total + kBlockRows - 1) / kBlockRows);
+  rowCount.store(total, std::memory_order_release);
+
+  for (std::size_t first = 0; first < total; first += kBlockRows) {
+    if (cancelled.load(std::memory_order_relaxed)) {
+      break;
+    }
+    const std::size_t last = std::min(first + kBlockRows, total);
+    Block &block = blocks[first / kBlockRows];
+    block.ends.reserve(last - first);
+    BatchStats stats;
+    for (std::size_t row = first; row < last; ++row) {
+      evaluateLine(line(row), block.results, stats, backend);
+      block.ends.push_back(static_cast<std::uint32_t>(block.results.size()));
+    }
+    errorCount.fetch_add(stats.errors, std::memory_order_relaxed);
+    readyCount.store(last, std::memory_order_release);
+    if (progress) {
+      progress();
+    }
+  }
+  done.store(true, std::memory_order_release);
+  if (progress) {
+    progress();
+  }
+}
+
+} // namespace calc
@@ -0,0 +1,89 @@
+#pragma once
+#include "engine/Backend.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace calc {
+
+// A block of expressions, one per line (such as a column pasted from a
+// spreadsheet), split and evaluated on a background thread. Results are
+// published kBlockRows at a time and never change afterwards, so another
+// thread can read every row below ready() while later rows are still being
+// evaluated.
+class BulkEvaluation {
+public:
+  static constexpr std::size_t kBlockRows = 4096;
+
+  // Called on the background thread after every published block, and once
+  // more when the evaluation has finished or was cancelled
+  using Progress = std::function<void()>;
+
+  BulkEvaluation(std::string text, NumericBackend backend,
+                 Progress progress = {});
+  // Cancels and waits for the background thread
+  ~BulkEvaluation();
+
+  BulkEvaluation(const BulkEvaluation &) = delete;
+  BulkEvaluation &operator=(const BulkEvaluation &) = delete;
+
+  // Lines in the text; 0 until the background thread has split it
+  std::size_t rows() const { return rowCount.load(std::memory_order_acquire); }
+
+  // Rows evaluated so far, always a prefix of the text
+  std::size_t ready() const {
+    return readyCount.load(std::memory_order_acquire);
+  }
+
+  // Rows that failed, counted as their blocks are published
+  std::size_t errors() const {
+    return errorCount.load(std::memory_order_relaxed);
+  }
+
+  bool finished() const { return done.load(std::memory_order_acquire); }
+
+  // Stops after the block being evaluated; ready() stays where it is
+  void cancel() { cancelled.store(true, std::memory_order_relaxed); }
+
+  // Both require row < ready(). A row that fails reads "Error", a blank
+  // one an empty result.
+  std::string_view expression(std::size_t row) const;
+  std::string_view result(std::size_t row) const;
+
+  // Results of the ready rows, one per line in input order, ready to be
+  // pasted back next to the original column
+  std::string results() const;
+
+private:
+  struct Block {
+    std::string results;             // Each row's result and a '\n'
+    std::vector<std::uint32_t> ends; // Offset past each row's '\n'
+  };
+
+  std::string text;
+  NumericBackend backend;
+  Progress progress;
+
+  // Written by the background thread before the release store of rowCount
+  // (lineStarts, the size of blocks) or of readyCount (a block's contents)
+  // that makes them visible
+  std::vector<std::size_t> lineStarts; // One past the end: after a '\n'
+  std::vector<Block> blocks;
+
+  std::atomic<std::size_t> rowCount{0};
+  std::atomic<std::size_t> readyCount{0};
+  std::atomic<std::size_t> errorCount{0};
+  std::atomic<bool> done{false};
+  std::atomic<bool> cancelled{false};
+  std::thread worker; // Last, so it starts after everything above
+
+  std::string_view line(std::size_t row) const;
+  void run();
+};
+
+} // namespace calc
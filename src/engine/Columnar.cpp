@@ -0,0 +1,410 @@
+#include "engine/Columnar.hpp"
+#include "engine/Statistics.hpp"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define CALC_X86_64 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define CALC_TARGET_AVX2
+#else
+#define CALC_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace calc {
+
+namespace {
+
+// Rows evaluated together; one stack slot holds a block of operands
+constexpr std::size_t kBlock = 256;
+
+// Element-wise operations on a block. Binary kernels write into `a`.
+struct Kernels {
+  void (*add)(double *a, const double *b, std::size_t n);
+  void (*subtract)(double *a, const double *b, std::size_t n);
+  void (*multiply)(double *a, const double *b, std::size_t n);
+  void (*divide)(double *a, const double *b, std::uint8_t *errors,
+                 std::size_t n);
+  void (*negate)(double *a, std::size_t n);
+  void (*percent)(double *a, std::size_t n);
+  // out = in × scale + shift, for unit conversions
+  void (*scale)(const double *in, double scale, double shift, double *out,
+                std::size_t n);
+};
+
+// Scalar kernels, also used for the tails of the vector kernels
+
+void addScalar(double *a, const double *b, std::size_t n) {
+  for (std::size_t i = 0; i < n; ++i) {
+    a[i] = a[i] + b[i];
+  }
+}
+
+void subtractScalar(double *a, const double *b, std::size_t n) {
+  for (std::size_t i = 0; i < n; ++i) {
+    a[i] = a[i] - b[i];
+  }
+}
+
+void multiplyScalar(double *a, const double *b, std::size_t n) {
+  for (std::size_t i = 0; i < n; ++i) {
+    a[i] = a[i] * b[i];
+  }
+}
+
+void divideScalar(double *a, const double *b, std::uint8_t *errors,
+                  std::size_t n) {
+  for (std::size_t i = 0; i < n; ++i) {
+    errors[i] |= static_cast<std::uint8_t>(b[i] == 0.0);
+    a[i] = a[i] / b[i];
+  }
+}
+
+void negateScalar(double *a, std::size_t n) {
+  for (std::size_t i = 0; i < n; ++i) {
+    a[i] = -a[i];
+  }
+}
+
+void percentScalar(double *a, std::size_t n) {
+  for (std::size_t i = 0; i < n; ++i) {
+    a[i] = a[i] / 100.0;
+  }
+}
+
+// Multiply, then add, with no fused multiply-add, so every kernel rounds
+// twice exactly as Conversion::operator() does
+void scaleScalar(const double *in, double scale, double shift, double *out,
+                 std::size_t n) {
+  for (std::size_t i = 0; i < n; ++i) {
+    out[i] = in[i] * scale + shift;
+  }
+}
+
+constexpr Kernels kScalarKernels = {addScalar,      subtractScalar,
+                                    multiplyScalar, divideScalar,
+                                    negateScalar,   percentScalar,
+                                    scaleScalar};
+
+#ifdef CALC_X86_64
+
+// SSE2 is part of the x86-64 baseline, so these need no runtime check
+
+template <__m128d (*Op)(__m128d, __m128d)>
+void binarySSE2(double *a, const double *b, std::size_t n) {
+  std::size_t i = 0;
+  for (; i + 2 <= n; i += 2) {
+    _mm_storeu_pd(a + i, Op(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+  }
+  for (; i < n; ++i) {
+    _mm_store_sd(a + i, Op(_mm_load_sd(a + i), _mm_load_sd(b + i)));
+  }
+}
+
+__m128d addPd(__m128d a, __m128d b) { return _mm_add_pd(a, b); }
+__m128d subPd(__m128d a, __m128d b) { return _mm_sub_pd(a, b); }
+__m128d mulPd(__m128d a, __m128d b) { return _mm_mul_pd(a, b); }
+
+void divideSSE2(double *a, const double *b, std::uint8_t *errors,
+                std::size_t n) {
+  const __m128d zero = _mm_setzero_pd();
+  std::size_t i = 0;
+  for (; i + 2 <= n; i += 2) {
+    const __m128d divisor = _mm_loadu_pd(b + i);
+    const int mask = _mm_movemask_pd(_mm_cmpeq_pd(divisor, zero));
+    errors[i] |= static_cast<std::uint8_t>(mask & 1);
+    errors[i + 1] |= static_cast<std::uint8_t>((mask >> 1) & 1);
+    _mm_storeu_pd(a + i, _mm_div_pd(_mm_loadu_pd(a + i), divisor));
+  }
+  divideScalar(a + i, b + i, errors + i, n - i);
+}
+
+void negateSSE2(double *a, std::size_t n) {
+  const __m128d sign = _mm_set1_pd(-0.0);
+  std::size_t i = 0;
+  for (; i + 2 <= n; i += 2) {
+    _mm_storeu_pd(a + i, _mm_xor_pd(_mm_loadu_pd(a + i), sign));
+  }
+  negateScalar(a + i, n - i);
+}
+
+void percentSSE2(double *a, std::size_t n) {
+  const __m128d hundred = _mm_set1_pd(100.0);
+  std::size_t i = 0;
+  for (; i + 2 <= n; i += 2) {
+    _mm_storeu_pd(a + i, _mm_div_pd(_mm_loadu_pd(a + i), hundred));
+  }
+  percentScalar(a + i, n - i);
+}
+
+void scaleSSE2(const double *in, double scale, double shift, double *out,
+               std::size_t n) {
+  const __m128d factor = _mm_set1_pd(scale);
+  const __m128d offset = _mm_set1_pd(shift);
+  std::size_t i = 0;
+  for (; i + 2 <= n; i += 2) {
+    _mm_storeu_pd(out + i,
+                  _mm_add_pd(_mm_mul_pd(_mm_loadu_pd(in + i), factor), offset));
+  }
+  scaleScalar(in + i, scale, shift, out + i, n - i);
+}
+
+constexpr Kernels kSSE2Kernels = {
+    binarySSE2<addPd>, binarySSE2<subPd>, binarySSE2<mulPd>,
+    divideSSE2,        negateSSE2,        percentSSE2,
+    scaleSSE2};
+
+// AVX2 kernels are compiled for AVX2 regardless of the global flags and are
+// only reached after detectKernel() confirmed CPU and OS support
+
+CALC_TARGET_AVX2 void addAVX2(double *a, const double *b, std::size_t n) {
+  std::size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    _mm256_storeu_pd(a + i, _mm256_add_pd(_mm256_loadu_pd(a + i),
+                                          _mm256_loadu_pd(b + i)));
+  }
+  addScalar(a + i, b + i, n - i);
+}
+
+CALC_TARGET_AVX2 void subtractAVX2(double *a, const double *b,
+                                   std::size_t n) {
+  std::size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    _mm256_storeu_pd(a + i, _mm256_sub_pd(_mm256_loadu_pd(a + i),
+                                          _mm256_loadu_pd(b + i)));
+  }
+  subtractScalar(a + i, b + i, n - i);
+}
+
+CALC_TARGET_AVX2 void multiplyAVX2(double *a, const double *b,
+                                   std::size_t n) {
+  std::size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    _mm256_storeu_pd(a + i, _mm256_mul_pd(_mm256_loadu_pd(a + i),
+                                          _mm256_loadu_pd(b + i)));
+  }
+  multiplyScalar(a + i, b + i, n - i);
+}
+
+CALC_TARGET_AVX2 void divideAVX2(double *a, const double *b,
+                                 std::uint8_t *errors, std::size_t n) {
+  const __m256d zero = _mm256_setzero_pd();
+  std::size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    const __m256d divisor = _mm256_loadu_pd(b + i);
+    const int mask =
+        _mm256_movemask_pd(_mm256_cmp_pd(divisor, zero, _CMP_EQ_OQ));
+    if (mask != 0) {
+      for (int lane = 0; lane < 4; ++lane) {
+        errors[i + lane] |= static_cast<std::uint8_t>((mask >> lane) & 1);
+      }
+    }
+    _mm256_storeu_pd(a + i, _mm256_div_pd(_mm256_loadu_pd(a + i), divisor));
+  }
+  divideScalar(a + i, b + i, errors + i, n - i);
+}
+
+CALC_TARGET_AVX2 void negateAVX2(double *a, std::size_t n) {
+  const __m256d sign = _mm256_set1_pd(-0.0);
+  std::size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    _mm256_storeu_pd(a + i, _mm256_xor_pd(_mm256_loadu_pd(a + i), sign));
+  }
+  negateScalar(a + i, n - i);
+}
+
+CALC_TARGET_AVX2 void percentAVX2(double *a, std::size_t n) {
+  const __m256d hundred = _mm256_set1_pd(100.0);
+  std::size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    _mm256_storeu_pd(a + i, _mm256_div_pd(_mm256_loadu_pd(a + i), hundred));
+  }
+  percentScalar(a + i, n - i);
+}
+
+CALC_TARGET_AVX2 void scaleAVX2(const double *in, double scale, double shift,
+                                double *out, std::size_t n) {
+  const __m256d factor = _mm256_set1_pd(scale);
+  const __m256d offset = _mm256_set1_pd(shift);
+  std::size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    const __m256d scaled = _mm256_mul_pd(_mm256_loadu_pd(in + i), factor);
+    _mm256_storeu_pd(out + i, _mm256_add_pd(scaled, offset));
+  }
+  scaleScalar(in + i, scale, shift, out + i, n - i);
+}
+
+constexpr Kernels kAVX2Kernels = {addAVX2,    subtractAVX2, multiplyAVX2,
+                                  divideAVX2, negateAVX2,   percentAVX2,
+                                  scaleAVX2};
+
+#endif
+
+const Kernels &kernelsFor(Kernel kernel) {
+#ifdef CALC_X86_64
+  switch (kernel) {
+  case Kernel::AVX2:
+    return kAVX2Kernels;
+  case Kernel::SSE2:
+    return kSSE2Kernels;
+  case Kernel::Scalar:
+    break;
+  }
+#endif
+  (void)kernel;
+  return kScalarKernels;
+}
+
+Kernel probeKernel() {
+#ifdef CALC_X86_64
+#ifdef _MSC_VER
+  int info[4] = {};
+  __cpuid(info, 0);
+  const bool hasLeaf7 = info[0] >= 7;
+  __cpuid(info, 1);
+  const bool osxsave = (info[2] & (1 << 27)) != 0;
+  const bool avx = (info[2] & (1 << 28)) != 0;
+  bool avx2 = false;
+  if (hasLeaf7) {
+    __cpuidex(info, 7, 0);
+    avx2 = (info[1] & (1 << 5)) != 0;
+  }
+  // The OS must also save the upper halves of the YMM registers
+  if (osxsave && avx && avx2 && (_xgetbv(0) & 0x6) == 0x6) {
+    return Kernel::AVX2;
+  }
+#else
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    return Kernel::AVX2;
+  }
+#endif
+  return Kernel::SSE2;
+#else
+  return Kernel::Scalar;
+#endif
+}
+
+} // namespace
+
+Kernel detectKernel() {
+  static const Kernel kernel = probeKernel();
+  return kernel;
+}
+
+std::string_view kernelName(Kernel kernel) {
+  switch (kernel) {
+  case Kernel::AVX2:
+    return "avx2";
+  case Kernel::SSE2:
+    return "sse2";
+  case Kernel::Scalar:
+    break;
+  }
+  return "scalar";
+}
+
+bool evaluateColumns(const Program &program,
+                     std::span<const double *const> columns, std::size_t rows,
+                     double *values, std::uint8_t *errors) {
+  return evaluateColumns(program, columns, rows, values, errors,
+                         detectKernel());
+}
+
+bool evaluateColumns(const Program &program,
+                     std::span<const double *const> columns, std::size_t rows,
+                     double *values, std::uint8_t *errors, Kernel kernel) {
+  if (columns.size() < program.variables.size()) {
+    return false;
+  }
+  const Kernels &ops = kernelsFor(std::min(kernel, detectKernel()));
+
+  // One block-sized slot per operand stack entry
+  std::vector<double> stack(std::max<std::size_t>(program.maxDepth, 1) *
+                            kBlock);
+  std::vector<double> arguments; // One row's arguments of a Call
+  for (std::size_t base = 0; base < rows; base += kBlock) {
+    const std::size_t n = std::min(kBlock, rows - base);
+    std::uint8_t *blockErrors = errors + base;
+    std::fill(blockErrors, blockErrors + n, std::uint8_t{0});
+
+    double *top = stack.data(); // Slot above the topmost operand
+    for (const Instruction &instruction : program.code) {
+      switch (instruction.op) {
+      case OpCode::Push:
+        std::fill(top, top + n, program.constants[instruction.operand]);
+        top += kBlock;
+        break;
+      case OpCode::Load:
+        std::memcpy(top, columns[instruction.operand] + base,
+                    n * sizeof(double));
+        top += kBlock;
+        break;
+      case OpCode::Add:
+        top -= kBlock;
+        ops.add(top - kBlock, top, n);
+        break;
+      case OpCode::Subtract:
+        top -= kBlock;
+        ops.subtract(top - kBlock, top, n);
+        break;
+      case OpCode::Multiply:
+        top -= kBlock;
+        ops.multiply(top - kBlock, top, n);
+        break;
+      case OpCode::Divide:
+        top -= kBlock;
+        ops.divide(top - kBlock, top, blockErrors, n);
+        break;
+      case OpCode::Negate:
+        ops.negate(top - kBlock, n);
+        break;
+      case OpCode::Percent:
+        ops.percent(top - kBlock, n);
+        break;
+      case OpCode::Call: {
+        // Row by row: aggregates have no element-wise kernel
+        const std::uint32_t count = argumentCount(instruction.operand);
+        top -= count * kBlock;
+        arguments.resize(count);
+        for (std::size_t i = 0; i < n; ++i) {
+          for (std::uint32_t j = 0; j < count; ++j) {
+            arguments[j] = top[j * kBlock + i];
+          }
+          const std::optional<double> result =
+              aggregate(calledFunction(instruction.operand), arguments);
+          top[i] = result.value_or(0.0);
+          blockErrors[i] |= !result;
+        }
+        top += kBlock;
+        break;
+      }
+      }
+    }
+
+    double *blockValues = values + base;
+    if (top == stack.data()) {
+      std::fill(blockValues, blockValues + n, 0.0);
+    } else {
+      std::memcpy(blockValues, top - kBlock, n * sizeof(double));
+    }
+    for (std::size_t i = 0; i < n; ++i) {
+      if (blockErrors[i]) {
+        blockValues[i] = std::numeric_limits<double>::quiet_NaN();
+      }
+    }
+  }
+  return true;
+}
+
+void scaleColumn(const double *values, std::size_t count, double scale,
+                 double shift, double *out) {
+  kernelsFor(detectKernel()).scale(values, scale, shift, out, count);
+}
+
+} // namespace calc
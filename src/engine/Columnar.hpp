@@ -0,0 +1,38 @@
+#pragma once
+#include "engine/Expression.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+namespace calc {
+
+// Instruction sets the columnar evaluator has kernels for
+enum class Kernel : std::uint8_t { Scalar, SSE2, AVX2 };
+
+// Best kernel the running CPU supports (checked once, then cached)
+Kernel detectKernel();
+std::string_view kernelName(Kernel kernel);
+
+// Evaluates `program` once per row over columnar operands: columns[i] points
+// at `rows` values bound to program.variables[i]. values[row] receives the
+// result and errors[row] is 1 where that row divides by zero or a function
+// has no result (its value is then NaN), 0 elsewhere. Every other row
+// matches evaluate() bit for bit.
+// Returns false when fewer columns than variables are supplied.
+bool evaluateColumns(const Program &program,
+                     std::span<const double *const> columns, std::size_t rows,
+                     double *values, std::uint8_t *errors);
+
+// Same, with an explicit kernel. Kernels the CPU lacks fall back to the best
+// supported one.
+bool evaluateColumns(const Program &program,
+                     std::span<const double *const> columns, std::size_t rows,
+                     double *values, std::uint8_t *errors, Kernel kernel);
+
+// out[i] = values[i] × scale + shift for `count` values, as unit
+// conversions need; bit for bit the scalar result. `out` may equal `values`.
+void scaleColumn(const double *values, std::size_t count, double scale,
+                 double shift, double *out);
+
+} // namespace calc
@@ -0,0 +1,392 @@
+#pragma once
+#include "engine/Expression.hpp"
+#include "engine/ParseDouble.hpp"
+#include "engine/Units.hpp"
+#include <optional>
+#include <utility>
+
+namespace calc::detail {
+
+// Guards the recursive descent against pathological nesting
+inline constexpr int kMaxNesting = 256;
+
+// Recursive-descent compiler behind compile(). Everything is constexpr, so
+// the same code compiles expressions at build time (see Eval.hpp) and at
+// run time.
+class Compiler {
+public:
+  // Compiles into `program`, whose containers are cleared but keep their
+  // capacity, so a Program compiled into over and over stops allocating.
+  // With `units`, values may carry units from it and end in "to <unit>".
+  constexpr Compiler(std::string_view source, Program &program,
+                     const UnitTable *units = nullptr)
+      : source(source), program(program), units(units) {
+    program.code.clear();
+    program.constants.clear();
+    program.literals.clear();
+    program.variables.clear();
+    program.maxDepth = 0;
+  }
+
+  constexpr bool run(CompileError *error) {
+    if (parseExpression(0) && parseConversion()) {
+      skipSpaces();
+      if (pos == source.size()) {
+        return true;
+      }
+      fail("Unexpected input");
+    }
+    if (error) {
+      error->position = errorPosition;
+      error->message = message;
+    }
+    return false;
+  }
+
+private:
+  std::string_view source;
+  std::size_t pos = 0;
+  Program &program;
+  std::uint32_t depth = 0;
+
+  static constexpr std::uint32_t kNoDimension = 0xFFFFFFFF;
+  const UnitTable *units;
+  // Dimension of the units used so far; an expression sticks to one
+  std::uint32_t dimension = kNoDimension;
+
+  std::size_t errorPosition = 0;
+  std::string message;
+
+  constexpr bool fail(std::string_view what) {
+    if (message.empty()) {
+      errorPosition = pos;
+      message = what;
+    }
+    return false;
+  }
+
+  constexpr void skipSpaces() {
+    while (pos < source.size() && (source[pos] == ' ' || source[pos] == '\t' ||
+                                   source[pos] == '\r')) {
+      ++pos;
+    }
+  }
+
+  constexpr bool accept(std::string_view token) {
+    skipSpaces();
+    if (source.substr(pos).starts_with(token)) {
+      pos += token.size();
+      return true;
+    }
+    return false;
+  }
+
+  constexpr void emit(OpCode op, std::uint32_t operand = 0) {
+    program.code.push_back({op, operand});
+    if (op == OpCode::Push || op == OpCode::Load) {
+      if (++depth > program.maxDepth) {
+        program.maxDepth = depth;
+      }
+    } else if (op == OpCode::Call) {
+      depth -= argumentCount(operand) - 1;
+    } else if (op != OpCode::Negate && op != OpCode::Percent) {
+      --depth;
+    }
+  }
+
+  // expression := term (("+" | "-") term)*
+  constexpr bool parseExpression(int nesting) {
+    if (nesting > kMaxNesting) {
+      return fail("Expression is nested too deeply");
+    }
+    if (!parseTerm(nesting)) {
+      return false;
+    }
+    for (;;) {
+      if (accept("+")) {
+        if (!parseTerm(nesting)) {
+          return false;
+        }
+        emit(OpCode::Add);
+      } else if (accept("-")) {
+        if (!parseTerm(nesting)) {
+          return false;
+        }
+        emit(OpCode::Subtract);
+      } else {
+        return true;
+      }
+    }
+  }
+
+  // term := quantity (("×" | "*" | "÷" | "/") quantity)*
+  constexpr bool parseTerm(int nesting) {
+    if (!parseQuantity(nesting)) {
+      return false;
+    }
+    for (;;) {
+      if (accept("×") || accept("*")) {
+        if (!parseQuantity(nesting)) {
+          return false;
+        }
+        emit(OpCode::Multiply);
+      } else if (accept("÷") || accept("/")) {
+        if (!parseQuantity(nesting)) {
+          return false;
+        }
+        emit(OpCode::Divide);
+      } else {
+        return true;
+      }
+    }
+  }
+
+  // quantity := unary unit?, so "-40 °C" is minus forty degrees rather
+  // than the negated temperature of forty
+  constexpr bool parseQuantity(int nesting) {
+    return parseUnary(nesting) && parseUnit();
+  }
+
+  // unary := ("-" | "+") unary | postfix
+  constexpr bool parseUnary(int nesting) {
+    if (nesting > kMaxNesting) {
+      return fail("Expression is nested too deeply");
+    }
+    if (accept("-")) {
+      if (!parseUnary(nesting + 1)) {
+        return false;
+      }
+      emit(OpCode::Negate);
+      return true;
+    }
+    if (accept("+")) {
+      return parseUnary(nesting + 1);
+    }
+    return parsePostfix(nesting);
+  }
+
+  // postfix := primary "%"*
+  constexpr bool parsePostfix(int nesting) {
+    if (!parsePrimary(nesting)) {
+      return false;
+    }
+    while (accept("%")) {
+      emit(OpCode::Percent);
+    }
+    return true;
+  }
+
+  constexpr std::string_view unitNameAt(std::size_t start) const {
+    const std::string_view rest = source.substr(start);
+    return rest.substr(0, unitNameLength(rest));
+  }
+
+  constexpr bool useDimension(std::uint32_t unit) {
+    const std::uint32_t of = (*units)[unit].dimension;
+    if (dimension != kNoDimension && dimension != of) {
+      return fail("Incompatible units");
+    }
+    dimension = of;
+    return true;
+  }
+
+  // unit := a name from `units`; scales its operand to the base unit of
+  // the unit's dimension, so the rest of the program is plain arithmetic
+  constexpr bool parseUnit() {
+    if (!units) {
+      return true;
+    }
+    skipSpaces();
+    const std::string_view name = unitNameAt(pos);
+    if (name.empty() || name == "to") {
+      return true;
+    }
+    const std::uint32_t unit = units->find(name);
+    if (unit == UnitTable::kNotFound) {
+      return fail("Unknown unit");
+    }
+    if (!useDimension(unit)) {
+      return false;
+    }
+    pos += name.size();
+    emitLiteral((*units)[unit].factor, units->factorText(unit));
+    emit(OpCode::Multiply);
+    if ((*units)[unit].offset != 0.0) {
+      emitLiteral((*units)[unit].offset, units->offsetText(unit));
+      emit(OpCode::Add);
+    }
+    return true;
+  }
+
+  // conversion := ("to" unit)?, after the whole expression; converts its
+  // value from the base unit to `unit`
+  constexpr bool parseConversion() {
+    if (!units) {
+      return true;
+    }
+    skipSpaces();
+    if (unitNameAt(pos) != "to") {
+      return true;
+    }
+    pos += 2;
+    skipSpaces();
+    const std::string_view name = unitNameAt(pos);
+    const std::uint32_t unit =
+        name.empty() ? UnitTable::kNotFound : units->find(name);
+    if (unit == UnitTable::kNotFound) {
+      return fail(name.empty() ? "Expected a unit" : "Unknown unit");
+    }
+    if (dimension == kNoDimension) {
+      return fail("No unit to convert from");
+    }
+    if (!useDimension(unit)) {
+      return false;
+    }
+    pos += name.size();
+    if ((*units)[unit].offset != 0.0) {
+      emitLiteral((*units)[unit].offset, units->offsetText(unit));
+      emit(OpCode::Subtract);
+    }
+    emitLiteral((*units)[unit].factor, units->factorText(unit));
+    emit(OpCode::Divide);
+    return true;
+  }
+
+  // primary := number | variable | call | "(" expression ")"
+  constexpr bool parsePrimary(int nesting) {
+    if (accept("(")) {
+      if (!parseExpression(nesting + 1)) {
+        return false;
+      }
+      if (!accept(")")) {
+        return fail("Expected ')'");
+      }
+      return true;
+    }
+    skipSpaces();
+    if (pos < source.size() && isIdentifierStart(source[pos]) &&
+        !isNumberWord(identifierAt(pos))) {
+      const std::string_view name = identifierAt(pos);
+      const std::size_t start = pos;
+      pos += name.size();
+      if (accept("(")) {
+        const std::optional<Function> function = functionNamed(name);
+        if (!function) {
+          pos = start;
+          return fail("Unknown function");
+        }
+        return parseCall(*function, nesting);
+      }
+      return parseVariable(name);
+    }
+    return parseNumber();
+  }
+
+  static constexpr std::optional<Function>
+  functionNamed(std::string_view name) {
+    constexpr std::pair<std::string_view, Function> kFunctions[] = {
+        {"sum", Function::Sum},         {"mean", Function::Mean},
+        {"min", Function::Min},         {"max", Function::Max},
+        {"var", Function::Variance},    {"stddev", Function::StdDev},
+        {"median", Function::Median},   {"percentile", Function::Percentile},
+    };
+    for (const auto &[functionName, function] : kFunctions) {
+      if (functionName == name) {
+        return function;
+      }
+    }
+    return std::nullopt;
+  }
+
+  // call := function "(" expression ("," expression)* ")", after the "("
+  constexpr bool parseCall(Function function, int nesting) {
+    std::uint32_t arguments = 0;
+    do {
+      if (arguments == kMaxArguments) {
+        return fail("Too many arguments");
+      }
+      if (!parseExpression(nesting + 1)) {
+        return false;
+      }
+      ++arguments;
+    } while (accept(","));
+    if (!accept(")")) {
+      return fail("Expected ')'");
+    }
+    if (function == Function::Percentile && arguments < 2) {
+      return fail("percentile() needs a percentage and values");
+    }
+    emit(OpCode::Call, callOperand(function, arguments));
+    return true;
+  }
+
+  static constexpr bool isIdentifierStart(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+  }
+
+  static constexpr bool isIdentifierChar(char c) {
+    return isIdentifierStart(c) || (c >= '0' && c <= '9');
+  }
+
+  // "inf" and "nan" are what the display shows for those values
+  static constexpr bool isNumberWord(std::string_view word) {
+    const auto equalsIgnoringCase = [word](std::string_view lower) {
+      if (word.size() != lower.size()) {
+        return false;
+      }
+      for (std::size_t i = 0; i < word.size(); ++i) {
+        if ((word[i] | 0x20) != lower[i]) {
+          return false;
+        }
+      }
+      return true;
+    };
+    return equalsIgnoringCase("inf") || equalsIgnoringCase("infinity") ||
+           equalsIgnoringCase("nan");
+  }
+
+  constexpr std::string_view identifierAt(std::size_t start) const {
+    std::size_t end = start;
+    while (end < source.size() && isIdentifierChar(source[end])) {
+      ++end;
+    }
+    return source.substr(start, end - start);
+  }
+
+  // `name` has already been consumed
+  constexpr bool parseVariable(std::string_view name) {
+    std::uint32_t index = 0;
+    while (index < program.variables.size() &&
+           program.variables[index] != name) {
+      ++index;
+    }
+    if (index == program.variables.size()) {
+      program.variables.emplace_back(name);
+    }
+    emit(OpCode::Load, index);
+    return true;
+  }
+
+  constexpr bool parseNumber() {
+    skipSpaces();
+    const std::string_view rest = source.substr(pos);
+    const ParsedDouble number = parseDouble(rest);
+    if (number.length == 0) {
+      return fail(pos == source.size() ? "Unexpected end of expression"
+                                       : "Expected a number");
+    }
+    pos += number.length;
+    emitLiteral(number.value, rest.substr(0, number.length));
+    return true;
+  }
+
+  // Pushes a constant, keeping its source text for exact backends
+  constexpr void emitLiteral(double value, std::string_view text) {
+    program.constants.push_back(value);
+    program.literals.emplace_back(text);
+    emit(OpCode::Push,
+         static_cast<std::uint32_t>(program.constants.size() - 1));
+  }
+};
+
+} // namespace calc::detail
@@ -0,0 +1,817 @@
+#include "engine/Decimal.hpp"
+#include "engine/Arena.hpp"
+#include "engine/Interpreter.hpp"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <string_view>
+#include <vector>
+
+namespace calc {
+
+namespace {
+
+using Limbs = Decimal::Limbs;
+
+constexpr std::uint64_t kLimbBase = std::uint64_t{1} << 32;
+constexpr std::uint32_t kChunkBase = 1000000000; // 10^9, one decimal chunk
+constexpr std::int32_t kMaxExponent = 100000;
+// Aligning operands further apart than this many decimal places would need
+// an enormous magnitude; an operand lying wholly that far below the other's
+// last digit is dropped instead
+constexpr std::int64_t kMaxAlignment = 4000;
+// Plain notation is used while it needs at most this many padding zeros
+constexpr std::int64_t kMaxPadding = 40;
+
+constexpr std::array<std::uint32_t, 10> kPowersOfTen = {
+    1,      10,      100,      1000,      10000,
+    100000, 1000000, 10000000, 100000000, 1000000000};
+
+int compareMagnitude(const Limbs &lhs, const Limbs &rhs) {
+  if (lhs.size() != rhs.size()) {
+    return lhs.size() < rhs.size() ? -1 : 1;
+  }
+  for (std::size_t i = lhs.size(); i-- > 0;) {
+    if (lhs[i] != rhs[i]) {
+      return lhs[i] < rhs[i] ? -1 : 1;
+    }
+  }
+  return 0;
+}
+
+Limbs addMagnitude(const Limbs &lhs, const Limbs &rhs) {
+  const Limbs &longer = lhs.size() >= rhs.size() ? lhs : rhs;
+  const Limbs &shorter = lhs.size() >= rhs.size() ? rhs : lhs;
+  Limbs sum;
+  sum.resize(longer.size() + 1);
+  std::uint64_t carry = 0;
+  for (std::size_t i = 0; i < longer.size(); ++i) {
+    carry += longer[i];
+    if (i < shorter.size()) {
+      carry += shorter[i];
+    }
+    sum[i] = static_cast<std::uint32_t>(carry);
+    carry >>= 32;
+  }
+  sum[longer.size()] = static_cast<std::uint32_t>(carry);
+  sum.trim();
+  return sum;
+}
+
+// Requires lhs >= rhs
+Limbs subtractMagnitude(const Limbs &lhs, const Limbs &rhs) {
+  Limbs difference;
+  difference.resize(lhs.size());
+  std::int64_t borrow = 0;
+  for (std::size_t i = 0; i < lhs.size(); ++i) {
+    std::int64_t value = static_cast<std::int64_t>(lhs[i]) - borrow;
+    if (i < rhs.size()) {
+      value -= rhs[i];
+    }
+    borrow = value < 0 ? 1 : 0;
+    difference[i] = static_cast<std::uint32_t>(value + borrow * kLimbBase);
+  }
+  difference.trim();
+  return difference;
+}
+
+Limbs multiplyMagnitude(const Limbs &lhs, const Limbs &rhs) {
+  Limbs product;
+  if (lhs.empty() || rhs.empty()) {
+    return product;
+  }
+  product.resize(lhs.size() + rhs.size());
+  for (std::size_t i = 0; i < lhs.size(); ++i) {
+    std::uint64_t carry = 0;
+    for (std::size_t j = 0; j < rhs.size(); ++j) {
+      carry += static_cast<std::uint64_t>(lhs[i]) * rhs[j] + product[i + j];
+      product[i + j] = static_cast<std::uint32_t>(carry);
+      carry >>= 32;
+    }
+    product[i + rhs.size()] = static_cast<std::uint32_t>(carry);
+  }
+  product.trim();
+  return product;
+}
+
+// magnitude = magnitude × factor + addend
+void multiplyAdd(Limbs &magnitude, std::uint32_t factor,
+                 std::uint32_t addend) {
+  std::uint64_t carry = addend;
+  for (std::size_t i = 0; i < magnitude.size(); ++i) {
+    carry += static_cast<std::uint64_t>(magnitude[i]) * factor;
+    magnitude[i] = static_cast<std::uint32_t>(carry);
+    carry >>= 32;
+  }
+  if (carry != 0) {
+    magnitude.push_back(static_cast<std::uint32_t>(carry));
+  }
+}
+
+// magnitude /= divisor, returning the remainder
+std::uint32_t divideSmall(Limbs &magnitude, std::uint32_t divisor) {
+  std::uint64_t remainder = 0;
+  for (std::size_t i = magnitude.size(); i-- > 0;) {
+    const std::uint64_t current = (remainder << 32) | magnitude[i];
+    magnitude[i] = static_cast<std::uint32_t>(current / divisor);
+    remainder = current % divisor;
+  }
+  magnitude.trim();
+  return static_cast<std::uint32_t>(remainder);
+}
+
+void scaleByPowerOfTen(Limbs &magnitude, std::int64_t places) {
+  for (; places >= 9; places -= 9) {
+    multiplyAdd(magnitude, kChunkBase, 0);
+  }
+  if (places > 0) {
+    multiplyAdd(magnitude, kPowersOfTen[static_cast<std::size_t>(places)], 0);
+  }
+}
+
+// Knuth's algorithm D (TAOCP 4.3.1), in the form of Hacker's Delight
+// divmnu: quotient = u / v and remainder = u % v for v with 2+ limbs
+void divideLong(const Limbs &u, const Limbs &v, Limbs &quotient,
+                Limbs &remainder) {
+  const std::size_t m = u.size();
+  const std::size_t n = v.size();
+  const int shift = std::countl_zero(v.back());
+
+  // Normalize so the divisor's top limb has its high bit set. The scratch
+  // limbs of a 34-digit division fit the arena's buffer.
+  Arena<512> arena;
+  std::pmr::vector<std::uint32_t> vn(n, &arena);
+  std::pmr::vector<std::uint32_t> un(m + 1, &arena);
+  for (std::size_t i = n - 1; i > 0; --i) {
+    vn[i] = (v[i] << shift) |
+            static_cast<std::uint32_t>(
+                (static_cast<std::uint64_t>(v[i - 1]) >> (32 - shift)) &
+                (shift ? 0xFFFFFFFFU : 0U));
+  }
+  vn[0] = v[0] << shift;
+  un[m] = static_cast<std::uint32_t>(
+      (static_cast<std::uint64_t>(u[m - 1]) >> (32 - shift)) &
+      (shift ? 0xFFFFFFFFU : 0U));
+  for (std::size_t i = m - 1; i > 0; --i) {
+    un[i] = (u[i] << shift) |
+            static_cast<std::uint32_t>(
+                (static_cast<std::uint64_t>(u[i - 1]) >> (32 - shift)) &
+                (shift ? 0xFFFFFFFFU : 0U));
+  }
+  un[0] = u[0] << shift;
+
+  quotient.clear();
+  quotient.resize(m - n + 1);
+  for (std::size_t j = m - n + 1; j-- > 0;) {
+    // Estimate the quotient digit from the top two limbs
+    const std::uint64_t numerator =
+        (static_cast<std::uint64_t>(un[j + n]) << 32) | un[j + n - 1];
+    std::uint64_t qhat = numerator / vn[n - 1];
+    std::uint64_t rhat = numerator % vn[n - 1];
+    while (qhat >= kLimbBase ||
+           qhat * vn[n - 2] > ((rhat << 32) | un[j + n - 2])) {
+      --qhat;
+      rhat += vn[n - 1];
+      if (rhat >= kLimbBase) {
+        break;
+      }
+    }
+
+    // Multiply and subtract
+    std::int64_t borrow = 0;
+    std::int64_t t = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+      const std::uint64_t p = qhat * vn[i];
+      t = static_cast<std::int64_t>(un[i + j]) - borrow -
+          static_cast<std::int64_t>(p & 0xFFFFFFFFU);
+      un[i + j] = static_cast<std::uint32_t>(t);
+      borrow = static_cast<std::int64_t>(p >> 32) - (t >> 32);
+    }
+    t = static_cast<std::int64_t>(un[j + n]) - borrow;
+    un[j + n] = static_cast<std::uint32_t>(t);
+
+    quotient[j] = static_cast<std::uint32_t>(qhat);
+    if (t < 0) {
+      // Estimate was one too large: add the divisor back
+      --quotient[j];
+      std::uint64_t carry = 0;
+      for (std::size_t i = 0; i < n; ++i) {
+        carry += static_cast<std::uint64_t>(un[i + j]) + vn[i];
+        un[i + j] = static_cast<std::uint32_t>(carry);
+        carry >>= 32;
+      }
+      un[j + n] += static_cast<std::uint32_t>(carry);
+    }
+  }
+  quotient.trim();
+
+  remainder.clear();
+  remainder.resize(n);
+  for (std::size_t i = 0; i + 1 < n; ++i) {
+    remainder[i] = (un[i] >> shift) |
+                   static_cast<std::uint32_t>(
+                       (static_cast<std::uint64_t>(un[i + 1]) << (32 - shift)) &
+                       (shift ? 0xFFFFFFFFU : 0U));
+  }
+  remainder[n - 1] = un[n - 1] >> shift;
+  remainder.trim();
+}
+
+void divideMagnitude(const Limbs &u, const Limbs &v, Limbs &quotient,
+                     Limbs &remainder) {
+  if (compareMagnitude(u, v) < 0) {
+    quotient.clear();
+    remainder = u;
+  } else if (v.size() == 1) {
+    quotient = u;
+    remainder.clear();
+    if (const std::uint32_t rest = divideSmall(quotient, v[0])) {
+      remainder.push_back(rest);
+    }
+  } else {
+    divideLong(u, v, quotient, remainder);
+  }
+}
+
+// Decimal digits of a magnitude, most significant first ("0" for zero),
+// in memory from the same resource as `digits`
+void magnitudeDigits(Limbs magnitude, std::pmr::string &digits) {
+  digits.clear();
+  if (magnitude.empty()) {
+    digits += '0';
+    return;
+  }
+  // Base 10^9, least significant first
+  std::pmr::vector<std::uint32_t> chunks(digits.get_allocator());
+  while (!magnitude.empty()) {
+    chunks.push_back(divideSmall(magnitude, kChunkBase));
+  }
+  // Leading chunk unpadded, every other chunk zero-padded to 9 digits
+  digits.assign(chunks.size() * 9, '0');
+  char *position =
+      std::to_chars(digits.data(), digits.data() + 9, chunks.back()).ptr;
+  for (std::size_t i = chunks.size() - 1; i-- > 0;) {
+    std::array<char, 9> chunk;
+    const auto end =
+        std::to_chars(chunk.data(), chunk.data() + chunk.size(), chunks[i])
+            .ptr;
+    const auto length = static_cast<std::size_t>(end - chunk.data());
+    std::memcpy(position + 9 - length, chunk.data(), length);
+    position += 9;
+  }
+  digits.resize(static_cast<std::size_t>(position - digits.data()));
+}
+
+// True when `small` × 10^smallExponent is below 10^(exponent - kMaxAlignment),
+// i.e. too small to change any digit kMaxAlignment places beyond the last
+// one of a number with that exponent. Each limb holds under 10 digits.
+bool isNegligible(const Limbs &small, std::int64_t smallExponent,
+                  std::int64_t exponent) {
+  const auto digitBound = static_cast<std::int64_t>(small.size()) * 10;
+  return smallExponent + digitBound < exponent - kMaxAlignment;
+}
+
+std::size_t digitCount(const Limbs &magnitude) {
+  if (magnitude.size() <= 2) {
+    std::uint64_t value = magnitude.empty() ? 0 : magnitude[0];
+    if (magnitude.size() == 2) {
+      value |= static_cast<std::uint64_t>(magnitude[1]) << 32;
+    }
+    std::size_t digits = 1;
+    while (value >= 10) {
+      value /= 10;
+      ++digits;
+    }
+    return digits;
+  }
+  Arena<256> arena;
+  std::pmr::string digits(&arena);
+  magnitudeDigits(magnitude, digits);
+  return digits.size();
+}
+
+} // namespace
+
+Decimal::Limbs &Decimal::Limbs::operator=(const Limbs &other) {
+  if (this != &other) {
+    count = 0;
+    reserve(other.count);
+    std::copy_n(other.data(), other.count, data());
+    count = other.count;
+  }
+  return *this;
+}
+
+Decimal::Limbs &Decimal::Limbs::operator=(Limbs &&other) noexcept {
+  if (this != &other) {
+    if (other.heap) {
+      heap = std::move(other.heap);
+      capacity = other.capacity;
+    } else {
+      heap.reset();
+      capacity = kInline;
+      std::copy_n(other.storage, other.count, storage);
+    }
+    count = other.count;
+    other.count = 0;
+    other.capacity = kInline;
+  }
+  return *this;
+}
+
+void Decimal::Limbs::reserve(std::size_t size) {
+  if (size <= capacity) {
+    return;
+  }
+  const std::size_t grown = std::max(size, capacity * 2);
+  auto buffer = std::make_unique<std::uint32_t[]>(grown);
+  std::copy_n(data(), count, buffer.get());
+  heap = std::move(buffer);
+  capacity = grown;
+}
+
+void Decimal::Limbs::resize(std::size_t size) {
+  reserve(size);
+  if (size > count) {
+    std::fill(data() + count, data() + size, 0U);
+  }
+  count = size;
+}
+
+void Decimal::Limbs::push_back(std::uint32_t limb) {
+  reserve(count + 1);
+  data()[count++] = limb;
+}
+
+void Decimal::Limbs::trim() {
+  while (count > 0 && data()[count - 1] == 0) {
+    --count;
+  }
+}
+
+Decimal::Decimal(long long value) : negative(value < 0) {
+  // Negate in unsigned arithmetic so LLONG_MIN does not overflow
+  std::uint64_t absolute = static_cast<std::uint64_t>(value);
+  if (negative) {
+    absolute = ~absolute + 1;
+  }
+  if (absolute != 0) {
+    magnitude.push_back(static_cast<std::uint32_t>(absolute));
+    if (absolute >> 32) {
+      magnitude.push_back(static_cast<std::uint32_t>(absolute >> 32));
+    }
+  }
+}
+
+std::optional<Decimal> Decimal::parse(std::string_view text) {
+  Decimal result;
+  std::size_t pos = 0;
+  if (pos < text.size() && (text[pos] == '-' || text[pos] == '+')) {
+    result.negative = text[pos] == '-';
+    ++pos;
+  }
+
+  std::int64_t exponent = 0;
+  bool anyDigit = false;
+  bool seenPoint = false;
+  std::uint32_t chunk = 0; // Digits not yet folded into the magnitude
+  std::size_t chunkDigits = 0;
+  for (; pos < text.size(); ++pos) {
+    const char c = text[pos];
+    if (c == '.' && !seenPoint) {
+      seenPoint = true;
+      continue;
+    }
+    if (c < '0' || c > '9') {
+      break;
+    }
+    anyDigit = true;
+    chunk = chunk * 10 + static_cast<std::uint32_t>(c - '0');
+    if (++chunkDigits == 9) {
+      multiplyAdd(result.magnitude, kChunkBase, chunk);
+      chunk = 0;
+      chunkDigits = 0;
+    }
+    if (seenPoint) {
+      --exponent;
+    }
+  }
+  if (!anyDigit) {
+    return std::nullopt;
+  }
+  if (chunkDigits > 0) {
+    multiplyAdd(result.magnitude, kPowersOfTen[chunkDigits], chunk);
+  }
+
+  if (pos < text.size() && (text[pos] == 'e' || text[pos] == 'E')) {
+    ++pos;
+    bool negativeExponent = false;
+    if (pos < text.size() && (text[pos] == '-' || text[pos] == '+')) {
+      negativeExponent = text[pos] == '-';
+      ++pos;
+    }
+    std::int64_t written = 0;
+    const auto [end, ec] =
+        std::from_chars(text.data() + pos, text.data() + text.size(), written);
+    if (ec != std::errc() || written > kMaxExponent) {
+      return std::nullopt;
+    }
+    pos = static_cast<std::size_t>(end - text.data());
+    exponent += negativeExponent ? -written : written;
+  }
+  if (pos != text.size() || exponent < -2 * kMaxExponent ||
+      exponent > kMaxExponent) {
+    return std::nullopt;
+  }
+
+  result.magnitude.trim();
+  result.exponent = static_cast<std::int32_t>(exponent);
+  if (result.magnitude.empty()) {
+    return Decimal();
+  }
+  return result;
+}
+
+std::optional<Decimal> Decimal::fromDouble(double value) {
+  std::array<char, 32> buffer{};
+  const auto [end, ec] =
+      std::to_chars(buffer.data(), buffer.data() + buffer.size(), value);
+  if (ec != std::errc()) {
+    return std::nullopt;
+  }
+  return parse(std::string_view(buffer.data(), end));
+}
+
+double Decimal::toDouble() const {
+  const std::string text = toString();
+  double value = 0.0;
+  const auto [end, ec] =
+      std::from_chars(text.data(), text.data() + text.size(), value);
+  if (ec == std::errc::result_out_of_range) {
+    // Saturate like strtod(): tiny values underflow, huge ones overflow
+    const bool tiny = exponent < 0 && text.find("e-") != std::string::npos;
+    value = tiny ? 0.0 : std::numeric_limits<double>::infinity();
+    return negative ? -value : value;
+  }
+  (void)end;
+  return value;
+}
+
+std::string Decimal::toString() const {
+  std::string text;
+  appendTo(text);
+  return text;
+}
+
+void Decimal::appendTo(std::string &out) const {
+  if (magnitude.empty()) {
+    out += '0';
+    return;
+  }
+  Arena<256> arena;
+  std::pmr::string buffer(&arena);
+  magnitudeDigits(magnitude, buffer);
+  std::string_view digits = buffer;
+  std::int64_t power = exponent;
+  // Trailing zeros only matter as padding, so fold them into the exponent
+  while (digits.size() > 1 && digits.back() == '0') {
+    digits.remove_suffix(1);
+    ++power;
+  }
+
+  if (negative) {
+    out += '-';
+  }
+  const auto length = static_cast<std::int64_t>(digits.size());
+  const std::int64_t pointPosition = length + power;
+  if (power >= 0 && power <= kMaxPadding) {
+    out += digits;
+    out.append(static_cast<std::size_t>(power), '0');
+  } else if (power < 0 && pointPosition > 0) {
+    out += digits.substr(0, static_cast<std::size_t>(pointPosition));
+    out += '.';
+    out += digits.substr(static_cast<std::size_t>(pointPosition));
+  } else if (power < 0 && -pointPosition <= kMaxPadding) {
+    out += "0.";
+    out.append(static_cast<std::size_t>(-pointPosition), '0');
+    out += digits;
+  } else {
+    // Scientific notation, formatted like printf's %e exponent
+    out += digits[0];
+    if (digits.size() > 1) {
+      out += '.';
+      out += digits.substr(1);
+    }
+    const std::int64_t scientific = pointPosition - 1;
+    out += scientific < 0 ? "e-" : "e+";
+    std::array<char, 24> exponentText;
+    const auto end =
+        std::to_chars(exponentText.data(),
+                      exponentText.data() + exponentText.size(),
+                      scientific < 0 ? -scientific : scientific)
+            .ptr;
+    if (end - exponentText.data() < 2) {
+      out += '0';
+    }
+    out.append(exponentText.data(), end);
+  }
+}
+
+Decimal Decimal::operator-() const {
+  Decimal result = *this;
+  if (!result.isZero()) {
+    result.negative = !negative;
+  }
+  return result;
+}
+
+Decimal Decimal::addSigned(const Decimal &lhs, const Decimal &rhs,
+                           bool negateRhs) {
+  const bool rhsNegative = rhs.negative != negateRhs;
+  if (rhs.isZero()) {
+    return lhs;
+  }
+  if (lhs.isZero()) {
+    Decimal result = rhs;
+    result.negative = rhsNegative;
+    return result;
+  }
+
+  const std::int64_t gap = static_cast<std::int64_t>(lhs.exponent) -
+                           static_cast<std::int64_t>(rhs.exponent);
+  if (gap > kMaxAlignment &&
+      isNegligible(rhs.magnitude, rhs.exponent, lhs.exponent)) {
+    return lhs;
+  }
+  if (gap < -kMaxAlignment &&
+      isNegligible(lhs.magnitude, lhs.exponent, rhs.exponent)) {
+    Decimal result = rhs;
+    result.negative = rhsNegative;
+    return result;
+  }
+
+  // Bring both magnitudes to the smaller exponent
+  Decimal result;
+  result.exponent = std::min(lhs.exponent, rhs.exponent);
+  const Limbs *left = &lhs.magnitude;
+  const Limbs *right = &rhs.magnitude;
+  Limbs scaled;
+  if (gap > 0) {
+    scaled = lhs.magnitude;
+    scaleByPowerOfTen(scaled, gap);
+    left = &scaled;
+  } else if (gap < 0) {
+    scaled = rhs.magnitude;
+    scaleByPowerOfTen(scaled, -gap);
+    right = &scaled;
+  }
+
+  if (lhs.negative == rhsNegative) {
+    result.magnitude = addMagnitude(*left, *right);
+    result.negative = lhs.negative;
+  } else {
+    const int order = compareMagnitude(*left, *right);
+    if (order == 0) {
+      return Decimal();
+    }
+    result.magnitude = order > 0 ? subtractMagnitude(*left, *right)
+                                 : subtractMagnitude(*right, *left);
+    result.negative = order > 0 ? lhs.negative : rhsNegative;
+  }
+  return result;
+}
+
+Decimal operator+(const Decimal &lhs, const Decimal &rhs) {
+  return Decimal::addSigned(lhs, rhs, false);
+}
+
+Decimal operator-(const Decimal &lhs, const Decimal &rhs) {
+  return Decimal::addSigned(lhs, rhs, true);
+}
+
+Decimal operator*(const Decimal &lhs, const Decimal &rhs) {
+  Decimal result;
+  if (lhs.isZero() || rhs.isZero()) {
+    return result;
+  }
+  if (lhs.magnitude.size() == 1 && rhs.magnitude.size() == 1) {
+    // Fast path: the product of two limbs always fits in 64 bits
+    const std::uint64_t product =
+        static_cast<std::uint64_t>(lhs.magnitude[0]) * rhs.magnitude[0];
+    result.magnitude.push_back(static_cast<std::uint32_t>(product));
+    if (product >> 32) {
+      result.magnitude.push_back(static_cast<std::uint32_t>(product >> 32));
+    }
+  } else {
+    result.magnitude = multiplyMagnitude(lhs.magnitude, rhs.magnitude);
+  }
+  const std::int64_t exponent = static_cast<std::int64_t>(lhs.exponent) +
+                                rhs.exponent;
+  result.exponent = static_cast<std::int32_t>(
+      std::clamp<std::int64_t>(exponent, INT32_MIN / 2, INT32_MAX / 2));
+  result.negative = lhs.negative != rhs.negative;
+  return result;
+}
+
+std::optional<Decimal> divide(const Decimal &lhs, const Decimal &rhs,
+                              int digits) {
+  if (rhs.isZero()) {
+    return std::nullopt;
+  }
+  if (lhs.isZero()) {
+    return Decimal();
+  }
+
+  // Scale the dividend so the integer quotient has at least one digit
+  // beyond `digits`: the surplus digits and the remainder decide rounding
+  const auto lhsDigits = static_cast<std::int64_t>(digitCount(lhs.magnitude));
+  const auto rhsDigits = static_cast<std::int64_t>(digitCount(rhs.magnitude));
+  const std::int64_t scale =
+      std::max<std::int64_t>(0, digits + 1 + rhsDigits - lhsDigits);
+  Decimal::Limbs dividend = lhs.magnitude;
+  scaleByPowerOfTen(dividend, scale);
+
+  Decimal result;
+  Decimal::Limbs remainder;
+  divideMagnitude(dividend, rhs.magnitude, result.magnitude, remainder);
+  std::int64_t exponent =
+      static_cast<std::int64_t>(lhs.exponent) - rhs.exponent - scale;
+
+  // Drop the surplus, keeping its leading digit and whether anything
+  // after it is nonzero, then round half to even
+  const auto surplus =
+      static_cast<std::int64_t>(digitCount(result.magnitude)) - digits;
+  bool sticky = !remainder.empty();
+  for (std::int64_t left = surplus - 1; left > 0; left -= 9) {
+    const auto places =
+        static_cast<std::size_t>(std::min<std::int64_t>(left, 9));
+    sticky =
+        divideSmall(result.magnitude, kPowersOfTen[places]) != 0 || sticky;
+  }
+  const std::uint32_t spare = divideSmall(result.magnitude, 10);
+  exponent += surplus;
+  if (spare > 5 || (spare == 5 && (sticky || (result.magnitude[0] & 1U)))) {
+    multiplyAdd(result.magnitude, 1, 1);
+    // 99…9 rounded up to 10^digits: one digit too many, all zeros
+    if (digitCount(result.magnitude) > static_cast<std::size_t>(digits)) {
+      divideSmall(result.magnitude, 10);
+      ++exponent;
+    }
+  } else if (spare == 0 && !sticky) {
+    // Exact: drop zeros left over from the scaling so 1 ÷ 4 is stored as
+    // 25e-2
+    Decimal::Limbs trimmed = result.magnitude;
+    while (!trimmed.empty() && divideSmall(trimmed, 10) == 0) {
+      result.magnitude = trimmed;
+      ++exponent;
+    }
+  }
+  result.exponent = static_cast<std::int32_t>(
+      std::clamp<std::int64_t>(exponent, INT32_MIN / 2, INT32_MAX / 2));
+  result.negative = lhs.negative != rhs.negative;
+  return result;
+}
+
+Decimal Decimal::percent() const {
+  Decimal result = *this;
+  if (!result.isZero()) {
+    result.exponent -= 2;
+  }
+  return result;
+}
+
+namespace {
+
+bool isLess(const Decimal &lhs, const Decimal &rhs) {
+  return (lhs - rhs).isNegative();
+}
+
+// Percentile `percentage` (0 to 100) of `values`, interpolated between the
+// two nearest ranks as the double path's percentile() does
+Decimal percentileOf(std::span<const Decimal> values,
+                     const Decimal &percentage) {
+  Arena<1024> arena;
+  std::pmr::vector<Decimal> sorted(values.begin(), values.end(), &arena);
+  std::sort(sorted.begin(), sorted.end(), isLess);
+  const auto last = static_cast<long long>(sorted.size() - 1);
+  const Decimal rank = (percentage * Decimal(last)).percent();
+  // The double only picks the neighbours; the fraction is exact
+  auto index = std::clamp(
+      static_cast<long long>(std::floor(rank.toDouble())), 0LL, last);
+  Decimal fraction = rank - Decimal(index);
+  if (fraction.isNegative()) {
+    fraction = rank - Decimal(--index);
+  } else if (index < last && !isLess(fraction, Decimal(1))) {
+    fraction = rank - Decimal(++index);
+  }
+  if (index == last || fraction.isZero()) {
+    return sorted[static_cast<std::size_t>(index)];
+  }
+  const Decimal &below = sorted[static_cast<std::size_t>(index)];
+  const Decimal &above = sorted[static_cast<std::size_t>(index) + 1];
+  return below + fraction * (above - below);
+}
+
+// Sums, means and variances are exact up to their final division; the
+// standard deviation is the square root of the exact variance, rounded
+// like a double
+std::optional<Decimal> aggregateDecimal(Function function,
+                                        std::span<const Decimal> arguments) {
+  Decimal percentage(50);
+  if (function == Function::Percentile && !arguments.empty()) {
+    percentage = arguments.front();
+    arguments = arguments.subspan(1);
+    if (percentage.isNegative() || isLess(Decimal(100), percentage)) {
+      return std::nullopt;
+    }
+  }
+  if (arguments.empty()) {
+    return std::nullopt;
+  }
+  const Decimal count(static_cast<long long>(arguments.size()));
+  switch (function) {
+  case Function::Sum:
+  case Function::Mean: {
+    Decimal sum;
+    for (const Decimal &value : arguments) {
+      sum = sum + value;
+    }
+    if (function == Function::Sum) {
+      return sum;
+    }
+    return calc::divide(sum, count);
+  }
+  case Function::Min:
+  case Function::Max: {
+    const Decimal *best = &arguments.front();
+    for (const Decimal &value : arguments) {
+      if (function == Function::Min ? isLess(value, *best)
+                                    : isLess(*best, value)) {
+        best = &value;
+      }
+    }
+    return *best;
+  }
+  case Function::Variance:
+  case Function::StdDev: {
+    if (arguments.size() < 2) {
+      return std::nullopt;
+    }
+    // (n Σx² - (Σx)²) / (n (n - 1)), exact until the division
+    Decimal sum;
+    Decimal squares;
+    for (const Decimal &value : arguments) {
+      sum = sum + value;
+      squares = squares + value * value;
+    }
+    auto variance = calc::divide(count * squares - sum * sum,
+                                 count * (count - Decimal(1)));
+    if (!variance || function == Function::Variance) {
+      return variance;
+    }
+    return Decimal::fromDouble(std::sqrt(variance->toDouble()));
+  }
+  case Function::Median:
+  case Function::Percentile:
+    return percentileOf(arguments, percentage);
+  }
+  return std::nullopt;
+}
+
+} // namespace
+
+template <> struct NumberTraits<Decimal> {
+  static std::optional<Decimal> constant(const Program &program,
+                                         std::uint32_t index) {
+    return Decimal::parse(program.literals[index]);
+  }
+
+  static std::optional<Decimal> divide(const Decimal &lhs,
+                                       const Decimal &rhs) {
+    return calc::divide(lhs, rhs, Decimal::kDivisionDigits);
+  }
+
+  static Decimal percent(const Decimal &value) { return value.percent(); }
+
+  static std::optional<Decimal> call(Function function,
+                                     std::span<const Decimal> arguments) {
+    return aggregateDecimal(function, arguments);
+  }
+};
+
+std::optional<Decimal> evaluateDecimal(const Program &program,
+                                       std::span<const Decimal> variables) {
+  if (variables.size() < program.variables.size()) {
+    return std::nullopt;
+  }
+  // Room for a dozen or so operands before the stack spills to the heap
+  Arena<1024> arena;
+  std::pmr::vector<Decimal> stack(program.maxDepth, &arena);
+  return interpret<Decimal>(program, variables, stack.data());
+}
+
+} // namespace calc
@@ -0,0 +1,114 @@
+#pragma once
+#include "engine/Expression.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+
+namespace calc {
+
+// Exact decimal number: sign × magnitude × 10^exponent, with the magnitude
+// stored as base-2^32 limbs. Magnitudes up to 128 bits (about 38 digits)
+// live inline, so ordinary values never touch the heap; anything larger
+// spills to a heap buffer and keeps full precision.
+//
+// Addition, subtraction, multiplication and percent are exact. Division
+// rounds half-to-even to `digits` significant digits.
+class Decimal {
+public:
+  // Significant digits kept by division (the precision of IEEE decimal128)
+  static constexpr int kDivisionDigits = 34;
+
+  Decimal() = default; // Zero
+  explicit Decimal(long long value);
+
+  // Parses "12.5", "-3", "1e+20", ... Returns std::nullopt for malformed
+  // text, "inf"/"nan", and exponents beyond ±100000.
+  static std::optional<Decimal> parse(std::string_view text);
+
+  // Exact digits of the shortest text that round-trips `value`, so 0.1
+  // becomes exactly 0.1. Non-finite values yield std::nullopt.
+  static std::optional<Decimal> fromDouble(double value);
+
+  // Nearest double
+  double toDouble() const;
+
+  // Plain notation ("1234.5", "0.001"); scientific ("1.5e+60") once that
+  // would need more than 40 padding zeros
+  std::string toString() const;
+  // Same text, appended to `out` without a temporary string
+  void appendTo(std::string &out) const;
+
+  bool isZero() const { return magnitude.empty(); }
+  bool isNegative() const { return negative; }
+
+  Decimal operator-() const;
+  friend Decimal operator+(const Decimal &lhs, const Decimal &rhs);
+  friend Decimal operator-(const Decimal &lhs, const Decimal &rhs);
+  friend Decimal operator*(const Decimal &lhs, const Decimal &rhs);
+
+  // Returns std::nullopt when dividing by zero
+  friend std::optional<Decimal> divide(const Decimal &lhs, const Decimal &rhs,
+                                       int digits);
+
+  // Exact division by 100
+  Decimal percent() const;
+
+  // Small-buffer vector of little-endian 32-bit limbs
+  class Limbs {
+  public:
+    static constexpr std::size_t kInline = 4;
+
+    Limbs() = default;
+    Limbs(const Limbs &other) { *this = other; }
+    Limbs(Limbs &&other) noexcept { *this = std::move(other); }
+    Limbs &operator=(const Limbs &other);
+    Limbs &operator=(Limbs &&other) noexcept;
+
+    std::size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    bool isInline() const { return !heap; }
+    std::uint32_t *data() { return heap ? heap.get() : storage; }
+    const std::uint32_t *data() const { return heap ? heap.get() : storage; }
+    std::uint32_t &operator[](std::size_t i) { return data()[i]; }
+    std::uint32_t operator[](std::size_t i) const { return data()[i]; }
+    std::uint32_t back() const { return data()[count - 1]; }
+
+    void clear() { count = 0; }
+    void resize(std::size_t size); // New limbs are zero
+    void push_back(std::uint32_t limb);
+    void pop_back() { --count; }
+    void trim(); // Drops leading zero limbs
+
+  private:
+    std::uint32_t storage[kInline] = {};
+    std::unique_ptr<std::uint32_t[]> heap;
+    std::size_t count = 0;
+    std::size_t capacity = kInline;
+
+    void reserve(std::size_t size);
+  };
+
+private:
+  Limbs magnitude;
+  std::int32_t exponent = 0;
+  bool negative = false;
+
+  static Decimal addSigned(const Decimal &lhs, const Decimal &rhs,
+                           bool negateRhs);
+};
+
+std::optional<Decimal> divide(const Decimal &lhs, const Decimal &rhs,
+                              int digits = Decimal::kDivisionDigits);
+
+// Stack-machine evaluation of `program` with exact decimal arithmetic.
+// Literals are taken from the program's source text, so "0.1" is exactly
+// one tenth. Fails on division by zero, unbound variables and non-finite
+// literals.
+std::optional<Decimal> evaluateDecimal(const Program &program,
+                                       std::span<const Decimal> variables = {});
+
+} // namespace calc
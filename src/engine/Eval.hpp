@@ -0,0 +1,113 @@
+#pragma once
+#include "engine/Compiler.hpp"
+#include "engine/Interpreter.hpp"
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace calc {
+
+// A string literal usable as a template argument: eval<"2 + 3 × 4">()
+template <std::size_t Size> struct FixedString {
+  char text[Size]{};
+
+  constexpr FixedString(const char (&literal)[Size]) {
+    std::copy_n(literal, Size, text);
+  }
+
+  constexpr std::string_view view() const { return {text, Size - 1}; }
+};
+
+// compile() and evaluate() in one call, usable in constant expressions:
+// the same compiler and interpreter as the run-time path, so the result
+// is bit for bit what Calculator shows for the expression
+constexpr std::optional<double>
+evaluateExpression(std::string_view source,
+                   std::span<const double> variables = {}) {
+  Program program;
+  if (!detail::Compiler(source, program).run(nullptr) ||
+      variables.size() < program.variables.size()) {
+    return std::nullopt;
+  }
+  std::vector<double> stack(program.maxDepth);
+  return interpret<double>(program, variables, stack.data());
+}
+
+// A compiled program in fixed-size arrays, so it can outlive the constant
+// evaluation that built it and be stored in a constexpr variable
+template <std::size_t CodeSize, std::size_t ConstantCount,
+          std::size_t VariableCount, std::size_t Depth>
+struct StaticProgram {
+  static constexpr std::size_t variableCount = VariableCount;
+  static constexpr std::size_t maxDepth = Depth;
+
+  std::array<Instruction, CodeSize> code{};
+  std::array<double, ConstantCount> constants{};
+
+  constexpr std::optional<double>
+  operator()(std::span<const double, VariableCount> variables) const {
+    std::array<double, (Depth > 0 ? Depth : 1)> stack{};
+    return interpret<double>(*this, std::span<const double>(variables),
+                             stack.data());
+  }
+
+  template <typename... Values>
+    requires(sizeof...(Values) == VariableCount &&
+             (std::is_arithmetic_v<Values> && ...))
+  constexpr std::optional<double> operator()(Values... values) const {
+    const std::array<double, VariableCount> bound{
+        static_cast<double>(values)...};
+    return (*this)(std::span<const double, VariableCount>(bound));
+  }
+};
+
+namespace detail {
+
+template <FixedString Source> constexpr auto compileStatic() {
+  // Compiled twice: once for the array sizes, once to fill them in
+  constexpr auto sizes = [] {
+    Program program;
+    return Compiler(Source.view(), program).run(nullptr)
+               ? std::array<std::size_t, 5>{1, program.code.size(),
+                                            program.constants.size(),
+                                            program.variables.size(),
+                                            program.maxDepth}
+               : std::array<std::size_t, 5>{};
+  }();
+  static_assert(sizes[0], "calc: expression does not compile");
+
+  StaticProgram<sizes[1], sizes[2], sizes[3], sizes[4]> result;
+  Program program;
+  Compiler(Source.view(), program).run(nullptr);
+  std::copy(program.code.begin(), program.code.end(), result.code.begin());
+  std::copy(program.constants.begin(), program.constants.end(),
+            result.constants.begin());
+  return result;
+}
+
+} // namespace detail
+
+// `Source` compiled at build time; call it with one double per variable,
+// in order of first use: formula<"price × (1 + rate%)">(100.0, 20.0)
+template <FixedString Source>
+inline constexpr auto formula = detail::compileStatic<Source>();
+
+// Value of a constant expression, computed at build time:
+// constexpr double x = eval<"2 + 3 × 4">(); // 14
+// Division by zero fails the build, as does a result that overflows to
+// infinity, since the compiler will not constant-fold that, and a call to
+// an aggregate function such as sum(), which only runs at run time.
+template <FixedString Source> constexpr double eval() {
+  static_assert(formula<Source>.variableCount == 0,
+                "calc::eval takes no variables; use calc::formula");
+  constexpr std::optional<double> value = formula<Source>();
+  static_assert(value.has_value(), "calc: division by zero");
+  return *value;
+}
+
+} // namespace calc
@@ -0,0 +1,54 @@
+#include "engine/Expression.hpp"
+#include "engine/Compiler.hpp"
+#include "engine/Eval.hpp"
+#include "engine/Interpreter.hpp"
+#include <array>
+
+namespace calc {
+
+namespace {
+
+// Operand stack size that lives on the native stack; deeper programs fall
+// back to a heap buffer
+constexpr std::size_t kInlineStack = 64;
+
+// The compiler and interpreter run at build time too (Eval.hpp); these
+// keep that path honest on precedence, percent and literal rounding
+static_assert(eval<"2 + 3 × 4">() == 14.0);
+static_assert(eval<"(2 + 3) * 4 - 10 / 4">() == 17.5);
+static_assert(eval<"0.1 + 0.2">() == 0.30000000000000004);
+static_assert(eval<"50% × -8">() == -4.0);
+static_assert(eval<"2.2250738585072011e-308">() == 2.2250738585072009e-308);
+static_assert(!evaluateExpression("1 ÷ (2 - 2)"));
+static_assert(!evaluateExpression("1 +"));
+
+} // namespace
+
+std::optional<Program> compile(std::string_view source, CompileError *error,
+                               const UnitTable *units) {
+  Program program;
+  if (!detail::Compiler(source, program, units).run(error)) {
+    return std::nullopt;
+  }
+  return program;
+}
+
+bool compile(std::string_view source, Program &program, CompileError *error,
+             const UnitTable *units) {
+  return detail::Compiler(source, program, units).run(error);
+}
+
+std::optional<double> evaluate(const Program &program,
+                               std::span<const double> variables) {
+  if (variables.size() < program.variables.size()) {
+    return std::nullopt;
+  }
+  if (program.maxDepth <= kInlineStack) {
+    std::array<double, kInlineStack> stack;
+    return interpret<double>(program, variables, stack.data());
+  }
+  std::vector<double> stack(program.maxDepth);
+  return interpret<double>(program, variables, stack.data());
+}
+
+} // namespace calc
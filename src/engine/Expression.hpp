@@ -0,0 +1,102 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace calc {
+
+enum class OpCode : std::uint8_t {
+  Push,     // Push constants[operand]
+  Load,     // Push the value bound to variables[operand]
+  Add,      // a b -> a + b
+  Subtract, // a b -> a - b
+  Multiply, // a b -> a × b
+  Divide,   // a b -> a ÷ b, fails when b is zero
+  Negate,   // a -> -a
+  Percent,  // a -> a / 100
+  Call,     // a1 ... an -> f(a1, ..., an), see callOperand()
+};
+
+// Aggregate functions of the expression language, called with one or more
+// arguments: sum(1, 2, 3). Percentile takes the percentage (0 to 100) first:
+// percentile(90, a, b, c).
+enum class Function : std::uint8_t {
+  Sum,
+  Mean,
+  Min,
+  Max,
+  Variance, // Sample variance, over n - 1
+  StdDev,   // Sample standard deviation
+  Median,
+  Percentile,
+};
+
+struct Instruction {
+  OpCode op;
+  std::uint32_t operand = 0;
+};
+
+// A Call's operand: the function in the low byte, the argument count above
+constexpr std::uint32_t kMaxArguments = 0xFFFFFF;
+
+constexpr std::uint32_t callOperand(Function function,
+                                    std::uint32_t arguments) {
+  return arguments << 8 | static_cast<std::uint32_t>(function);
+}
+
+constexpr Function calledFunction(std::uint32_t operand) {
+  return static_cast<Function>(operand & 0xFF);
+}
+
+constexpr std::uint32_t argumentCount(std::uint32_t operand) {
+  return operand >> 8;
+}
+
+// Flat postfix program produced by compile(). Instructions and constants are
+// stored contiguously so evaluating it again is a single pass over `code`.
+struct Program {
+  std::vector<Instruction> code;
+  std::vector<double> constants;
+  std::vector<std::string> literals; // Source text of each constant
+  std::vector<std::string> variables; // In order of first use
+  std::uint32_t maxDepth = 0; // Deepest operand stack the program needs
+};
+
+struct CompileError {
+  std::size_t position = 0; // Byte offset into the source
+  std::string message;
+};
+
+class UnitTable;
+
+// Compiles an infix expression using the keypad's symbols ("+", "-", "×",
+// "÷", "%") or their ASCII forms ("*", "/"). Multiplication and division
+// bind tighter than addition and subtraction; parentheses and unary minus
+// are supported, and a postfix "%" divides its operand by 100. Identifiers
+// such as `a` or `rate` become variables bound at evaluation time, unless
+// they name a Function followed by its argument list: mean(a, b, c).
+// Given a UnitTable, values may carry its units and the expression may end
+// in a conversion: "5 km + 300 m to mi". Units compile to multiplications
+// by their factors, so a program with units is ordinary arithmetic.
+std::optional<Program> compile(std::string_view source,
+                               CompileError *error = nullptr,
+                               const UnitTable *units = nullptr);
+
+// Same, into an existing `program` whose buffers are reused: compiling
+// expression after expression into one Program stops allocating once they
+// have grown large enough. On failure `program` is left partly filled.
+bool compile(std::string_view source, Program &program,
+             CompileError *error = nullptr, const UnitTable *units = nullptr);
+
+// Runs a compiled program on a stack machine. `variables` holds one value
+// per entry of program.variables. Returns std::nullopt when the program
+// divides by zero, a variable is left unbound or a function has no result
+// (the variance of a single value, a percentile outside 0 to 100).
+std::optional<double> evaluate(const Program &program,
+                               std::span<const double> variables = {});
+
+} // namespace calc
@@ -0,0 +1,77 @@
+#include "engine/Format.hpp"
+#include <charconv>
+#include <cmath>
+
+namespace calc {
+
+namespace {
+
+// Largest magnitude that still converts to long long without overflowing
+constexpr double kIntegralLimit = 9223372036854775807.0;
+
+bool isSpace(char c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' ||
+         c == '\v';
+}
+
+} // namespace
+
+std::string formatNumber(double number) {
+  NumberBuffer buffer;
+  return std::string(formatNumber(number, buffer));
+}
+
+std::string_view formatNumber(double number, NumberBuffer &buffer) {
+  // Format number to avoid unnecessary decimals
+  if (std::isfinite(number) && std::fabs(number) < kIntegralLimit &&
+      number == static_cast<double>(static_cast<long long>(number))) {
+    const auto [end, ec] = std::to_chars(
+        buffer.data(), buffer.data() + buffer.size(),
+        static_cast<long long>(number));
+    return {buffer.data(), static_cast<std::size_t>(end - buffer.data())};
+  }
+  return formatGeneral(number, buffer, 10);
+}
+
+void appendNumber(std::string &out, double number) {
+  NumberBuffer buffer;
+  out += formatNumber(number, buffer);
+}
+
+std::string formatGeneral(double number, int precision) {
+  NumberBuffer buffer;
+  return std::string(formatGeneral(number, buffer, precision));
+}
+
+std::string_view formatGeneral(double number, NumberBuffer &buffer,
+                               int precision) {
+  const auto [end, ec] =
+      std::to_chars(buffer.data(), buffer.data() + buffer.size(), number,
+                    std::chars_format::general, precision);
+  if (ec != std::errc()) {
+    return "0";
+  }
+  return {buffer.data(), static_cast<std::size_t>(end - buffer.data())};
+}
+
+double parseNumber(std::string_view text) {
+  while (!text.empty() && isSpace(text.front())) {
+    text.remove_prefix(1);
+  }
+  while (!text.empty() && isSpace(text.back())) {
+    text.remove_suffix(1);
+  }
+  if (!text.empty() && text.front() == '+') {
+    text.remove_prefix(1);
+  }
+
+  double value = 0.0;
+  const auto [end, ec] =
+      std::from_chars(text.data(), text.data() + text.size(), value);
+  if (ec != std::errc() || end != text.data() + text.size()) {
+    return 0.0;
+  }
+  return value;
+}
+
+} // namespace calc
@@ -0,0 +1,32 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace calc {
+
+// Stack storage for the allocation-free overloads below; large enough for
+// any double in general notation with up to 50 significant digits
+constexpr std::size_t kNumberBufferSize = 64;
+using NumberBuffer = std::array<char, kNumberBufferSize>;
+
+// Integral values print without decimals, everything else with up to 10
+// significant digits (the keypad's result format)
+std::string formatNumber(double number);
+std::string_view formatNumber(double number, NumberBuffer &buffer);
+
+// Appends formatNumber(number) to `out` without a temporary string
+void appendNumber(std::string &out, double number);
+
+// General ('g') notation with `precision` significant digits, matching
+// QString::number(double) when left at its default of 6
+std::string formatGeneral(double number, int precision = 6);
+std::string_view formatGeneral(double number, NumberBuffer &buffer,
+                               int precision = 6);
+
+// Parses display text the way QString::toDouble() does: surrounding
+// whitespace is ignored and anything unparsable reads as 0
+double parseNumber(std::string_view text);
+
+} // namespace calc
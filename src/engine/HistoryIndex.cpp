@@ -0,0 +1,144 @@
+#include "engine/HistoryIndex.hpp"
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+
+namespace calc {
+
+namespace {
+
+constexpr std::size_t kTrigram = 3;
+
+std::uint32_t trigramAt(const char *text) {
+  const auto byte = [text](int i) {
+    return std::uint32_t{static_cast<unsigned char>(text[i])};
+  };
+  return byte(0) << 16 | byte(1) << 8 | byte(2);
+}
+
+void appendTrigrams(std::string_view text, std::vector<std::uint32_t> &out) {
+  for (std::size_t i = 0; i + kTrigram <= text.size(); ++i) {
+    out.push_back(trigramAt(text.data() + i));
+  }
+}
+
+bool contains(const HistoryEntry &entry, std::string_view needle) {
+  // The texts are adjacent, so each is searched on its own to keep a
+  // match from straddling them
+  return entry.expression.find(needle) != std::string_view::npos ||
+         entry.result.find(needle) != std::string_view::npos;
+}
+
+} // namespace
+
+void HistoryIndex::add(const char *text, std::uint32_t expressionSize,
+                       std::uint32_t resultSize, bool stable) {
+  const std::unique_lock lock(mutex);
+  if (!stable) {
+    text = store(text, std::size_t{expressionSize} + resultSize);
+  }
+  const Slot slot{text, expressionSize, resultSize};
+  const auto number = static_cast<std::uint32_t>(slots.size());
+  slots.push_back(slot);
+
+  const HistoryEntry added = entryOf(slot);
+  scratch.clear();
+  appendTrigrams(added.expression, scratch);
+  appendTrigrams(added.result, scratch);
+  std::sort(scratch.begin(), scratch.end());
+  scratch.erase(std::unique(scratch.begin(), scratch.end()), scratch.end());
+  for (const std::uint32_t trigram : scratch) {
+    Postings &postings = trigrams[trigram];
+    std::uint32_t gap = number - postings.last;
+    while (gap >= 0x80) {
+      postings.deltas.push_back(static_cast<std::uint8_t>(gap | 0x80));
+      gap >>= 7;
+    }
+    postings.deltas.push_back(static_cast<std::uint8_t>(gap));
+    postings.last = number;
+    ++postings.count;
+  }
+}
+
+std::size_t HistoryIndex::size() const {
+  const std::shared_lock lock(mutex);
+  return slots.size();
+}
+
+HistoryEntry HistoryIndex::entry(std::size_t i) const {
+  const std::shared_lock lock(mutex);
+  return entryOf(slots[i]);
+}
+
+std::vector<std::size_t> HistoryIndex::search(std::string_view needle,
+                                              std::size_t limit) const {
+  const std::shared_lock lock(mutex);
+  std::vector<std::size_t> found;
+  if (needle.size() < kTrigram) {
+    for (std::size_t i = slots.size(); i-- > 0 && found.size() < limit;) {
+      if (contains(entryOf(slots[i]), needle)) {
+        found.push_back(i);
+      }
+    }
+    return found;
+  }
+
+  // Every match contains all of the needle's trigrams; the rarest one
+  // lists the fewest entries to check
+  const Postings *rarest = nullptr;
+  for (std::size_t i = 0; i + kTrigram <= needle.size(); ++i) {
+    const auto at = trigrams.find(trigramAt(needle.data() + i));
+    if (at == trigrams.end()) {
+      return found;
+    }
+    if (!rarest || at->second.count < rarest->count) {
+      rarest = &at->second;
+    }
+  }
+  std::vector<std::uint32_t> candidates;
+  candidates.reserve(rarest->count);
+  std::uint32_t number = 0;
+  for (std::size_t at = 0; at < rarest->deltas.size();) {
+    std::uint32_t gap = 0;
+    for (int shift = 0;; shift += 7) {
+      const std::uint8_t byte = rarest->deltas[at++];
+      gap |= static_cast<std::uint32_t>(byte & 0x7F) << shift;
+      if (byte < 0x80) {
+        break;
+      }
+    }
+    number += gap;
+    candidates.push_back(number);
+  }
+  for (auto i = candidates.rbegin();
+       i != candidates.rend() && found.size() < limit; ++i) {
+    if (contains(entryOf(slots[*i]), needle)) {
+      found.push_back(*i);
+    }
+  }
+  return found;
+}
+
+const char *HistoryIndex::store(const char *text, std::size_t size) {
+  if (size > kBlockBytes / 4) {
+    // Too big to share a block; the open block stays open for the next
+    auto &own = oversized.emplace_back(new char[size]);
+    std::memcpy(own.get(), text, size);
+    return own.get();
+  }
+  if (kBlockBytes - blockUsed < size) {
+    blocks.emplace_back(new char[kBlockBytes]);
+    blockUsed = 0;
+  }
+  char *into = blocks.back().get() + blockUsed;
+  std::memcpy(into, text, size);
+  blockUsed += size;
+  return into;
+}
+
+HistoryEntry HistoryIndex::entryOf(const Slot &slot) const {
+  return {{slot.text, slot.expressionSize},
+          {slot.text + slot.expressionSize, slot.resultSize}};
+}
+
+} // namespace calc
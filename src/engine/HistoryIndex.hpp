@@ -0,0 +1,78 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <shared_mutex>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace calc {
+
+// One completed calculation, e.g. {"2 + 3 × 4", "14"}
+struct HistoryEntry {
+  std::string_view expression;
+  std::string_view result;
+};
+
+// History entries in memory, for scrollback and search, with a trigram
+// index: every three-byte sequence of an expression or result lists the
+// entries that contain it. A search looks up the rarest trigram of its
+// needle and only checks the entries listed there, so it costs the number
+// of likely matches rather than the length of the history. Lists hold
+// varint deltas between entry numbers, a byte or two per entry each.
+//
+// One thread may add() while others read. Texts are stored in blocks that
+// never move, so the views entry() returns stay valid for the lifetime of
+// the index.
+class HistoryIndex {
+public:
+  HistoryIndex() = default;
+  HistoryIndex(const HistoryIndex &) = delete;
+  HistoryIndex &operator=(const HistoryIndex &) = delete;
+
+  // Adds the entry whose expression and result lie end to end at `text`.
+  // They are copied unless `stable`, which promises they outlive the index
+  // (as a mapped read-only log does).
+  void add(const char *text, std::uint32_t expressionSize,
+           std::uint32_t resultSize, bool stable = false);
+
+  std::size_t size() const;
+  HistoryEntry entry(std::size_t i) const;
+
+  // Indices of up to `limit` entries whose expression or result contains
+  // `needle`, newest first. Needles shorter than a trigram are too common
+  // to index; those scan the entries newest first until `limit` is met.
+  std::vector<std::size_t> search(std::string_view needle,
+                                  std::size_t limit = SIZE_MAX) const;
+
+private:
+  static constexpr std::size_t kBlockBytes = 1 << 20;
+
+  // Where an entry's texts are: the expression then the result, adjacent
+  struct Slot {
+    const char *text;
+    std::uint32_t expressionSize;
+    std::uint32_t resultSize;
+  };
+
+  struct Postings {
+    std::vector<std::uint8_t> deltas; // Varint gaps between entry numbers
+    std::uint32_t last = 0;           // Entry number of the newest
+    std::uint32_t count = 0;
+  };
+
+  mutable std::shared_mutex mutex;
+  std::vector<Slot> slots;
+  // Copied texts: small ones share blocks, larger ones get their own
+  std::vector<std::unique_ptr<char[]>> blocks;
+  std::vector<std::unique_ptr<char[]>> oversized;
+  std::size_t blockUsed = kBlockBytes; // Bytes of blocks.back() taken
+  std::unordered_map<std::uint32_t, Postings> trigrams;
+  std::vector<std::uint32_t> scratch; // The trigrams of the entry added
+
+  const char *store(const char *text, std::size_t size);
+  HistoryEntry entryOf(const Slot &slot) const;
+};
+
+} // namespace calc
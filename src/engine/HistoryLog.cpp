@@ -0,0 +1,414 @@
+#include "engine/HistoryLog.hpp"
+#include "engine/Batch.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <optional>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace calc {
+
+namespace {
+
+constexpr std::string_view kMagic{"CALCHST\x01", 8};
+constexpr std::size_t kSizesBytes = 8; // Two uint32 per entry
+constexpr auto kSyncInterval = std::chrono::seconds(1);
+
+std::uint32_t readSize(const char *bytes) {
+  std::uint32_t value = 0;
+  for (int i = 3; i >= 0; --i) {
+    value = value << 8 | static_cast<unsigned char>(bytes[i]);
+  }
+  return value;
+}
+
+void appendSize(std::string &out, std::uint32_t value) {
+  for (int i = 0; i < 4; ++i) {
+    out += static_cast<char>(value >> (8 * i) & 0xFF);
+  }
+}
+
+// Calls visit(text, expressionSize, resultSize) for every whole entry of
+// `bytes` from `start` (by default, after the magic) and returns where the
+// last one ends
+template <typename Visit>
+std::size_t forEachEntry(std::string_view bytes, Visit visit,
+                         std::size_t start = kMagic.size()) {
+  std::size_t valid = start;
+  while (bytes.size() - valid >= kSizesBytes) {
+    const std::uint32_t expression = readSize(bytes.data() + valid);
+    const std::uint32_t result = readSize(bytes.data() + valid + 4);
+    const std::size_t text = valid + kSizesBytes;
+    if (std::uint64_t{expression} + result > bytes.size() - text) {
+      break;
+    }
+    visit(bytes.data() + text, expression, result);
+    valid = text + expression + result;
+  }
+  return valid;
+}
+
+int openForAppend(const std::string &path) {
+#ifdef _WIN32
+  return _open(path.c_str(), _O_RDWR | _O_APPEND | _O_CREAT | _O_BINARY,
+               _S_IREAD | _S_IWRITE);
+#else
+  return ::open(path.c_str(), O_RDWR | O_APPEND | O_CREAT | O_CLOEXEC, 0644);
+#endif
+}
+
+void closeFile(int fd) {
+#ifdef _WIN32
+  _close(fd);
+#else
+  ::close(fd);
+#endif
+}
+
+std::int64_t fileSize(int fd) {
+#ifdef _WIN32
+  return _filelengthi64(fd);
+#else
+  struct stat status {};
+  return ::fstat(fd, &status) == 0 ? status.st_size : -1;
+#endif
+}
+
+void truncateFile(int fd, std::size_t size) {
+#ifdef _WIN32
+  _chsize_s(fd, static_cast<long long>(size));
+#else
+  while (::ftruncate(fd, static_cast<off_t>(size)) != 0 && errno == EINTR) {
+  }
+#endif
+}
+
+// One write() for the whole batch, so O_APPEND places it in one piece
+void writeFile(int fd, std::string_view bytes) {
+  while (!bytes.empty()) {
+#ifdef _WIN32
+    const int count = _write(fd, bytes.data(),
+                             static_cast<unsigned>(std::min<std::size_t>(
+                                 bytes.size(), 1U << 30)));
+#else
+    const ssize_t count = ::write(fd, bytes.data(), bytes.size());
+    if (count < 0 && errno == EINTR) {
+      continue;
+    }
+#endif
+    if (count <= 0) {
+      return;
+    }
+    bytes.remove_prefix(static_cast<std::size_t>(count));
+  }
+}
+
+void syncFile(int fd) {
+#ifdef _WIN32
+  _commit(fd);
+#else
+  ::fsync(fd);
+#endif
+}
+
+// Exclusive advisory lock on a log, held while checking its tail and
+// appending, so instances sharing the file take turns. Windows has no
+// flock(); there the single write per batch has to do.
+class FileLock {
+public:
+  explicit FileLock(int fd) : fd(fd) {
+#ifndef _WIN32
+    while (::flock(fd, LOCK_EX) != 0 && errno == EINTR) {
+    }
+#endif
+  }
+  ~FileLock() {
+#ifndef _WIN32
+    ::flock(fd, LOCK_UN);
+#endif
+  }
+
+  FileLock(const FileLock &) = delete;
+  FileLock &operator=(const FileLock &) = delete;
+
+private:
+  [[maybe_unused]] int fd;
+};
+
+} // namespace
+
+HistoryLog::HistoryLog(const std::string &path, bool readOnly) : path(path) {
+  if (readOnly) {
+    std::error_code ec;
+    if (!std::filesystem::exists(path, ec)) {
+      errorText = path + ": no such file";
+      return;
+    }
+    // Index every whole entry; a torn tail is left for the writer to drop
+    mapped = MappedFile(path);
+    if (!mapped.isOpen()) {
+      errorText = mapped.error();
+      return;
+    }
+    const std::string_view bytes = mapped.view();
+    if (bytes.size() >= kMagic.size()) {
+      if (!bytes.starts_with(kMagic)) {
+        errorText = path + ": not a calculator history";
+        return;
+      }
+      forEachEntry(bytes, [this](const char *text, std::uint32_t expression,
+                                 std::uint32_t result) {
+        entries.add(text, expression, result, true);
+      });
+    }
+    loaded.store(true, std::memory_order_release);
+    open = true;
+    return;
+  }
+
+  // Only the magic is read here; checking the entries is the writer's job
+  if (std::FILE *existing = std::fopen(path.c_str(), "rb")) {
+    char header[kMagic.size()];
+    const std::size_t read = std::fread(header, 1, sizeof(header), existing);
+    std::fclose(existing);
+    if (read == sizeof(header) && std::string_view(header, read) != kMagic) {
+      errorText = path + ": not a calculator history";
+      return;
+    }
+  }
+  fd = openForAppend(path);
+  if (fd < 0) {
+    errorText = path + ": " + std::strerror(errno);
+    return;
+  }
+  writer = std::thread(&HistoryLog::writeLoop, this);
+  open = true;
+}
+
+HistoryLog::~HistoryLog() {
+  {
+    const std::lock_guard lock(mutex);
+    stopping = true;
+  }
+  wake.notify_one();
+  if (writer.joinable()) {
+    writer.join();
+  }
+  if (fd >= 0) {
+    closeFile(fd);
+  }
+}
+
+void HistoryLog::append(std::string_view expression, std::string_view result) {
+  if (fd < 0) {
+    return;
+  }
+  const auto expressionSize = static_cast<std::uint32_t>(expression.size());
+  const auto resultSize = static_cast<std::uint32_t>(result.size());
+  {
+    const std::lock_guard lock(mutex);
+    appendSize(pending, expressionSize);
+    appendSize(pending, resultSize);
+    pending += expression;
+    pending += result;
+    queued += kSizesBytes + expression.size() + result.size();
+  }
+  wake.notify_one();
+}
+
+void HistoryLog::setListener(Listener next) {
+  const std::lock_guard lock(mutex);
+  listener = std::move(next);
+}
+
+void HistoryLog::flush() {
+  if (fd < 0) {
+    return;
+  }
+  std::unique_lock lock(mutex);
+  const std::uint64_t target = queued;
+  flushRequested = true;
+  wake.notify_one();
+  written.wait(lock, [&] { return synced >= target; });
+}
+
+void HistoryLog::recover() {
+  const FileLock exclusive(fd);
+  std::size_t size = 0;
+  std::size_t valid = 0;
+  {
+    // Unmapped again before truncating, which Windows refuses to do to a
+    // mapped file, so the entries are copied into the index
+    const MappedFile file(path);
+    const std::string_view bytes = file.view();
+    size = bytes.size();
+    if (bytes.size() >= kMagic.size()) {
+      if (!bytes.starts_with(kMagic)) {
+        return; // Replaced since it was opened; left alone
+      }
+      valid = forEachEntry(bytes, [this](const char *text,
+                                         std::uint32_t expression,
+                                         std::uint32_t result) {
+        entries.add(text, expression, result);
+      });
+    }
+  }
+  if (valid != size) {
+    truncateFile(fd, valid);
+  }
+}
+
+void HistoryLog::writeLoop() {
+  recover();
+  loaded.store(true, std::memory_order_release);
+  const auto notify = [this] {
+    std::unique_lock lock(mutex);
+    const Listener copy = listener;
+    lock.unlock();
+    if (copy) {
+      copy();
+    }
+  };
+  notify();
+
+  std::string batch;
+  std::uint64_t done = 0; // Bytes written, synced or not
+  auto lastSync = Clock::now();
+  std::unique_lock lock(mutex);
+  for (;;) {
+    const auto ready = [this] {
+      return !pending.empty() || flushRequested || stopping;
+    };
+    // Written but unsynced bytes get their fsync within kSyncInterval even
+    // if nothing else is appended
+    if (done > synced) {
+      wake.wait_until(lock, lastSync + kSyncInterval, ready);
+    } else {
+      wake.wait(lock, ready);
+    }
+    batch.swap(pending);
+    const std::uint64_t target = queued;
+    const bool stop = stopping;
+    const bool sync = flushRequested || stop ||
+                      Clock::now() - lastSync >= kSyncInterval;
+    flushRequested = false;
+    lock.unlock();
+
+    if (!batch.empty()) {
+      std::size_t start = 0; // Where the batch's entries begin
+      {
+        const FileLock exclusive(fd);
+        if (fileSize(fd) == 0) {
+          batch.insert(0, kMagic);
+          start = kMagic.size();
+        }
+        writeFile(fd, batch);
+      }
+      forEachEntry(
+          batch,
+          [this](const char *text, std::uint32_t expression,
+                 std::uint32_t result) {
+            entries.add(text, expression, result);
+          },
+          start);
+      batch.clear();
+      notify();
+    }
+    done = target;
+    if (sync) {
+      syncFile(fd);
+      lastSync = Clock::now();
+    }
+
+    lock.lock();
+    if (sync) {
+      synced = target;
+      written.notify_all();
+    }
+    if (stop && pending.empty()) {
+      return;
+    }
+  }
+}
+
+int runHistory(int argc, char *argv[]) {
+  static constexpr const char *kUsage =
+      "Usage: Calculator --history [--search TEXT] [--last N] FILE\n";
+  const char *path = nullptr;
+  const char *needle = nullptr;
+  std::size_t last = SIZE_MAX;
+  for (int i = 0; i < argc; ++i) {
+    const std::string_view arg = argv[i];
+    if (arg == "--search" && i + 1 < argc) {
+      needle = argv[++i];
+    } else if (arg == "--last" && i + 1 < argc) {
+      const std::optional<std::size_t> count = parseCount(argv[++i]);
+      if (!count) {
+        std::fprintf(stderr, "Calculator: invalid entry count '%s'\n",
+                     argv[i]);
+        std::fputs(kUsage, stderr);
+        return 2;
+      }
+      last = *count;
+    } else if (arg.starts_with("-") || path) {
+      std::fputs(kUsage, stderr);
+      return 2;
+    } else {
+      path = argv[i];
+    }
+  }
+  if (!path) {
+    std::fputs(kUsage, stderr);
+    return 2;
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+  const HistoryLog log(path, true);
+  if (!log.isOpen()) {
+    std::fprintf(stderr, "Calculator: %s\n", log.error().c_str());
+    return 1;
+  }
+  const auto opened = std::chrono::steady_clock::now();
+
+  std::vector<std::size_t> found;
+  if (needle) {
+    found = log.search(needle, last);
+  } else {
+    for (std::size_t i = log.size(); i-- > 0 && found.size() < last;) {
+      found.push_back(i);
+    }
+  }
+  const std::chrono::duration<double, std::milli> indexing = opened - start;
+  const std::chrono::duration<double, std::milli> searching =
+      std::chrono::steady_clock::now() - opened;
+
+  // Oldest first, like a terminal scrollback
+  std::string out;
+  for (auto i = found.rbegin(); i != found.rend(); ++i) {
+    const HistoryEntry entry = log.entry(*i);
+    out += entry.expression;
+    out += " = ";
+    out += entry.result;
+    out += '\n';
+  }
+  std::fwrite(out.data(), 1, out.size(), stdout);
+  std::fprintf(stderr,
+               "Calculator: %zu of %zu entries (indexed in %.1f ms, "
+               "searched in %.1f ms)\n",
+               found.size(), log.size(), indexing.count(), searching.count());
+  return 0;
+}
+
+} // namespace calc
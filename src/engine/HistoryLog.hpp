@@ -0,0 +1,103 @@
+#pragma once
+#include "engine/HistoryIndex.hpp"
+#include "engine/MappedFile.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace calc {
+
+// Append-only log of every completed calculation:
+//
+//   "CALCHST" 0x01          magic and format version
+//   size size expr result   per entry: expression and result byte counts
+//                           (little-endian uint32), then both texts
+//
+// A log opened for writing only appends: append() hands entries to a
+// writer thread, which writes each batch with one write() under O_APPEND
+// and an advisory lock, so instances sharing a file never interleave
+// entries, and fsyncs at most once a second. Opening does no more than
+// open the file; before its first write the writer drops a tail cut short
+// by a crash and loads the entries already there into the index, then
+// adds each batch it writes. append() never waits for the disk. Entries
+// other instances append later are in the file but not in this index.
+//
+// A log opened read-only maps the file and indexes it in the constructor,
+// with the texts left in the mapping.
+class HistoryLog {
+public:
+  // `readOnly` opens an existing log for searching without a writer
+  explicit HistoryLog(const std::string &path, bool readOnly = false);
+  ~HistoryLog();
+
+  HistoryLog(const HistoryLog &) = delete;
+  HistoryLog &operator=(const HistoryLog &) = delete;
+
+  bool isOpen() const { return open; }
+  const std::string &error() const { return errorText; }
+
+  void append(std::string_view expression, std::string_view result);
+
+  // Entries in the order they were appended; views stay valid for the
+  // lifetime of the log. Safe to call while the writer adds entries.
+  std::size_t size() const { return entries.size(); }
+  HistoryEntry entry(std::size_t i) const { return entries.entry(i); }
+
+  // Indices of up to `limit` entries whose expression or result contains
+  // `needle`, newest first (see HistoryIndex::search())
+  std::vector<std::size_t> search(std::string_view needle,
+                                  std::size_t limit = SIZE_MAX) const {
+    return entries.search(needle, limit);
+  }
+
+  // False while the writer is still loading the entries the file had
+  bool isLoaded() const { return loaded.load(std::memory_order_acquire); }
+
+  // Called on the writer thread whenever entries were added to the index,
+  // once the existing ones are loaded and after every batch
+  using Listener = std::function<void()>;
+  void setListener(Listener listener);
+
+  // Blocks until everything appended so far is written, synced and indexed
+  void flush();
+
+private:
+  using Clock = std::chrono::steady_clock;
+
+  bool open = false;
+  std::string errorText;
+  std::string path;
+  MappedFile mapped; // Read-only logs only
+  HistoryIndex entries;
+  std::atomic<bool> loaded{false};
+
+  // Shared with the writer thread
+  int fd = -1; // Opened for appending
+  std::mutex mutex;
+  std::condition_variable wake;
+  std::condition_variable written;
+  std::string pending;        // Encoded entries not yet handed over
+  std::uint64_t queued = 0;   // Bytes ever queued
+  std::uint64_t synced = 0;   // Bytes known to be on disk
+  bool flushRequested = false;
+  bool stopping = false;
+  Listener listener;
+  std::thread writer;
+
+  // Truncates the file after its last whole entry and indexes the entries
+  // before it
+  void recover();
+  void writeLoop();
+};
+
+// Entry point for `Calculator --history [--search TEXT] [--last N] FILE`
+int runHistory(int argc, char *argv[]);
+
+} // namespace calc
@@ -0,0 +1,112 @@
+#pragma once
+#include "engine/Expression.hpp"
+#include "engine/Statistics.hpp"
+#include <optional>
+#include <span>
+#include <utility>
+
+namespace calc {
+
+// Arithmetic a numeric backend provides to the interpreter:
+//   static std::optional<Number> constant(const Program &, std::uint32_t);
+//   static std::optional<Number> divide(const Number &, const Number &);
+//   static Number percent(const Number &);
+//   static std::optional<Number> call(Function, std::span<const Number>);
+// plus the usual +, - and × operators. Specialized for double below and for
+// Decimal in Decimal.cpp.
+template <typename Number> struct NumberTraits;
+
+// constexpr so that programs compiled at build time also run there
+template <> struct NumberTraits<double> {
+  // Any program type with a `constants` array (see StaticProgram)
+  template <typename ProgramType>
+  static constexpr std::optional<double> constant(const ProgramType &program,
+                                                  std::uint32_t index) {
+    return program.constants[index];
+  }
+
+  static constexpr std::optional<double> divide(double lhs, double rhs) {
+    if (rhs == 0.0) {
+      return std::nullopt;
+    }
+    return lhs / rhs;
+  }
+
+  static constexpr double percent(double value) { return value / 100.0; }
+
+  // Not constexpr: programs that call functions only run at run time
+  static std::optional<double> call(Function function,
+                                    std::span<const double> arguments) {
+    return aggregate(function, arguments);
+  }
+};
+
+// Runs `program` on a caller-provided stack of program.maxDepth entries.
+// Fails on division by zero or a constant the backend cannot represent.
+template <typename Number, typename ProgramType = Program>
+constexpr std::optional<Number> interpret(const ProgramType &program,
+                                          std::span<const Number> variables,
+                                          Number *stack) {
+  using Traits = NumberTraits<Number>;
+  Number *top = stack; // One past the topmost operand
+  for (const Instruction &instruction : program.code) {
+    switch (instruction.op) {
+    case OpCode::Push: {
+      auto value = Traits::constant(program, instruction.operand);
+      if (!value) {
+        return std::nullopt;
+      }
+      *top++ = std::move(*value);
+      break;
+    }
+    case OpCode::Load:
+      *top++ = variables[instruction.operand];
+      break;
+    case OpCode::Add:
+      --top;
+      top[-1] = top[-1] + top[0];
+      break;
+    case OpCode::Subtract:
+      --top;
+      top[-1] = top[-1] - top[0];
+      break;
+    case OpCode::Multiply:
+      --top;
+      top[-1] = top[-1] * top[0];
+      break;
+    case OpCode::Divide: {
+      --top;
+      auto quotient = Traits::divide(top[-1], top[0]);
+      if (!quotient) {
+        return std::nullopt;
+      }
+      top[-1] = std::move(*quotient);
+      break;
+    }
+    case OpCode::Negate:
+      top[-1] = -top[-1];
+      break;
+    case OpCode::Percent:
+      top[-1] = Traits::percent(top[-1]);
+      break;
+    case OpCode::Call: {
+      const std::uint32_t count = argumentCount(instruction.operand);
+      top -= count;
+      auto result =
+          Traits::call(calledFunction(instruction.operand),
+                       std::span<const Number>(top, count));
+      if (!result) {
+        return std::nullopt;
+      }
+      *top++ = std::move(*result);
+      break;
+    }
+    }
+  }
+  if (top == stack) {
+    return Number();
+  }
+  return std::move(top[-1]);
+}
+
+} // namespace calc
@@ -0,0 +1,402 @@
+#include "engine/Jit.hpp"
+#include "engine/Columnar.hpp"
+#include <algorithm>
+#include <cstring>
+#include <initializer_list>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#if defined(__x86_64__) && !defined(_WIN32)
+#define CALC_JIT 1
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace calc {
+
+namespace {
+
+// Copies `bytes` into fresh pages that are made executable (and no longer
+// writable) once filled; null when the system refuses executable memory
+void *mapCode(const std::vector<std::uint8_t> &bytes, std::size_t &mapped) {
+#ifdef CALC_JIT
+  const auto page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+  mapped = (bytes.size() + page - 1) / page * page;
+  void *memory = ::mmap(nullptr, mapped, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (memory == MAP_FAILED) {
+    return nullptr;
+  }
+  std::memcpy(memory, bytes.data(), bytes.size());
+  if (::mprotect(memory, mapped, PROT_READ | PROT_EXEC) != 0) {
+    ::munmap(memory, mapped);
+    return nullptr;
+  }
+  return memory;
+#else
+  (void)bytes;
+  mapped = 0;
+  return nullptr;
+#endif
+}
+
+void unmapCode(void *memory, std::size_t mapped) {
+#ifdef CALC_JIT
+  ::munmap(memory, mapped);
+#else
+  (void)memory;
+  (void)mapped;
+#endif
+}
+
+// General-purpose registers by encoding
+enum Gpr : std::uint8_t {
+  RAX = 0,
+  RCX = 1, // Argument 4: errors
+  RDX = 2, // Argument 3: values
+  RSI = 6, // Argument 2: rows
+  RDI = 7, // Argument 1: columns
+  R8 = 8,
+  R9 = 9,
+  R10 = 10,
+  R11 = 11,
+};
+
+// Operand stack slot i lives in xmm<i>; the last two registers hold zero
+// and whatever an instruction needs next to its operands
+constexpr std::uint8_t kZero = 14;
+constexpr std::uint8_t kScratch = 15;
+constexpr std::uint32_t kMaxDepth = kZero;
+
+// SSE2 opcodes (after 0F) and the prefixes that pick packed or scalar
+constexpr std::uint8_t kPacked = 0x66;
+constexpr std::uint8_t kScalar = 0xF2;
+constexpr std::uint8_t kLoad = 0x10;  // movupd / movsd xmm, m
+constexpr std::uint8_t kStore = 0x11; // movupd / movsd m, xmm
+constexpr std::uint8_t kMove = 0x28;  // movapd xmm, xmm
+constexpr std::uint8_t kMask = 0x50;  // movmskpd r32, xmm
+constexpr std::uint8_t kXor = 0x57;   // xorpd
+constexpr std::uint8_t kAdd = 0x58;
+constexpr std::uint8_t kMultiply = 0x59;
+constexpr std::uint8_t kSubtract = 0x5C;
+constexpr std::uint8_t kDivide = 0x5E;
+constexpr std::uint8_t kCompare = 0xC2; // cmppd / cmpsd, predicate in imm8
+
+// Just enough of an x86-64 assembler for the loop below. Constants are
+// placed after the code, 16 bytes each so packed loads fetch two copies.
+class Assembler {
+public:
+  std::vector<std::uint8_t> bytes;
+
+  void emit(std::initializer_list<std::uint8_t> list) {
+    bytes.insert(bytes.end(), list);
+  }
+
+  void emit32(std::uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+      bytes.push_back(static_cast<std::uint8_t>(value >> (8 * i)));
+    }
+  }
+
+  // op xmm<reg>, xmm<rm> (or op r32, xmm for movmskpd)
+  void sse(std::uint8_t prefix, std::uint8_t opcode, std::uint8_t reg,
+           std::uint8_t rm) {
+    bytes.push_back(prefix);
+    rex(false, reg, 0, rm);
+    emit({0x0F, opcode, modrm(3, reg, rm)});
+  }
+
+  // op xmm<reg>, [base + index × 8] (a store when opcode is kStore)
+  void sseIndexed(std::uint8_t prefix, std::uint8_t opcode, std::uint8_t reg,
+                  Gpr base, Gpr index) {
+    bytes.push_back(prefix);
+    rex(false, reg, index, base);
+    emit({0x0F, opcode, modrm(0, reg, 4), modrm(3, index, base)});
+  }
+
+  // op xmm<reg>, [constant], addressed relative to the instruction
+  void sseConstant(std::uint8_t prefix, std::uint8_t opcode, std::uint8_t reg,
+                   double value) {
+    bytes.push_back(prefix);
+    rex(false, reg, 0, 0);
+    emit({0x0F, opcode, modrm(0, reg, 5)});
+    fixups.push_back({bytes.size(), constantIndex(value)});
+    emit32(0);
+  }
+
+  // mov r64, [base + disp32]
+  void load(Gpr reg, Gpr base, std::uint32_t displacement) {
+    rex(true, reg, 0, base);
+    emit({0x8B, modrm(2, reg, base)});
+    emit32(displacement);
+  }
+
+  // op r/m, reg for the two-operand integer instructions (mov 89, xor 31,
+  // or 09, cmp 39)
+  void integer(bool wide, std::uint8_t opcode, Gpr rm, Gpr reg) {
+    rex(wide, reg, 0, rm);
+    emit({opcode, modrm(3, reg, rm)});
+  }
+
+  // op r/m, imm8 for group-1 instructions (add /0, and /4)
+  void immediate(bool wide, std::uint8_t extension, Gpr rm,
+                 std::int8_t value) {
+    rex(wide, 0, 0, rm);
+    emit({0x83, modrm(3, extension, rm), static_cast<std::uint8_t>(value)});
+  }
+
+  // mov byte [rcx + rax + displacement], r<reg>b
+  void storeErrorByte(Gpr reg, std::uint8_t displacement) {
+    rex(false, reg, 0, RCX);
+    if (displacement == 0) {
+      emit({0x88, modrm(0, reg, 4), modrm(0, RAX, RCX)});
+    } else {
+      emit({0x88, modrm(1, reg, 4), modrm(0, RAX, RCX), displacement});
+    }
+  }
+
+  // Jump with a 32-bit displacement patched by bind(); returns its slot
+  std::size_t jump(bool ifAboveOrEqual) {
+    if (ifAboveOrEqual) {
+      emit({0x0F, 0x83});
+    } else {
+      bytes.push_back(0xE9);
+    }
+    const std::size_t slot = bytes.size();
+    emit32(0);
+    return slot;
+  }
+
+  void bind(std::size_t slot, std::size_t target) {
+    patch(slot, static_cast<std::uint32_t>(target - (slot + 4)));
+  }
+
+  // Appends the constants and resolves every reference to them
+  void finish() {
+    while (bytes.size() % 16 != 0) {
+      bytes.push_back(0xCC);
+    }
+    const std::size_t pool = bytes.size();
+    for (const double value : constants) {
+      std::uint8_t pair[16];
+      std::memcpy(pair, &value, 8);
+      std::memcpy(pair + 8, &value, 8);
+      bytes.insert(bytes.end(), pair, pair + 16);
+    }
+    for (const Fixup &fixup : fixups) {
+      bind(fixup.slot, pool + 16 * fixup.constant);
+    }
+  }
+
+private:
+  struct Fixup {
+    std::size_t slot;
+    std::size_t constant;
+  };
+  std::vector<double> constants;
+  std::vector<Fixup> fixups;
+
+  static std::uint8_t modrm(int mod, int reg, int rm) {
+    return static_cast<std::uint8_t>(mod << 6 | (reg & 7) << 3 | (rm & 7));
+  }
+
+  void rex(bool wide, int reg, int index, int base) {
+    const int bits =
+        (wide ? 8 : 0) | (reg & 8) >> 1 | (index & 8) >> 2 | (base & 8) >> 3;
+    if (bits) {
+      bytes.push_back(static_cast<std::uint8_t>(0x40 | bits));
+    }
+  }
+
+  void patch(std::size_t slot, std::uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+      bytes[slot + i] = static_cast<std::uint8_t>(value >> (8 * i));
+    }
+  }
+
+  // Bitwise, so -0.0 and 0.0 (or two NaNs) stay distinct
+  std::size_t constantIndex(double value) {
+    for (std::size_t i = 0; i < constants.size(); ++i) {
+      if (std::memcmp(&constants[i], &value, sizeof(value)) == 0) {
+        return i;
+      }
+    }
+    constants.push_back(value);
+    return constants.size() - 1;
+  }
+};
+
+// One row (scalar) or two (packed) of the program, leaving the result in
+// xmm0 and the rows that divided by zero as bits of r11d
+void emitRows(Assembler &out, const Program &program, std::uint8_t prefix) {
+  std::uint8_t top = 0; // Register above the topmost operand
+  for (const Instruction &instruction : program.code) {
+    switch (instruction.op) {
+    case OpCode::Push:
+      out.sseConstant(prefix, kLoad, top++,
+                      program.constants[instruction.operand]);
+      break;
+    case OpCode::Load:
+      out.load(R10, RDI, 8 * instruction.operand);
+      out.sseIndexed(prefix, kLoad, top++, R10, RAX);
+      break;
+    case OpCode::Add:
+      --top;
+      out.sse(prefix, kAdd, top - 1, top);
+      break;
+    case OpCode::Subtract:
+      --top;
+      out.sse(prefix, kSubtract, top - 1, top);
+      break;
+    case OpCode::Multiply:
+      --top;
+      out.sse(prefix, kMultiply, top - 1, top);
+      break;
+    case OpCode::Divide:
+      --top;
+      // Flag divisors equal to zero (NaN is not), then divide anyway
+      out.sse(kPacked, kMove, kScratch, top);
+      out.sse(prefix, kCompare, kScratch, kZero);
+      out.bytes.push_back(0); // Predicate: equal
+      out.sse(kPacked, kMask, R8, kScratch);
+      out.integer(false, 0x09, R11, R8);
+      out.sse(prefix, kDivide, top - 1, top);
+      break;
+    case OpCode::Negate:
+      out.sseConstant(kPacked, kLoad, kScratch, -0.0);
+      out.sse(kPacked, kXor, top - 1, kScratch);
+      break;
+    case OpCode::Percent:
+      out.sseConstant(prefix, kLoad, kScratch, 100.0);
+      out.sse(prefix, kDivide, top - 1, kScratch);
+      break;
+    case OpCode::Call:
+      break; // Rejected by NativeProgram::compile()
+    }
+  }
+}
+
+// void run(const double *const *columns, size_t rows, double *values,
+//          uint8_t *errors), with rax as the row index:
+//
+//          xorpd xmm14, xmm14; xor eax, eax; r9 = rows & ~1
+//   pairs: if rax >= r9 goto tail
+//          r11d = 0; <packed rows>; values[rax..rax+1] = xmm0
+//          errors[rax] = r11d & 1; errors[rax + 1] = r11d >> 1 & 1
+//          rax += 2; goto pairs
+//   tail:  if rax >= rows return
+//          r11d = 0; <scalar row>; values[rax] = xmm0
+//          errors[rax] = r11d & 1; return
+std::vector<std::uint8_t> assemble(const Program &program) {
+  Assembler out;
+  out.sse(kPacked, kXor, kZero, kZero);
+  out.integer(false, 0x31, RAX, RAX);
+  out.integer(true, 0x89, R9, RSI);
+  out.immediate(true, 4, R9, -2);
+
+  const std::size_t pairs = out.bytes.size();
+  out.integer(true, 0x39, RAX, R9);
+  const std::size_t toTail = out.jump(true);
+  out.integer(false, 0x31, R11, R11);
+  emitRows(out, program, kPacked);
+  out.sseIndexed(kPacked, kStore, 0, RDX, RAX);
+  out.integer(false, 0x89, R8, R11);
+  out.immediate(false, 4, R8, 1);
+  out.storeErrorByte(R8, 0);
+  out.emit({0x41, 0xD1, 0xEB}); // shr r11d, 1
+  out.immediate(false, 4, R11, 1);
+  out.storeErrorByte(R11, 1);
+  out.immediate(true, 0, RAX, 2);
+  out.bind(out.jump(false), pairs);
+
+  out.bind(toTail, out.bytes.size());
+  out.integer(true, 0x39, RAX, RSI);
+  const std::size_t toEnd = out.jump(true);
+  out.integer(false, 0x31, R11, R11);
+  emitRows(out, program, kScalar);
+  out.sseIndexed(kScalar, kStore, 0, RDX, RAX);
+  out.immediate(false, 4, R11, 1);
+  out.storeErrorByte(R11, 0);
+  out.bind(toEnd, out.bytes.size());
+  out.bytes.push_back(0xC3); // ret
+
+  out.finish();
+  return std::move(out.bytes);
+}
+
+} // namespace
+
+std::unique_ptr<NativeProgram> NativeProgram::compile(const Program &program) {
+#ifdef CALC_JIT
+  // Aggregate calls are left to the interpreter
+  if (program.code.empty() || program.maxDepth > kMaxDepth ||
+      std::any_of(program.code.begin(), program.code.end(),
+                  [](const Instruction &instruction) {
+                    return instruction.op == OpCode::Call;
+                  })) {
+    return nullptr;
+  }
+  const std::vector<std::uint8_t> bytes = assemble(program);
+  std::size_t mapped = 0;
+  void *memory = mapCode(bytes, mapped);
+  if (!memory) {
+    return nullptr;
+  }
+  return std::unique_ptr<NativeProgram>(
+      new NativeProgram(memory, mapped, bytes.size()));
+#else
+  (void)program;
+  return nullptr;
+#endif
+}
+
+NativeProgram::NativeProgram(void *memory, std::size_t mapped,
+                             std::size_t size)
+    : memory(memory), mapped(mapped), size(size),
+      entry(reinterpret_cast<Entry>(memory)) {}
+
+NativeProgram::~NativeProgram() { unmapCode(memory, mapped); }
+
+void NativeProgram::run(std::span<const double *const> columns,
+                        std::size_t rows, double *values,
+                        std::uint8_t *errors) const {
+  entry(columns.data(), rows, values, errors);
+  for (std::size_t i = 0; i < rows; ++i) {
+    if (errors[i]) {
+      values[i] = std::numeric_limits<double>::quiet_NaN();
+    }
+  }
+}
+
+HotProgram::HotProgram(Program program, bool jit)
+    : source(std::move(program)), jit(jit) {}
+
+HotProgram::~HotProgram() = default;
+
+bool HotProgram::evaluateColumns(std::span<const double *const> columns,
+                                 std::size_t rows, double *values,
+                                 std::uint8_t *errors) {
+  if (columns.size() < source.variables.size()) {
+    return false;
+  }
+  const NativeProgram *compiledCode = native.load(std::memory_order_acquire);
+  if (!compiledCode && jit &&
+      rowCount.fetch_add(rows, std::memory_order_relaxed) + rows >=
+          kHotRows) {
+    // Whoever gets here first compiles; a program that cannot be compiled
+    // stays on the interpreter for good
+    std::call_once(compiled, [this] {
+      code = NativeProgram::compile(source);
+      native.store(code.get(), std::memory_order_release);
+    });
+    compiledCode = native.load(std::memory_order_acquire);
+  }
+  if (!compiledCode) {
+    return calc::evaluateColumns(source, columns, rows, values, errors);
+  }
+  compiledCode->run(columns, rows, values, errors);
+  return true;
+}
+
+} // namespace calc
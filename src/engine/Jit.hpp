@@ -0,0 +1,79 @@
+#pragma once
+#include "engine/Expression.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <span>
+
+namespace calc {
+
+// Machine code for one program: the native counterpart of
+// evaluateColumns(), with the same results bit for bit. Each row is
+// evaluated in SSE2 registers, two rows at a time, so nothing touches
+// memory between loading the operands and storing the result.
+//
+// Only x86-64 System V (Linux, macOS) is supported; elsewhere, and for
+// programs whose operand stack outgrows the registers or that call an
+// aggregate function, compile() returns nullptr and callers keep
+// interpreting.
+class NativeProgram {
+public:
+  static std::unique_ptr<NativeProgram> compile(const Program &program);
+  ~NativeProgram();
+
+  NativeProgram(const NativeProgram &) = delete;
+  NativeProgram &operator=(const NativeProgram &) = delete;
+
+  // Same contract as evaluateColumns(); `columns` must hold one pointer
+  // per program variable
+  void run(std::span<const double *const> columns, std::size_t rows,
+           double *values, std::uint8_t *errors) const;
+
+  std::size_t codeSize() const { return size; }
+
+private:
+  using Entry = void (*)(const double *const *columns, std::size_t rows,
+                         double *values, std::uint8_t *errors);
+
+  NativeProgram(void *memory, std::size_t mapped, std::size_t size);
+
+  void *memory;
+  std::size_t mapped; // Bytes mapped, a whole number of pages
+  std::size_t size;   // Bytes of code and constants
+  Entry entry;
+};
+
+// A program evaluated over columns that counts the rows it has run and,
+// once that passes kHotRows, switches from the interpreter to a
+// NativeProgram. Safe to share between the threads of a parallel batch.
+class HotProgram {
+public:
+  // Below this, compiling costs more than interpreting saves
+  static constexpr std::uint64_t kHotRows = 1 << 16;
+
+  explicit HotProgram(Program program, bool jit = true);
+  ~HotProgram();
+
+  HotProgram(const HotProgram &) = delete;
+  HotProgram &operator=(const HotProgram &) = delete;
+
+  const Program &program() const { return source; }
+  bool isNative() const { return native.load() != nullptr; }
+
+  // evaluateColumns() on whichever engine the program is hot enough for
+  bool evaluateColumns(std::span<const double *const> columns,
+                       std::size_t rows, double *values,
+                       std::uint8_t *errors);
+
+private:
+  Program source;
+  bool jit;
+  std::atomic<std::uint64_t> rowCount{0};
+  std::once_flag compiled;
+  std::unique_ptr<NativeProgram> code;
+  std::atomic<const NativeProgram *> native{nullptr};
+};
+
+} // namespace calc
@@ -0,0 +1,98 @@
+#include "engine/Latency.hpp"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+namespace calc {
+
+int LatencyHistogram::bucketOf(std::uint64_t value) {
+  if (value < kSubBuckets) {
+    return static_cast<int>(value);
+  }
+  // Keep the top kSubBucketBits bits; the shift picks the power of two
+  const int shift = std::bit_width(value) - kSubBucketBits;
+  return shift * kHalf + static_cast<int>(value >> shift);
+}
+
+std::uint64_t LatencyHistogram::highestIn(int bucket) {
+  if (bucket < kSubBuckets) {
+    return static_cast<std::uint64_t>(bucket);
+  }
+  const int shift = bucket / kHalf - 1;
+  const auto top = static_cast<std::uint64_t>(bucket - shift * kHalf);
+  return ((top + 1) << shift) - 1; // Wraps to UINT64_MAX for the last one
+}
+
+void LatencyHistogram::record(std::uint64_t nanoseconds) {
+  ++counts[static_cast<std::size_t>(bucketOf(nanoseconds))];
+  ++total;
+  minimum = std::min(minimum, nanoseconds);
+  maximum = std::max(maximum, nanoseconds);
+  sum += static_cast<double>(nanoseconds);
+}
+
+void LatencyHistogram::reset() { *this = LatencyHistogram(); }
+
+double LatencyHistogram::mean() const {
+  return total ? sum / static_cast<double>(total) : 0.0;
+}
+
+std::uint64_t LatencyHistogram::valueAt(double percentile) const {
+  if (!total) {
+    return 0;
+  }
+  const double wanted =
+      std::ceil(std::clamp(percentile, 0.0, 100.0) / 100.0 *
+                static_cast<double>(total));
+  const auto target = std::max<std::uint64_t>(
+      1, static_cast<std::uint64_t>(wanted));
+  std::uint64_t seen = 0;
+  for (int bucket = 0; bucket < kBucketCount; ++bucket) {
+    seen += counts[static_cast<std::size_t>(bucket)];
+    if (seen >= target) {
+      return std::clamp(highestIn(bucket), min(), maximum);
+    }
+  }
+  return maximum;
+}
+
+void LatencyMonitor::record(LatencyStage stage, Clock::duration elapsed) {
+  const auto nanoseconds =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+  histograms[static_cast<std::size_t>(stage)].record(
+      nanoseconds > 0 ? static_cast<std::uint64_t>(nanoseconds) : 0);
+}
+
+void LatencyMonitor::reset() {
+  for (LatencyHistogram &histogram : histograms) {
+    histogram.reset();
+  }
+}
+
+void LatencyMonitor::report(std::FILE *out) const {
+  static constexpr const char *names[kLatencyStageCount] = {
+      "dispatch", "calculate", "preview", "refresh", "paint", "total"};
+  static constexpr double percentiles[] = {50.0, 90.0, 99.0, 99.9};
+
+  std::fprintf(out, "%-10s %9s %10s %10s %10s %10s %10s %10s\n", "latency",
+               "count", "mean", "p50", "p90", "p99", "p99.9", "max");
+  for (std::size_t stage = 0; stage < kLatencyStageCount; ++stage) {
+    const LatencyHistogram &histogram = histograms[stage];
+    if (!histogram.count()) {
+      continue;
+    }
+    // Microseconds read best for everything from a digit to a repaint
+    std::fprintf(out, "%-10s %9llu %8.1fus", names[stage],
+                 static_cast<unsigned long long>(histogram.count()),
+                 histogram.mean() / 1e3);
+    for (const double percentile : percentiles) {
+      std::fprintf(out, " %8.1fus",
+                   static_cast<double>(histogram.valueAt(percentile)) / 1e3);
+    }
+    std::fprintf(out, " %8.1fus\n",
+                 static_cast<double>(histogram.max()) / 1e3);
+  }
+  std::fflush(out);
+}
+
+} // namespace calc
@@ -0,0 +1,100 @@
+#pragma once
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+
+namespace calc {
+
+// HDR-style histogram of nanosecond latencies. Values below 128 ns get a
+// bucket each; above that every power of two is split into 64 linear
+// buckets, so any recorded value is known to within 1/64 (1.6%) across
+// the whole 64-bit range. Recording is a bit scan and an increment, with
+// no allocation, so it can stay on in production.
+class LatencyHistogram {
+public:
+  void record(std::uint64_t nanoseconds);
+  void reset();
+
+  std::uint64_t count() const { return total; }
+  std::uint64_t min() const { return total ? minimum : 0; }
+  std::uint64_t max() const { return maximum; }
+  double mean() const;
+
+  // Smallest recorded value that `percentile` (0-100) percent of samples
+  // are at or below, rounded up to the top of its bucket
+  std::uint64_t valueAt(double percentile) const;
+
+private:
+  static constexpr int kSubBucketBits = 7;
+  static constexpr int kSubBuckets = 1 << kSubBucketBits;
+  static constexpr int kHalf = kSubBuckets / 2;
+  static constexpr int kBucketCount =
+      (64 - kSubBucketBits) * kHalf + kSubBuckets;
+
+  std::array<std::uint64_t, kBucketCount> counts{};
+  std::uint64_t total = 0;
+  std::uint64_t minimum = UINT64_MAX;
+  std::uint64_t maximum = 0;
+  double sum = 0.0;
+
+  static int bucketOf(std::uint64_t value);
+  static std::uint64_t highestIn(int bucket);
+};
+
+// Where the time between an input event and the repaint it causes goes
+enum class LatencyStage : std::uint8_t {
+  Dispatch,  // Session::dispatch() as a whole
+  Calculate, // Session::calculate()
+  Preview,   // Session::updatePreview()
+  Refresh,   // Copying the session state into the widgets
+  Paint,     // From the refresh until the display has repainted
+  Total,     // From the input event until the display has repainted
+};
+
+inline constexpr std::size_t kLatencyStageCount = 6;
+
+// One histogram per stage, plus the report written by --latency
+class LatencyMonitor {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  void record(LatencyStage stage, Clock::duration elapsed);
+  const LatencyHistogram &histogram(LatencyStage stage) const {
+    return histograms[static_cast<std::size_t>(stage)];
+  }
+  void reset();
+
+  // Table of count, mean and percentiles per stage; stages without
+  // samples are left out
+  void report(std::FILE *out) const;
+
+private:
+  std::array<LatencyHistogram, kLatencyStageCount> histograms;
+};
+
+// Times its scope into `monitor`; does nothing when it is null
+class ScopedLatency {
+public:
+  ScopedLatency(LatencyMonitor *monitor, LatencyStage stage)
+      : monitor(monitor), stage(stage) {
+    if (monitor) {
+      start = LatencyMonitor::Clock::now();
+    }
+  }
+  ~ScopedLatency() {
+    if (monitor) {
+      monitor->record(stage, LatencyMonitor::Clock::now() - start);
+    }
+  }
+
+  ScopedLatency(const ScopedLatency &) = delete;
+  ScopedLatency &operator=(const ScopedLatency &) = delete;
+
+private:
+  LatencyMonitor *monitor;
+  LatencyStage stage;
+  LatencyMonitor::Clock::time_point start;
+};
+
+} // namespace calc
@@ -0,0 +1,134 @@
+#include "engine/MappedFile.hpp"
+#include <utility>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace calc {
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const std::string &path) {
+  HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                            nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN,
+                            nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    errorText = "cannot open " + path;
+    return;
+  }
+  if (GetFileType(file) != FILE_TYPE_DISK) {
+    errorText = path + ": not a regular file";
+    CloseHandle(file);
+    return;
+  }
+  LARGE_INTEGER fileSize{};
+  GetFileSizeEx(file, &fileSize);
+  size = static_cast<std::size_t>(fileSize.QuadPart);
+  if (size > 0) {
+    HANDLE mapping =
+        CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping) {
+      data = static_cast<const char *>(
+          MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+      CloseHandle(mapping);
+    }
+    if (!data) {
+      errorText = "cannot map " + path;
+      size = 0;
+      CloseHandle(file);
+      return;
+    }
+  }
+  CloseHandle(file);
+  open = true;
+}
+
+void MappedFile::close() {
+  if (data) {
+    UnmapViewOfFile(data);
+  }
+  data = nullptr;
+  size = 0;
+  open = false;
+}
+
+#else
+
+MappedFile::MappedFile(const std::string &path) {
+  const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    errorText = path + ": " + std::strerror(errno);
+    return;
+  }
+  struct stat info {};
+  if (::fstat(fd, &info) != 0) {
+    errorText = path + ": " + std::strerror(errno);
+    ::close(fd);
+    return;
+  }
+  if (!S_ISREG(info.st_mode)) {
+    errorText = path + ": not a regular file";
+    ::close(fd);
+    return;
+  }
+  size = static_cast<std::size_t>(info.st_size);
+  if (size > 0) {
+    void *mapped = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapped == MAP_FAILED) {
+      errorText = path + ": " + std::strerror(errno);
+      size = 0;
+      ::close(fd);
+      return;
+    }
+    ::madvise(mapped, size, MADV_SEQUENTIAL);
+    data = static_cast<const char *>(mapped);
+  }
+  ::close(fd);
+  open = true;
+}
+
+void MappedFile::close() {
+  if (data) {
+    ::munmap(const_cast<char *>(data), size);
+  }
+  data = nullptr;
+  size = 0;
+  open = false;
+}
+
+#endif
+
+MappedFile::~MappedFile() { close(); }
+
+MappedFile::MappedFile(MappedFile &&other) noexcept
+    : data(std::exchange(other.data, nullptr)),
+      size(std::exchange(other.size, 0)),
+      open(std::exchange(other.open, false)),
+      errorText(std::move(other.errorText)) {}
+
+MappedFile &MappedFile::operator=(MappedFile &&other) noexcept {
+  if (this != &other) {
+    close();
+    data = std::exchange(other.data, nullptr);
+    size = std::exchange(other.size, 0);
+    open = std::exchange(other.open, false);
+    errorText = std::move(other.errorText);
+  }
+  return *this;
+}
+
+} // namespace calc
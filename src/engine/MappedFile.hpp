@@ -0,0 +1,37 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace calc {
+
+// Read-only memory mapping of a whole file. Empty files map to an empty
+// view; a failed open leaves the object invalid with error() describing why.
+// Pipes, FIFOs and devices have no size to map and fail to open rather
+// than reading as empty.
+class MappedFile {
+public:
+  MappedFile() = default;
+  explicit MappedFile(const std::string &path);
+  ~MappedFile();
+
+  MappedFile(MappedFile &&other) noexcept;
+  MappedFile &operator=(MappedFile &&other) noexcept;
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  bool isOpen() const { return open; }
+  const std::string &error() const { return errorText; }
+
+  std::string_view view() const { return {data, size}; }
+
+private:
+  const char *data = nullptr;
+  std::size_t size = 0;
+  bool open = false;
+  std::string errorText;
+
+  void close();
+};
+
+} // namespace calc
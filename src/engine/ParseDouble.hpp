@@ -0,0 +1,367 @@
+#pragma once
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string_view>
+
+namespace calc {
+
+struct ParsedDouble {
+  double value = 0.0;
+  std::size_t length = 0; // Characters consumed; 0 when there is no number
+};
+
+namespace detail {
+
+// Unsigned integer of up to 4480 bits, enough for the exact ratio of any
+// decimal literal parseDouble() does not cut off as zero or infinity
+class BigInteger {
+public:
+  constexpr void multiplyAdd(std::uint32_t factor, std::uint32_t addend) {
+    std::uint64_t carry = addend;
+    for (std::size_t i = 0; i < size; ++i) {
+      const std::uint64_t product = std::uint64_t{limbs[i]} * factor + carry;
+      limbs[i] = static_cast<std::uint32_t>(product);
+      carry = product >> 32;
+    }
+    if (carry) {
+      limbs[size++] = static_cast<std::uint32_t>(carry);
+    }
+  }
+
+  constexpr void multiplyPow10(std::size_t exponent) {
+    constexpr std::uint32_t kPowers[] = {1,      10,      100,      1000,
+                                         10000,  100000,  1000000,  10000000,
+                                         100000000};
+    for (; exponent >= 9; exponent -= 9) {
+      multiplyAdd(1000000000, 0);
+    }
+    multiplyAdd(kPowers[exponent], 0);
+  }
+
+  constexpr void shiftLeft(std::size_t bits) {
+    const std::size_t words = bits / 32;
+    const unsigned rest = bits % 32;
+    if (size == 0) {
+      return;
+    }
+    if (rest) {
+      std::uint32_t carry = 0;
+      for (std::size_t i = 0; i < size; ++i) {
+        const std::uint32_t next = limbs[i] >> (32 - rest);
+        limbs[i] = limbs[i] << rest | carry;
+        carry = next;
+      }
+      if (carry) {
+        limbs[size++] = carry;
+      }
+    }
+    if (words) {
+      for (std::size_t i = size; i-- > 0;) {
+        limbs[i + words] = limbs[i];
+      }
+      for (std::size_t i = 0; i < words; ++i) {
+        limbs[i] = 0;
+      }
+      size += words;
+    }
+  }
+
+  constexpr void shiftRightOne() {
+    for (std::size_t i = 0; i < size; ++i) {
+      limbs[i] = limbs[i] >> 1 | (i + 1 < size ? limbs[i + 1] << 31 : 0);
+    }
+    trim();
+  }
+
+  constexpr int compare(const BigInteger &other) const {
+    if (size != other.size) {
+      return size < other.size ? -1 : 1;
+    }
+    for (std::size_t i = size; i-- > 0;) {
+      if (limbs[i] != other.limbs[i]) {
+        return limbs[i] < other.limbs[i] ? -1 : 1;
+      }
+    }
+    return 0;
+  }
+
+  // Requires *this >= other
+  constexpr void subtract(const BigInteger &other) {
+    std::int64_t borrow = 0;
+    for (std::size_t i = 0; i < size; ++i) {
+      std::int64_t difference = std::int64_t{limbs[i]} - borrow -
+                                (i < other.size ? other.limbs[i] : 0);
+      borrow = difference < 0;
+      difference += borrow << 32;
+      limbs[i] = static_cast<std::uint32_t>(difference);
+    }
+    trim();
+  }
+
+  constexpr std::size_t bitLength() const {
+    return size == 0 ? 0
+                     : 32 * (size - 1) +
+                           static_cast<std::size_t>(
+                               std::bit_width(limbs[size - 1]));
+  }
+
+  constexpr bool isZero() const { return size == 0; }
+
+private:
+  std::array<std::uint32_t, 140> limbs{};
+  std::size_t size = 0;
+
+  constexpr void trim() {
+    while (size > 0 && limbs[size - 1] == 0) {
+      --size;
+    }
+  }
+};
+
+constexpr bool isDigit(char c) { return c >= '0' && c <= '9'; }
+
+constexpr bool startsWithIgnoringCase(std::string_view text,
+                                      std::string_view lower) {
+  if (text.size() < lower.size()) {
+    return false;
+  }
+  for (std::size_t i = 0; i < lower.size(); ++i) {
+    if ((text[i] | 0x20) != lower[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Doubles 10^0 to 10^22, all exactly representable
+constexpr std::array<double, 23> kExactPowers = [] {
+  std::array<double, 23> powers{};
+  double power = 1.0;
+  for (double &entry : powers) {
+    entry = power;
+    power *= 10.0;
+  }
+  return powers;
+}();
+
+// Significant digits kept by the exact path; any halfway point between two
+// doubles has fewer, so later digits only matter as "nonzero or not"
+constexpr std::size_t kMaxDigits = 780;
+
+// Correctly rounds `digits` × 10^exponent, where `digits` holds the
+// significant digits of a literal, possibly split by a '.' that is skipped
+constexpr double roundExactly(std::string_view digits, long long exponent) {
+  BigInteger numerator;
+  std::size_t used = 0;
+  bool inexact = false;
+  for (const char c : digits) {
+    if (c == '.') {
+      continue;
+    }
+    if (used < kMaxDigits) {
+      numerator.multiplyAdd(10, static_cast<std::uint32_t>(c - '0'));
+      ++used;
+    } else {
+      ++exponent;
+      inexact = inexact || c != '0';
+    }
+  }
+  // The dropped tail lies strictly between two kept values; a trailing
+  // 1 stands in for it without ever landing on a halfway point
+  if (inexact) {
+    numerator.multiplyAdd(10, 1);
+    ++used;
+    --exponent;
+  }
+
+  // Beyond these the result is infinity or rounds to zero outright
+  const long long magnitude = static_cast<long long>(used) + exponent;
+  if (magnitude > 310) {
+    return std::numeric_limits<double>::infinity();
+  }
+  if (magnitude < -326) {
+    return 0.0;
+  }
+
+  BigInteger denominator;
+  denominator.multiplyAdd(1, 1);
+  if (exponent >= 0) {
+    numerator.multiplyPow10(static_cast<std::size_t>(exponent));
+  } else {
+    denominator.multiplyPow10(static_cast<std::size_t>(-exponent));
+  }
+
+  // Scale by 2^shift so the quotient has exactly 63 or 64 bits
+  const auto numeratorBits = static_cast<long long>(numerator.bitLength());
+  const auto denominatorBits = static_cast<long long>(denominator.bitLength());
+  const long long shift = 63 - (numeratorBits - denominatorBits);
+  if (shift > 0) {
+    numerator.shiftLeft(static_cast<std::size_t>(shift));
+  } else {
+    denominator.shiftLeft(static_cast<std::size_t>(-shift));
+  }
+  denominator.shiftLeft(63);
+  std::uint64_t quotient = 0;
+  for (int bit = 63; bit >= 0; --bit) {
+    if (numerator.compare(denominator) >= 0) {
+      numerator.subtract(denominator);
+      quotient |= std::uint64_t{1} << bit;
+    }
+    denominator.shiftRightOne();
+  }
+  const bool sticky = !numerator.isZero();
+
+  // quotient × 2^-shift, rounded half to even to 53 bits, or to fewer where
+  // the result is subnormal
+  const int width = std::bit_width(quotient);
+  const long long topExponent = width - 1 - shift;
+  const long long lowestExponent =
+      topExponent - 52 < -1074 ? -1074 : topExponent - 52;
+  const long long drop = lowestExponent + shift;
+  std::uint64_t mantissa = 0;
+  bool roundUp = false;
+  if (drop >= 65) {
+    return 0.0;
+  }
+  if (drop == 64) {
+    roundUp = quotient > (std::uint64_t{1} << 63) ||
+              (quotient == (std::uint64_t{1} << 63) && sticky);
+  } else {
+    mantissa = quotient >> drop;
+    const std::uint64_t rest = quotient & ((std::uint64_t{1} << drop) - 1);
+    const std::uint64_t half = std::uint64_t{1} << (drop - 1);
+    roundUp = rest > half || (rest == half && (sticky || (mantissa & 1)));
+  }
+  long long lowest = lowestExponent;
+  if (roundUp && ++mantissa == (std::uint64_t{1} << 53)) {
+    mantissa >>= 1;
+    ++lowest;
+  }
+  if (mantissa < (std::uint64_t{1} << 52)) {
+    return std::bit_cast<double>(mantissa); // Subnormal (or zero)
+  }
+  const long long biased = lowest + 52 + 1023;
+  if (biased >= 2047) {
+    return std::numeric_limits<double>::infinity();
+  }
+  return std::bit_cast<double>(static_cast<std::uint64_t>(biased) << 52 |
+                               (mantissa & ((std::uint64_t{1} << 52) - 1)));
+}
+
+} // namespace detail
+
+// Reads a non-negative decimal literal ("12", "0.5", ".5", "1e-3", "inf",
+// "nan") from the start of `text`, correctly rounded to the nearest double
+// just as std::from_chars would, except that results too large or too
+// small saturate to infinity or zero instead of failing. Usable in constant
+// expressions, which std::from_chars is not.
+//
+// Literals of at most 19 significant digits with an exponent whose power
+// of ten is exact take Clinger's fast path: one double multiplication or
+// division. Everything else is rounded exactly with big integers.
+constexpr ParsedDouble parseDouble(std::string_view text) {
+  using detail::isDigit;
+  if (detail::startsWithIgnoringCase(text, "infinity")) {
+    return {std::numeric_limits<double>::infinity(), 8};
+  }
+  if (detail::startsWithIgnoringCase(text, "inf")) {
+    return {std::numeric_limits<double>::infinity(), 3};
+  }
+  if (detail::startsWithIgnoringCase(text, "nan")) {
+    // "nan(chars)" is one token when the parenthesis closes
+    std::size_t end = 3;
+    if (end < text.size() && text[end] == '(') {
+      std::size_t close = end + 1;
+      while (close < text.size() &&
+             (isDigit(text[close]) || text[close] == '_' ||
+              ((text[close] | 0x20) >= 'a' && (text[close] | 0x20) <= 'z'))) {
+        ++close;
+      }
+      if (close < text.size() && text[close] == ')') {
+        end = close + 1;
+      }
+    }
+    return {std::numeric_limits<double>::quiet_NaN(), end};
+  }
+
+  std::size_t pos = 0;
+  std::size_t firstSignificant = std::string_view::npos;
+  std::size_t fractionDigits = 0;
+  std::size_t digitCount = 0;
+  bool point = false;
+  for (; pos < text.size(); ++pos) {
+    const char c = text[pos];
+    if (isDigit(c)) {
+      ++digitCount;
+      fractionDigits += point;
+      if (c != '0' && firstSignificant == std::string_view::npos) {
+        firstSignificant = pos;
+      }
+    } else if (c == '.' && !point) {
+      point = true;
+    } else {
+      break;
+    }
+  }
+  if (digitCount == 0) {
+    return {};
+  }
+  const std::size_t mantissaEnd = pos;
+
+  long long exponent = 0;
+  if (pos < text.size() && (text[pos] | 0x20) == 'e') {
+    std::size_t next = pos + 1;
+    const bool negative = next < text.size() && text[next] == '-';
+    next += next < text.size() && (text[next] == '-' || text[next] == '+');
+    if (next < text.size() && isDigit(text[next])) {
+      for (; next < text.size() && isDigit(text[next]); ++next) {
+        // Far beyond any cut-off, so clamping cannot change the result
+        if (exponent < 100000000) {
+          exponent = exponent * 10 + (text[next] - '0');
+        }
+      }
+      exponent = negative ? -exponent : exponent;
+      pos = next;
+    }
+  }
+  if (firstSignificant == std::string_view::npos) {
+    return {0.0, pos};
+  }
+
+  // Significant digits with trailing zeros and their exponent folded in
+  std::string_view digits =
+      text.substr(firstSignificant, mantissaEnd - firstSignificant);
+  exponent -= static_cast<long long>(fractionDigits);
+  while (digits.back() == '0' || digits.back() == '.') {
+    exponent += digits.back() == '0';
+    digits.remove_suffix(1);
+  }
+
+  // Clinger: an exact mantissa times or over an exact power of ten
+  std::uint64_t mantissa = 0;
+  std::size_t significant = 0;
+  for (const char c : digits) {
+    if (c != '.') {
+      mantissa = mantissa * 10 + static_cast<std::uint64_t>(c - '0');
+      ++significant;
+    }
+    if (significant > 19) {
+      break;
+    }
+  }
+  if (significant <= 19 && mantissa <= (std::uint64_t{1} << 53)) {
+    const auto value = static_cast<double>(mantissa);
+    if (exponent >= 0 && exponent <= 22) {
+      return {value * detail::kExactPowers[exponent], pos};
+    }
+    if (exponent < 0 && exponent >= -22) {
+      return {value / detail::kExactPowers[-exponent], pos};
+    }
+  }
+  return {detail::roundExactly(digits, exponent), pos};
+}
+
+} // namespace calc
@@ -0,0 +1,56 @@
+#include "engine/PersistentText.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace calc {
+
+PersistentText::Version PersistentText::append(Version base,
+                                               std::string_view more) {
+  if (more.empty()) {
+    return base;
+  }
+  const auto size = static_cast<std::uint32_t>(text.size());
+  const auto grown = static_cast<std::uint32_t>(more.size());
+  text += more;
+  // A version ending where the store ends grows its own run in place;
+  // versions already taken keep their shorter `end`
+  if (base.run != kNone && base.end == size && runs[base.run].end == size) {
+    runs[base.run].end = size + grown;
+    return {base.run, size + grown, base.length + grown};
+  }
+  runs.push_back({base.run, base.end, size, size + grown});
+  return {static_cast<std::uint32_t>(runs.size() - 1), size + grown,
+          base.length + grown};
+}
+
+void PersistentText::read(Version version, std::string &out) const {
+  // Filled back to front, so the runs are visited without a scratch list
+  out.resize(version.length);
+  std::size_t pos = version.length;
+  std::uint32_t run = version.run;
+  std::uint32_t end = version.end;
+  while (run != kNone) {
+    const Run &at = runs[run];
+    const std::size_t count = end - at.begin;
+    pos -= count;
+    std::memcpy(out.data() + pos, text.data() + at.begin, count);
+    run = at.previous;
+    end = at.previousEnd;
+  }
+}
+
+void PersistentText::rollback(Mark mark) {
+  runs.resize(mark.runs);
+  text.resize(mark.bytes);
+  // Only the last run can have grown past the mark
+  if (!runs.empty()) {
+    runs.back().end = std::min(runs.back().end, mark.bytes);
+  }
+}
+
+void PersistentText::clear() {
+  runs.clear();
+  text.clear();
+}
+
+} // namespace calc
@@ -0,0 +1,59 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace calc {
+
+// Append-only text that keeps every version readable. A Version is a
+// three-integer handle; versions share all the text they have in common,
+// so keeping one per key press costs the appended bytes and nothing more
+// however long the text grows. Text appended to an older version (after
+// an undo) branches off without copying what came before.
+class PersistentText {
+public:
+  static constexpr std::uint32_t kNone = 0xFFFFFFFF;
+
+  struct Version {
+    std::uint32_t run = kNone; // Run holding the last bytes; kNone if empty
+    std::uint32_t end = 0;     // Where this version stops within that run
+    std::uint32_t length = 0;
+  };
+
+  // Size of the store, for rolling back to it later
+  struct Mark {
+    std::uint32_t runs = 0;
+    std::uint32_t bytes = 0;
+  };
+
+  // `base` followed by `text`
+  Version append(Version base, std::string_view text);
+
+  // Assigns the text of `version` to `out`, one copy per run it spans
+  void read(Version version, std::string &out) const;
+
+  Mark mark() const {
+    return {static_cast<std::uint32_t>(runs.size()),
+            static_cast<std::uint32_t>(text.size())};
+  }
+  // Forgets everything appended since `mark`; versions made since then
+  // become invalid, older ones stay readable
+  void rollback(Mark mark);
+  void clear();
+
+private:
+  // Contiguous bytes text[begin, end) continuing an earlier version
+  struct Run {
+    std::uint32_t previous;    // Run before this one, or kNone
+    std::uint32_t previousEnd; // Where the text before stops in `previous`
+    std::uint32_t begin;
+    std::uint32_t end;
+  };
+
+  std::vector<Run> runs;
+  std::string text;
+};
+
+} // namespace calc
@@ -0,0 +1,184 @@
+#include "engine/Plot.hpp"
+#include "engine/Columnar.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace calc {
+
+namespace {
+
+constexpr int kMaxDepth = 10;      // Columns are bisected down to 1/1024 px
+constexpr double kFlatness = 0.25; // Pixels a chord may stray from the curve
+constexpr double kMargin = 4.0;    // Pixels beyond the tile still refined
+constexpr double kHalfWidth = 0.75;
+constexpr double kClipTiles = 4.0; // Segments are cut this far off the tile
+
+constexpr double kNaN = std::numeric_limits<double>::quiet_NaN();
+
+struct Sampler {
+  const Program &program;
+  double pixel;
+  double top;    // Highest y worth refining
+  double bottom; // Lowest
+  std::vector<CurvePoint> &points;
+
+  double value(double x) const {
+    const double bound[1] = {x};
+    const std::optional<double> y =
+        evaluate(program, std::span(bound, program.variables.size()));
+    return y ? *y : kNaN;
+  }
+
+  // Appends the points strictly between `a` and `b` that the curve needs
+  // to be drawn within kFlatness pixels
+  void refine(CurvePoint a, CurvePoint b, int depth) {
+    const bool finiteA = std::isfinite(a.y);
+    const bool finiteB = std::isfinite(b.y);
+    if (depth == kMaxDepth) {
+      // Still jumping by more than a pixel over 1/1024 of one: a pole or
+      // a step, which is left open rather than drawn as a vertical line
+      if (finiteA && finiteB && std::fabs(b.y - a.y) > pixel) {
+        points.push_back({(a.x + b.x) / 2.0, kNaN});
+      }
+      return;
+    }
+    if (!finiteA && !finiteB) {
+      return;
+    }
+    // Both ends on the same side of the tile: nothing there is drawn
+    if (finiteA && finiteB &&
+        ((a.y > top && b.y > top) || (a.y < bottom && b.y < bottom))) {
+      return;
+    }
+    const CurvePoint middle{(a.x + b.x) / 2.0, value((a.x + b.x) / 2.0)};
+    if (finiteA && finiteB && std::isfinite(middle.y) &&
+        std::fabs(middle.y - (a.y + b.y) / 2.0) <= kFlatness * pixel) {
+      return;
+    }
+    // Bends, jumps or meets a hole where the program fails: bisect, which
+    // also homes in on the edge of the hole
+    refine(a, middle, depth + 1);
+    points.push_back(middle);
+    refine(middle, b, depth + 1);
+  }
+};
+
+} // namespace
+
+void sampleCurve(const Program &program, const PlotArea &area,
+                 std::vector<CurvePoint> &points) {
+  constexpr std::size_t count = kTileSize + 3; // Edges -1 to kTileSize + 1
+  // Reused across calls so sampling tile after tile does not allocate
+  thread_local std::vector<double> xs(count);
+  thread_local std::vector<double> ys(count);
+  thread_local std::vector<std::uint8_t> errors(count);
+  for (std::size_t i = 0; i < count; ++i) {
+    xs[i] = area.left + (static_cast<double>(i) - 1.0) * area.pixel;
+  }
+  const double *const column = xs.data();
+  points.clear();
+  if (!evaluateColumns(program,
+                       std::span(&column, program.variables.empty() ? 0 : 1),
+                       count, ys.data(), errors.data())) {
+    return; // More than one variable
+  }
+
+  Sampler sampler{program, area.pixel,
+                  area.top + kMargin * area.pixel,
+                  area.top - (kTileSize + kMargin) * area.pixel, points};
+  CurvePoint previous{xs[0], errors[0] ? kNaN : ys[0]};
+  points.push_back(previous);
+  for (std::size_t i = 1; i < count; ++i) {
+    const CurvePoint next{xs[i], errors[i] ? kNaN : ys[i]};
+    sampler.refine(previous, next, 0);
+    points.push_back(next);
+    previous = next;
+  }
+}
+
+void renderCurve(std::span<const CurvePoint> points, const PlotArea &area,
+                 std::uint32_t color, std::uint32_t *pixels,
+                 std::size_t stride) {
+  constexpr auto size = static_cast<double>(kTileSize);
+  // Left zeroed between calls; only the pixels listed in `touched` are
+  // visited again, a line being a small part of the tile
+  thread_local std::vector<float> coverage(std::size_t{kTileSize} *
+                                           kTileSize);
+  thread_local std::vector<std::uint32_t> touched;
+  touched.clear();
+
+  // Each segment covers, in every pixel column it crosses, the rows
+  // between its ends within that column widened by kHalfWidth; coverage is
+  // the covered fraction of each row, and overlapping segments keep the
+  // larger, so joints are not drawn twice as dark
+  for (std::size_t i = 1; i < points.size(); ++i) {
+    double ax = (points[i - 1].x - area.left) / area.pixel;
+    double ay = (area.top - points[i - 1].y) / area.pixel;
+    double bx = (points[i].x - area.left) / area.pixel;
+    double by = (area.top - points[i].y) / area.pixel;
+    if (!std::isfinite(ay) || !std::isfinite(by) || bx < 0.0 ||
+        ax >= size || !(ax <= bx)) {
+      continue;
+    }
+    // Clipped to kClipTiles beyond the top and bottom edges, so a point
+    // far off the tile neither overflows the row arithmetic below nor
+    // loses the slope where the segment crosses the tile
+    const auto clip = [&](double &x, double &y, double other, double otherY,
+                          double edge) {
+      x += (other - x) * ((edge - y) / (otherY - y));
+      y = edge;
+    };
+    const double above = -kClipTiles * size;
+    const double below = (kClipTiles + 1.0) * size;
+    if ((ay < above && by < above) || (ay > below && by > below)) {
+      continue;
+    }
+    if (ay < above || ay > below) {
+      clip(ax, ay, bx, by, ay < above ? above : below);
+    }
+    if (by < above || by > below) {
+      clip(bx, by, ax, ay, by < above ? above : below);
+    }
+    const double slope = bx > ax ? (by - ay) / (bx - ax) : 0.0;
+    const auto from = static_cast<int>(std::max(std::floor(ax), 0.0));
+    const auto to = static_cast<int>(std::min(std::floor(bx), size - 1.0));
+    for (int x = from; x <= to; ++x) {
+      const auto edge = static_cast<double>(x);
+      const double y0 = ay + (std::max(ax, edge) - ax) * slope;
+      const double y1 = ay + (std::min(bx, edge + 1.0) - ax) * slope;
+      const double low = std::max(std::min(y0, y1) - kHalfWidth, 0.0);
+      const double high = std::min(std::max(y0, y1) + kHalfWidth, size);
+      if (!(low < high)) {
+        continue; // Wholly above or below the tile in this column
+      }
+      for (int y = static_cast<int>(low); y < high; ++y) {
+        const auto covered = static_cast<float>(
+            std::min(high, y + 1.0) - std::max(low, static_cast<double>(y)));
+        const auto index = static_cast<std::uint32_t>(y * kTileSize + x);
+        if (coverage[index] == 0.0F) {
+          touched.push_back(index);
+        }
+        coverage[index] = std::max(coverage[index], covered);
+      }
+    }
+  }
+
+  for (std::size_t y = 0; y < kTileSize; ++y) {
+    std::fill_n(pixels + y * stride, kTileSize, 0U);
+  }
+  // Premultiplied: every channel scaled by the pixel's alpha
+  const auto alpha = static_cast<float>(color >> 24);
+  for (const std::uint32_t index : touched) {
+    const auto a =
+        static_cast<std::uint32_t>(coverage[index] * alpha + 0.5F);
+    const auto channel = [color, a](int shift) {
+      return (((color >> shift) & 0xFF) * a + 127) / 255 << shift;
+    };
+    pixels[index / kTileSize * stride + index % kTileSize] =
+        a << 24 | channel(16) | channel(8) | channel(0);
+    coverage[index] = 0.0F;
+  }
+}
+
+} // namespace calc
@@ -0,0 +1,45 @@
+#pragma once
+#include "engine/Expression.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace calc {
+
+// Plots are rendered in square tiles of this many pixels a side
+constexpr int kTileSize = 256;
+
+// The square of the plane one tile shows. Pixels are square, `pixel`
+// world units a side; y grows upwards, so row 0 is at `top`.
+struct PlotArea {
+  double left;
+  double top;
+  double pixel;
+};
+
+// A point of a sampled curve. A NaN y (where the program divides by zero
+// or the curve jumps) separates the pieces on either side of it.
+struct CurvePoint {
+  double x;
+  double y;
+};
+
+// Samples a program in at most one variable across the columns of `area`
+// and one column beyond each edge, so curves meet across tile edges. Every
+// column is evaluated at once through evaluateColumns(); columns where the
+// curve bends by more than a fraction of a pixel, or jumps, are then
+// bisected. A jump that does not narrow under bisection is a
+// discontinuity and breaks the curve instead of being joined up. `points`
+// is overwritten, reusing its buffer.
+void sampleCurve(const Program &program, const PlotArea &area,
+                 std::vector<CurvePoint> &points);
+
+// Draws `points` into a kTileSize × kTileSize tile of premultiplied ARGB
+// pixels (QImage::Format_ARGB32_Premultiplied), `stride` pixels per row,
+// as an antialiased line about 1.5 pixels wide over transparency.
+void renderCurve(std::span<const CurvePoint> points, const PlotArea &area,
+                 std::uint32_t color, std::uint32_t *pixels,
+                 std::size_t stride);
+
+} // namespace calc
@@ -0,0 +1,253 @@
+#include "engine/Recording.hpp"
+#include "engine/Batch.hpp"
+#include "engine/MappedFile.hpp"
+#include "engine/Session.hpp"
+#include <cerrno>
+#include <cstring>
+
+namespace calc {
+
+namespace {
+
+constexpr std::string_view kMagic{"CALCREC\x01", 8};
+constexpr unsigned char kEndMarker = 0xFF;
+
+void appendVarint(std::vector<unsigned char> &out, std::uint64_t value) {
+  while (value >= 0x80) {
+    out.push_back(static_cast<unsigned char>(value | 0x80));
+    value >>= 7;
+  }
+  out.push_back(static_cast<unsigned char>(value));
+}
+
+bool readVarint(std::string_view bytes, std::size_t &pos,
+                std::uint64_t &value) {
+  value = 0;
+  for (int shift = 0; shift < 64 && pos < bytes.size(); shift += 7) {
+    const auto byte = static_cast<unsigned char>(bytes[pos++]);
+    value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+    if (!(byte & 0x80)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool fail(std::string *error, const char *message) {
+  if (error) {
+    *error = message;
+  }
+  return false;
+}
+
+} // namespace
+
+std::optional<Recording> parseRecording(std::string_view bytes,
+                                        std::string *error) {
+  if (!bytes.starts_with(kMagic) || bytes.size() <= kMagic.size()) {
+    fail(error, "not a calculator recording");
+    return std::nullopt;
+  }
+  Recording recording;
+  const auto backend = static_cast<unsigned char>(bytes[kMagic.size()]);
+  if (backend > static_cast<unsigned char>(NumericBackend::Decimal)) {
+    fail(error, "unknown numeric backend");
+    return std::nullopt;
+  }
+  recording.backend = static_cast<NumericBackend>(backend);
+
+  std::size_t pos = kMagic.size() + 1;
+  std::uint64_t time = 0;
+  while (pos < bytes.size()) {
+    const auto code = static_cast<unsigned char>(bytes[pos++]);
+    std::uint64_t value = 0;
+    if (code == kEndMarker) {
+      if (!readVarint(bytes, pos, value) || value > bytes.size() - pos) {
+        fail(error, "truncated final display");
+        return std::nullopt;
+      }
+      recording.finalDisplay.emplace(bytes.substr(pos, value));
+      break;
+    }
+    if (code >= kActionCount) {
+      fail(error, "unknown action");
+      return std::nullopt;
+    }
+    if (!readVarint(bytes, pos, value)) {
+      // The application died mid-write; keep what came before
+      break;
+    }
+    time += value;
+    recording.actions.push_back(static_cast<Action>(code));
+    recording.timestamps.push_back(time);
+  }
+  return recording;
+}
+
+Recorder::Recorder(const std::string &path, NumericBackend backend) {
+  file = std::fopen(path.c_str(), "wb");
+  if (!file) {
+    errorText = path + ": " + std::strerror(errno);
+    return;
+  }
+  pending.assign(kMagic.begin(), kMagic.end());
+  pending.push_back(static_cast<unsigned char>(backend));
+  last = Clock::now();
+  writer = std::thread(&Recorder::writeLoop, this);
+}
+
+Recorder::~Recorder() { close(); }
+
+void Recorder::record(Action action) {
+  if (!file) {
+    return;
+  }
+  const auto now = Clock::now();
+  const auto delta =
+      std::chrono::duration_cast<std::chrono::microseconds>(now - last);
+  last = now;
+  {
+    const std::lock_guard lock(mutex);
+    pending.push_back(static_cast<unsigned char>(action));
+    appendVarint(pending, static_cast<std::uint64_t>(delta.count()));
+  }
+  wake.notify_one();
+}
+
+void Recorder::finish(std::string_view finalDisplay) {
+  if (!file) {
+    return;
+  }
+  {
+    const std::lock_guard lock(mutex);
+    pending.push_back(kEndMarker);
+    appendVarint(pending, finalDisplay.size());
+    pending.insert(pending.end(), finalDisplay.begin(), finalDisplay.end());
+  }
+  close();
+}
+
+void Recorder::close() {
+  if (!file) {
+    return;
+  }
+  {
+    const std::lock_guard lock(mutex);
+    stopping = true;
+  }
+  wake.notify_one();
+  writer.join();
+  std::fclose(file);
+  file = nullptr;
+}
+
+void Recorder::writeLoop() {
+  std::vector<unsigned char> batch;
+  std::unique_lock lock(mutex);
+  for (;;) {
+    wake.wait(lock, [this] { return !pending.empty() || stopping; });
+    batch.swap(pending);
+    const bool stop = stopping;
+    lock.unlock();
+
+    // One write for everything queued since the last
+    std::fwrite(batch.data(), 1, batch.size(), file);
+    std::fflush(file);
+    batch.clear();
+
+    lock.lock();
+    if (stop && pending.empty()) {
+      return;
+    }
+  }
+}
+
+ReplayResult replay(const Recording &recording, Session &session) {
+  for (const Action action : recording.actions) {
+    session.dispatch(action);
+  }
+  ReplayResult result;
+  result.actions = recording.actions.size();
+  result.display = session.display();
+  result.matches =
+      !recording.finalDisplay || *recording.finalDisplay == result.display;
+  return result;
+}
+
+int runReplay(int argc, char *argv[]) {
+  static constexpr const char *kUsage =
+      "Usage: Calculator --replay [--repeat N] [--latency] FILE\n";
+  const char *path = nullptr;
+  std::size_t repeat = 1;
+  bool latency = false;
+  for (int i = 0; i < argc; ++i) {
+    const std::string_view arg = argv[i];
+    if (arg == "--repeat" && i + 1 < argc) {
+      const std::optional<std::size_t> count = parseCount(argv[++i]);
+      if (!count || *count == 0) {
+        std::fprintf(stderr, "Calculator: invalid repeat count '%s'\n",
+                     argv[i]);
+        std::fputs(kUsage, stderr);
+        return 2;
+      }
+      repeat = *count;
+    } else if (arg == "--latency") {
+      latency = true;
+    } else if (arg.starts_with("-") || path) {
+      std::fputs(kUsage, stderr);
+      return 2;
+    } else {
+      path = argv[i];
+    }
+  }
+  if (!path) {
+    std::fputs(kUsage, stderr);
+    return 2;
+  }
+
+  const MappedFile input(path);
+  if (!input.isOpen()) {
+    std::fprintf(stderr, "Calculator: %s\n", input.error().c_str());
+    return 1;
+  }
+  std::string error;
+  const auto recording = parseRecording(input.view(), &error);
+  if (!recording) {
+    std::fprintf(stderr, "Calculator: %s: %s\n", path, error.c_str());
+    return 1;
+  }
+
+  // Every pass replays into a fresh session so each one must reproduce
+  // the recorded display on its own
+  ReplayResult result;
+  std::size_t mismatches = 0;
+  LatencyMonitor monitor;
+  const auto start = std::chrono::steady_clock::now();
+  for (std::size_t pass = 0; pass < repeat; ++pass) {
+    Session session;
+    session.setNumericBackend(recording->backend);
+    session.setLatencyMonitor(latency ? &monitor : nullptr);
+    result = replay(*recording, session);
+    mismatches += !result.matches;
+  }
+  const std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+
+  const double total = static_cast<double>(result.actions) *
+                       static_cast<double>(repeat);
+  std::fprintf(stderr, "Calculator: replayed %.0f actions in %.3fs (%.0f/s)\n",
+               total, elapsed.count(),
+               elapsed.count() > 0 ? total / elapsed.count() : 0.0);
+  if (latency) {
+    monitor.report(stderr);
+  }
+  std::printf("%s\n", result.display.c_str());
+  if (mismatches) {
+    std::fprintf(stderr, "Calculator: display mismatch, recorded \"%s\"\n",
+                 recording->finalDisplay->c_str());
+    return 1;
+  }
+  return 0;
+}
+
+} // namespace calc
@@ -0,0 +1,93 @@
+#pragma once
+#include "engine/Action.hpp"
+#include "engine/Backend.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace calc {
+
+class Session;
+
+// Binary input log, written by Recorder and read by parseRecording():
+//
+//   "CALCREC" 0x01      magic and format version
+//   backend             NumericBackend the session ran on (one byte)
+//   action delta...     one byte per Action, then the microseconds since the
+//                       previous action as an unsigned LEB128 varint
+//   0xFF length text    end marker, then the final display text
+//
+// A log cut short by a crash simply lacks the end marker.
+struct Recording {
+  NumericBackend backend = NumericBackend::Double;
+  std::vector<Action> actions;
+  std::vector<std::uint64_t> timestamps; // Microseconds since the start
+  std::optional<std::string> finalDisplay;
+};
+
+// Parses a log; std::nullopt with `error` set when it is malformed
+std::optional<Recording> parseRecording(std::string_view bytes,
+                                        std::string *error = nullptr);
+
+// Appends actions to a log file as they happen. record() only queues the
+// bytes; a writer thread writes whatever has queued each time it wakes, so
+// the keypad never waits for the disk and a crash of the application loses
+// at most the actions still queued.
+class Recorder {
+public:
+  Recorder(const std::string &path, NumericBackend backend);
+  ~Recorder();
+
+  Recorder(const Recorder &) = delete;
+  Recorder &operator=(const Recorder &) = delete;
+
+  bool isOpen() const { return file != nullptr; }
+  const std::string &error() const { return errorText; }
+
+  void record(Action action);
+
+  // Writes the end marker with the display text the session finished on;
+  // nothing is recorded afterwards
+  void finish(std::string_view finalDisplay);
+
+private:
+  using Clock = std::chrono::steady_clock;
+
+  std::FILE *file = nullptr;
+  std::string errorText;
+  Clock::time_point last;
+
+  // Shared with the writer thread
+  std::mutex mutex;
+  std::condition_variable wake;
+  std::vector<unsigned char> pending; // Encoded actions not yet written
+  bool stopping = false;
+  std::thread writer;
+
+  void writeLoop();
+  // Writes what is still queued, then stops the writer and closes the file
+  void close();
+};
+
+struct ReplayResult {
+  std::size_t actions = 0;
+  std::string display; // Display text after the last action
+  bool matches = true; // Whether it equals the recorded final display
+};
+
+// Drives `session` through every recorded action as fast as possible. The
+// session should start out fresh and on the recording's backend.
+ReplayResult replay(const Recording &recording, Session &session);
+
+// Entry point for `Calculator --replay [--repeat N] [--latency] FILE`;
+// --latency prints dispatch, calculate and preview histograms to stderr
+int runReplay(int argc, char *argv[]);
+
+} // namespace calc
@@ -0,0 +1,139 @@
+#include "engine/ResultCache.hpp"
+#include <algorithm>
+#include <bit>
+#include <functional>
+#include <thread>
+
+namespace calc {
+
+namespace {
+
+bool isSpace(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+// Characters no number or identifier can contain, so spaces next to them
+// never matter
+bool isDelimiter(char c) {
+  return c == '(' || c == ')' || c == '*' || c == '/' || c == '%';
+}
+
+bool isExponent(char c) { return c == 'e' || c == 'E'; }
+
+bool isSign(char c) { return c == '+' || c == '-'; }
+
+// Whether the space between `before` and `after` can be dropped. Signs
+// only qualify away from an exponent marker: "1e -5" and "1e-5" differ.
+bool canDropSpace(std::string_view key, char after) {
+  const char before = key.back();
+  if (isDelimiter(before) || isDelimiter(after)) {
+    return true;
+  }
+  if (isSign(after)) {
+    return !isExponent(before);
+  }
+  if (isSign(before)) {
+    return key.size() < 2 || !isExponent(key[key.size() - 2]);
+  }
+  return false;
+}
+
+} // namespace
+
+void normalizeExpression(std::string_view expression, std::string &key) {
+  key.clear();
+  bool pendingSpace = false;
+  for (std::size_t i = 0; i < expression.size(); ++i) {
+    char c = expression[i];
+    if (isSpace(c)) {
+      pendingSpace = !key.empty();
+      continue;
+    }
+    // × is C3 97 and ÷ is C3 B7 in UTF-8
+    if (c == '\xC3' && i + 1 < expression.size()) {
+      if (expression[i + 1] == '\x97') {
+        c = '*';
+        ++i;
+      } else if (expression[i + 1] == '\xB7') {
+        c = '/';
+        ++i;
+      }
+    }
+    if (pendingSpace && !canDropSpace(key, c)) {
+      key += ' ';
+    }
+    pendingSpace = false;
+    key += c;
+  }
+}
+
+ResultCache::ResultCache(std::size_t capacity, std::size_t shardCount) {
+  if (shardCount == 0) {
+    const std::size_t threads =
+        std::max(1u, std::thread::hardware_concurrency());
+    shardCount = std::bit_ceil(threads * 4);
+  }
+  // Small caches keep a handful of entries per shard
+  shardCount = std::clamp<std::size_t>(capacity / 4, 1, shardCount);
+  shardCapacity = std::max<std::size_t>(1, capacity / shardCount);
+  shards.reserve(shardCount);
+  for (std::size_t i = 0; i < shardCount; ++i) {
+    shards.push_back(std::make_unique<Shard>());
+  }
+}
+
+ResultCache::~ResultCache() = default;
+
+ResultCache::Shard &ResultCache::shardFor(std::string_view key) {
+  // Use the high half; the shard's map buckets on the low bits
+  const std::size_t hash = std::hash<std::string_view>{}(key);
+  return *shards[(hash >> (sizeof(hash) * 4)) % shards.size()];
+}
+
+bool ResultCache::find(std::string_view key, CachedResult &result) {
+  Shard &shard = shardFor(key);
+  std::lock_guard lock(shard.mutex);
+  const auto found = shard.index.find(key);
+  if (found == shard.index.end()) {
+    ++shard.misses;
+    return false;
+  }
+  ++shard.hits;
+  shard.entries.splice(shard.entries.begin(), shard.entries, found->second);
+  result = found->second->result;
+  return true;
+}
+
+void ResultCache::insert(std::string_view key, const CachedResult &result) {
+  Shard &shard = shardFor(key);
+  std::lock_guard lock(shard.mutex);
+  if (const auto found = shard.index.find(key); found != shard.index.end()) {
+    found->second->result = result;
+    shard.entries.splice(shard.entries.begin(), shard.entries, found->second);
+    return;
+  }
+  if (shard.entries.size() >= shardCapacity) {
+    // Reuse the evicted node instead of allocating a new one
+    auto last = std::prev(shard.entries.end());
+    shard.index.erase(last->key);
+    ++shard.evictions;
+    last->key.assign(key);
+    last->result = result;
+    shard.entries.splice(shard.entries.begin(), shard.entries, last);
+  } else {
+    shard.entries.push_front({std::string(key), result});
+  }
+  shard.index.emplace(shard.entries.front().key, shard.entries.begin());
+}
+
+CacheStats ResultCache::stats() const {
+  CacheStats total;
+  for (const auto &shard : shards) {
+    std::lock_guard lock(shard->mutex);
+    total.hits += shard->hits;
+    total.misses += shard->misses;
+    total.evictions += shard->evictions;
+    total.size += shard->entries.size();
+  }
+  return total;
+}
+
+} // namespace calc
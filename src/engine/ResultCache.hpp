@@ -0,0 +1,77 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace calc {
+
+// Rewrites an expression into the key ResultCache uses: × and ÷ become
+// * and /, and whitespace is dropped or collapsed to one space wherever
+// that cannot change how the expression parses ("2 +  3 ×4" -> "2+3*4")
+void normalizeExpression(std::string_view expression, std::string &key);
+
+// Outcome of one evaluation, as it is printed
+struct CachedResult {
+  std::string text;
+  bool failed = false;
+};
+
+struct CacheStats {
+  std::uint64_t hits = 0;
+  std::uint64_t misses = 0;
+  std::uint64_t evictions = 0;
+  std::size_t size = 0;
+};
+
+// Bounded LRU map from normalized expression to result. Entries are spread
+// over independently locked shards so concurrent batch workers rarely wait
+// on each other. A cache must only ever be filled by one numeric backend.
+class ResultCache {
+public:
+  // Zero shards picks a power of two well above the hardware thread count
+  explicit ResultCache(std::size_t capacity, std::size_t shardCount = 0);
+  ~ResultCache();
+
+  ResultCache(const ResultCache &) = delete;
+  ResultCache &operator=(const ResultCache &) = delete;
+
+  // Copies the entry for `key` into `result` and marks it most recently
+  // used; false (counted as a miss) when there is none
+  bool find(std::string_view key, CachedResult &result);
+
+  // Adds or refreshes an entry, evicting the shard's least recently used
+  // one when it is full
+  void insert(std::string_view key, const CachedResult &result);
+
+  std::size_t capacity() const { return shardCapacity * shards.size(); }
+  CacheStats stats() const;
+
+private:
+  struct Entry {
+    std::string key;
+    CachedResult result;
+  };
+
+  // Aligned so neighbouring shards' locks never share a cache line
+  struct alignas(64) Shard {
+    mutable std::mutex mutex;
+    std::list<Entry> entries; // Most recently used first
+    std::unordered_map<std::string_view, std::list<Entry>::iterator> index;
+    std::uint64_t hits = 0;
+    std::uint64_t misses = 0;
+    std::uint64_t evictions = 0;
+  };
+
+  std::vector<std::unique_ptr<Shard>> shards;
+  std::size_t shardCapacity;
+
+  Shard &shardFor(std::string_view key);
+};
+
+} // namespace calc
@@ -0,0 +1,86 @@
+#include "engine/RunningExpression.hpp"
+#include "engine/Decimal.hpp"
+
+namespace calc {
+
+namespace {
+
+std::optional<double> quotient(double lhs, double rhs) {
+  return apply(Operator::Divide, lhs, rhs);
+}
+
+std::optional<Decimal> quotient(const Decimal &lhs, const Decimal &rhs) {
+  return divide(lhs, rhs);
+}
+
+// `sum additive product`, or just `product` before the first + or -
+template <typename Number>
+Number combine(const Number &sum, Operator additive, const Number &product) {
+  switch (additive) {
+  case Operator::Add:
+    return sum + product;
+  case Operator::Subtract:
+    return sum - product;
+  default:
+    return product;
+  }
+}
+
+} // namespace
+
+template <typename Number> void RunningExpression<Number>::clear() {
+  sum = Number();
+  additive = Operator::None;
+  product = Number();
+  started = false;
+}
+
+template <typename Number>
+bool RunningExpression<Number>::push(Operator op, const Number &operand) {
+  if (!started) {
+    product = operand;
+    started = true;
+    return true;
+  }
+  switch (op) {
+  case Operator::Multiply:
+    product = product * operand;
+    return true;
+  case Operator::Divide: {
+    auto result = quotient(product, operand);
+    if (!result) {
+      return false;
+    }
+    product = std::move(*result);
+    return true;
+  }
+  case Operator::Add:
+  case Operator::Subtract:
+    sum = combine(sum, additive, product);
+    additive = op;
+    product = operand;
+    return true;
+  case Operator::None:
+    break;
+  }
+  return false;
+}
+
+template <typename Number> Number RunningExpression<Number>::value() const {
+  return combine(sum, additive, product);
+}
+
+template <typename Number>
+std::optional<Number> RunningExpression<Number>::peek(
+    Operator op, const Number &operand) const {
+  RunningExpression next = *this;
+  if (!next.push(op, operand)) {
+    return std::nullopt;
+  }
+  return next.value();
+}
+
+template class RunningExpression<double>;
+template class RunningExpression<Decimal>;
+
+} // namespace calc
@@ -0,0 +1,37 @@
+#pragma once
+#include "engine/Arithmetic.hpp"
+#include <optional>
+
+namespace calc {
+
+// Keypad expression "a op b op c ..." evaluated one operand at a time, with
+// × and ÷ binding tighter than + and -. Keeps the finished additive part
+// and the pending product, so each operand costs O(1) however long the
+// chain, and results equal compiling and evaluating the whole expression.
+// Instantiated for double and Decimal.
+template <typename Number> class RunningExpression {
+public:
+  void clear();
+
+  bool empty() const { return !started; }
+
+  // Appends `operand`, joined to what came before by `op` (ignored for the
+  // first operand). Fails, leaving the expression unchanged, on division
+  // by zero.
+  bool push(Operator op, const Number &operand);
+
+  // Value of everything pushed so far
+  Number value() const;
+
+  // Value the expression would have with `operand` appended, without
+  // appending it; std::nullopt on division by zero
+  std::optional<Number> peek(Operator op, const Number &operand) const;
+
+private:
+  Number sum{};                       // Additive terms already complete
+  Operator additive = Operator::None; // Joins `sum` and `product`
+  Number product{};                   // Multiplicative term still growing
+  bool started = false;
+};
+
+} // namespace calc
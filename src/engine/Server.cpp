@@ -0,0 +1,517 @@
+#include "engine/Server.hpp"
+#include "engine/ResultCache.hpp"
+#include <atomic>
+#include <csignal>
+#include <cstdio>
+#include <deque>
+#include <optional>
+#include <string_view>
+
+#ifdef __linux__
+#include <cerrno>
+#include <cstring>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace calc {
+
+// One frame, evaluated on the pool
+struct Server::Request {
+  std::string payload;
+  std::string response; // The whole response frame
+  BatchStats stats;
+  std::atomic<bool> done{false};
+};
+
+struct Server::Connection {
+  std::string input;        // Received bytes, frames not yet handed out
+  std::size_t parsed = 0;   // Bytes of `input` already handed out
+  // Requests being evaluated, oldest first; answered in this order
+  std::deque<std::shared_ptr<Request>> requests;
+  std::size_t evaluating = 0; // Payload bytes of `requests`
+  std::string output;       // Encoded responses not yet sent
+  std::size_t sent = 0;     // Bytes of `output` already sent
+  std::uint32_t events = 0; // What epoll currently watches for
+  bool ended = false;       // The client shut down its sending side
+};
+
+#ifdef __linux__
+
+namespace {
+
+// Read per recv() call; also how far one client may get ahead of the rest
+// in a single pass of the event loop
+constexpr std::size_t kReadBytes = 64 << 10;
+// Unsent responses and unanswered requests beyond which a client's
+// requests are not read until it catches up
+constexpr std::size_t kMaxPending = 4 << 20;
+constexpr int kEventBatch = 256;
+// How long the listener is left unwatched when out of descriptors, unless
+// a connection closes first
+constexpr int kAcceptRetryMs = 100;
+
+std::uint32_t readLength(const char *bytes) {
+  std::uint32_t value = 0;
+  for (int i = 3; i >= 0; --i) {
+    value = value << 8 | static_cast<unsigned char>(bytes[i]);
+  }
+  return value;
+}
+
+void writeLength(char *bytes, std::size_t length) {
+  for (int i = 0; i < 4; ++i) {
+    bytes[i] = static_cast<char>(length >> (8 * i) & 0xFF);
+  }
+}
+
+} // namespace
+
+Server::Server(const std::string &path, NumericBackend backend,
+               ResultCache *cache)
+    : path(path), backend(backend), cache(cache), scratch(kReadBytes) {
+  const auto fail = [this](const std::string &what) {
+    errorText = what + ": " + std::strerror(errno);
+    if (listener >= 0) {
+      ::close(listener);
+      listener = -1;
+    }
+  };
+
+  sockaddr_un address{};
+  address.sun_family = AF_UNIX;
+  if (path.empty() || path.size() >= sizeof(address.sun_path)) {
+    errorText = path + ": socket path too long";
+    return;
+  }
+  std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+  // A socket left behind by a server that died is replaced; any other
+  // file at the path is not
+  struct stat info {};
+  if (::lstat(path.c_str(), &info) == 0) {
+    if (!S_ISSOCK(info.st_mode)) {
+      errorText = path + ": exists and is not a socket";
+      return;
+    }
+    ::unlink(path.c_str());
+  }
+
+  listener = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (listener < 0) {
+    fail("socket");
+    return;
+  }
+  if (::bind(listener, reinterpret_cast<const sockaddr *>(&address),
+             sizeof(address)) != 0) {
+    fail(path);
+    return;
+  }
+  if (::listen(listener, SOMAXCONN) != 0) {
+    fail(path);
+    return;
+  }
+
+  poller = ::epoll_create1(EPOLL_CLOEXEC);
+  stopper = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  notifier = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (poller < 0 || stopper < 0 || notifier < 0) {
+    fail("epoll");
+    return;
+  }
+  for (const int fd : {listener, stopper, notifier}) {
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = fd;
+    if (::epoll_ctl(poller, EPOLL_CTL_ADD, fd, &event) != 0) {
+      fail("epoll");
+      return;
+    }
+  }
+  pool = std::make_unique<ThreadPool>();
+}
+
+Server::~Server() {
+  pool.reset(); // Requests still being evaluated write to `notifier`
+  for (std::size_t fd = 0; fd < connections.size(); ++fd) {
+    if (connections[fd]) {
+      ::close(static_cast<int>(fd));
+    }
+  }
+  for (const int fd : {poller, stopper, notifier}) {
+    if (fd >= 0) {
+      ::close(fd);
+    }
+  }
+  if (listener >= 0) {
+    ::close(listener);
+    ::unlink(path.c_str());
+  }
+}
+
+bool Server::run() {
+  if (!isOpen()) {
+    return false;
+  }
+  epoll_event events[kEventBatch];
+  std::vector<int> ready;
+  for (;;) {
+    const int count = ::epoll_wait(poller, events, kEventBatch,
+                                   accepting ? -1 : kAcceptRetryMs);
+    if (count < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      errorText = std::string("epoll: ") + std::strerror(errno);
+      return false;
+    }
+    if (count == 0) {
+      setAccepting(true); // Try again; accept() pauses it if still short
+    }
+    for (int i = 0; i < count; ++i) {
+      const int fd = events[i].data.fd;
+      const std::uint32_t flags = events[i].events;
+      if (fd == listener) {
+        accept();
+        continue;
+      }
+      if (fd == stopper) {
+        std::uint64_t value = 0;
+        [[maybe_unused]] const auto drained =
+            ::read(stopper, &value, sizeof(value));
+        return true;
+      }
+      if (fd == notifier) {
+        std::uint64_t value = 0;
+        [[maybe_unused]] const auto drained =
+            ::read(notifier, &value, sizeof(value));
+        {
+          const std::lock_guard lock(finishedMutex);
+          ready.swap(finished);
+        }
+        for (const int connection : ready) {
+          deliver(connection);
+        }
+        ready.clear();
+        continue;
+      }
+      // An earlier event in this batch may have closed the connection
+      const auto index = static_cast<std::size_t>(fd);
+      if (index >= connections.size() || !connections[index]) {
+        continue;
+      }
+      // Error, or the client has closed both directions and cannot read
+      // what is still to be answered
+      if (flags & (EPOLLERR | EPOLLHUP)) {
+        close(fd);
+        continue;
+      }
+      if (flags & EPOLLOUT) {
+        send(fd);
+      }
+      if ((flags & EPOLLIN) && connections[index]) {
+        receive(fd);
+      }
+    }
+  }
+}
+
+void Server::stop() {
+  if (stopper >= 0) {
+    const std::uint64_t one = 1;
+    [[maybe_unused]] const auto written = ::write(stopper, &one, sizeof(one));
+  }
+}
+
+void Server::accept() {
+  for (;;) {
+    const int fd =
+        ::accept4(listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (fd < 0) {
+      // EAGAIN once the backlog is empty. Out of descriptors or memory,
+      // the listener stays readable and would wake the loop at once: it
+      // is left unwatched until a connection closes or kAcceptRetryMs
+      // pass
+      if (errno == EMFILE || errno == ENFILE || errno == ENOBUFS ||
+          errno == ENOMEM) {
+        setAccepting(false);
+      }
+      return;
+    }
+    const auto index = static_cast<std::size_t>(fd);
+    if (index >= connections.size()) {
+      connections.resize(index + 1);
+    }
+    connections[index] = std::make_unique<Connection>();
+    connections[index]->events = EPOLLIN;
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = fd;
+    if (::epoll_ctl(poller, EPOLL_CTL_ADD, fd, &event) != 0) {
+      connections[index].reset();
+      ::close(fd);
+      continue;
+    }
+    ++totals.connections;
+  }
+}
+
+void Server::setAccepting(bool on) {
+  if (on == accepting) {
+    return;
+  }
+  epoll_event event{};
+  event.events = on ? std::uint32_t{EPOLLIN} : 0U;
+  event.data.fd = listener;
+  ::epoll_ctl(poller, EPOLL_CTL_MOD, listener, &event);
+  accepting = on;
+}
+
+void Server::receive(int fd) {
+  Connection &connection = *connections[static_cast<std::size_t>(fd)];
+  std::string &input = connection.input;
+  const ssize_t received = ::recv(fd, scratch.data(), scratch.size(), 0);
+  if (received < 0) {
+    if (errno != EAGAIN && errno != EINTR) {
+      close(fd);
+    }
+    return;
+  }
+  input.append(scratch.data(), static_cast<std::size_t>(received));
+  connection.ended = received == 0;
+
+  // Every complete frame goes to the pool; a partial one waits for the
+  // rest of its bytes
+  while (input.size() - connection.parsed >= 4) {
+    const std::uint32_t length = readLength(input.data() + connection.parsed);
+    if (length > kMaxFrame) {
+      close(fd);
+      return;
+    }
+    if (input.size() - connection.parsed - 4 < length) {
+      break;
+    }
+    auto request = std::make_shared<Request>();
+    request->payload.assign(input, connection.parsed + 4, length);
+    connection.requests.push_back(request);
+    connection.evaluating += length;
+    connection.parsed += 4 + std::size_t{length};
+    ++totals.frames;
+    pool->submit([this, fd, request = std::move(request)] {
+      std::string &response = request->response;
+      response.assign(4, '\0');
+      evaluateLines(request->payload, true, response, request->stats,
+                    backend, cache);
+      writeLength(response.data(), response.size() - 4);
+      request->done.store(true, std::memory_order_release);
+      {
+        const std::lock_guard lock(finishedMutex);
+        finished.push_back(fd);
+      }
+      const std::uint64_t one = 1;
+      [[maybe_unused]] const auto written =
+          ::write(notifier, &one, sizeof(one));
+    });
+  }
+  if (connection.parsed == input.size()) {
+    input.clear();
+    connection.parsed = 0;
+  } else if (connection.parsed >= input.size() / 2) {
+    input.erase(0, connection.parsed);
+    connection.parsed = 0;
+  }
+  send(fd);
+}
+
+// Moves the responses evaluated so far to the output, in request order.
+// `fd` may since have been closed, or even reused by a new connection,
+// whose requests are then merely checked.
+void Server::deliver(int fd) {
+  const auto index = static_cast<std::size_t>(fd);
+  if (index >= connections.size() || !connections[index]) {
+    return;
+  }
+  Connection &connection = *connections[index];
+  while (!connection.requests.empty() &&
+         connection.requests.front()->done.load(std::memory_order_acquire)) {
+    Request &request = *connection.requests.front();
+    connection.output += request.response;
+    totals.expressions += request.stats;
+    connection.evaluating -= request.payload.size();
+    connection.requests.pop_front();
+  }
+  send(fd);
+}
+
+void Server::send(int fd) {
+  Connection &connection = *connections[static_cast<std::size_t>(fd)];
+  std::string &output = connection.output;
+  while (connection.sent < output.size()) {
+    const ssize_t sent =
+        ::send(fd, output.data() + connection.sent,
+               output.size() - connection.sent, MSG_NOSIGNAL);
+    if (sent < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      if (errno == EAGAIN) {
+        break;
+      }
+      close(fd);
+      return;
+    }
+    connection.sent += static_cast<std::size_t>(sent);
+  }
+  if (connection.sent == output.size()) {
+    output.clear();
+    connection.sent = 0;
+    if (connection.ended && connection.requests.empty()) {
+      close(fd); // Everything the client asked for has been answered
+      return;
+    }
+  }
+  watch(fd);
+}
+
+// Waits for EPOLLOUT while responses are queued, and for EPOLLIN unless the
+// client has stopped sending or is too far behind reading
+void Server::watch(int fd) {
+  Connection &connection = *connections[static_cast<std::size_t>(fd)];
+  const std::size_t unsent = connection.output.size() - connection.sent;
+  std::uint32_t events = 0;
+  if (unsent > 0) {
+    events |= EPOLLOUT;
+  }
+  if (!connection.ended && unsent + connection.evaluating < kMaxPending) {
+    events |= EPOLLIN;
+  }
+  if (events != connection.events) {
+    epoll_event event{};
+    event.events = events;
+    event.data.fd = fd;
+    ::epoll_ctl(poller, EPOLL_CTL_MOD, fd, &event);
+    connection.events = events;
+  }
+}
+
+void Server::close(int fd) {
+  ::epoll_ctl(poller, EPOLL_CTL_DEL, fd, nullptr);
+  ::close(fd);
+  connections[static_cast<std::size_t>(fd)].reset();
+  setAccepting(true); // A descriptor is free again
+}
+
+#else
+
+Server::Server(const std::string &path, NumericBackend backend,
+               ResultCache *cache)
+    : path(path), backend(backend), cache(cache),
+      errorText("--serve needs Linux (epoll)") {}
+
+Server::~Server() = default;
+
+bool Server::run() { return false; }
+
+void Server::stop() {}
+
+void Server::accept() {}
+void Server::setAccepting(bool) {}
+void Server::receive(int) {}
+void Server::deliver(int) {}
+void Server::send(int) {}
+void Server::watch(int) {}
+void Server::close(int) {}
+
+#endif
+
+namespace {
+
+Server *serving = nullptr; // For the signal handlers
+
+void stopServing(int) {
+  if (serving) {
+    serving->stop();
+  }
+}
+
+} // namespace
+
+int runServe(int argc, char *argv[]) {
+  static constexpr const char *kUsage =
+      "Usage: Calculator --serve [--decimal] [--cache N] SOCKET\n";
+  const char *path = nullptr;
+  NumericBackend backend = NumericBackend::Double;
+  std::size_t cacheEntries = 0;
+  for (int i = 0; i < argc; ++i) {
+    const std::string_view arg = argv[i];
+    if (arg == "--decimal") {
+      backend = NumericBackend::Decimal;
+    } else if (arg == "--cache" && i + 1 < argc) {
+      const std::optional<std::size_t> count = parseCount(argv[++i]);
+      if (!count) {
+        std::fprintf(stderr, "Calculator: invalid entry count '%s'\n",
+                     argv[i]);
+        std::fputs(kUsage, stderr);
+        return 2;
+      }
+      cacheEntries = *count;
+    } else if (arg.starts_with("-") || path) {
+      std::fputs(kUsage, stderr);
+      return 2;
+    } else {
+      path = argv[i];
+    }
+  }
+  if (!path) {
+    std::fputs(kUsage, stderr);
+    return 2;
+  }
+
+#ifdef __linux__
+  // Every client holds a descriptor; allow as many as the hard limit does
+  rlimit files{};
+  if (::getrlimit(RLIMIT_NOFILE, &files) == 0 &&
+      files.rlim_cur < files.rlim_max) {
+    files.rlim_cur = files.rlim_max;
+    ::setrlimit(RLIMIT_NOFILE, &files);
+  }
+#endif
+
+  std::unique_ptr<ResultCache> cache;
+  if (cacheEntries > 0) {
+    cache = std::make_unique<ResultCache>(cacheEntries);
+  }
+  Server server(path, backend, cache.get());
+  if (!server.isOpen()) {
+    std::fprintf(stderr, "Calculator: %s\n", server.error().c_str());
+    return 1;
+  }
+
+  // Ctrl+C and kill end the loop cleanly, which removes the socket file
+  serving = &server;
+  std::signal(SIGINT, stopServing);
+  std::signal(SIGTERM, stopServing);
+  std::fprintf(stderr, "Calculator: serving on %s\n", path);
+  const bool ok = server.run();
+  serving = nullptr;
+
+  const Server::Stats &stats = server.stats();
+  std::fprintf(stderr,
+               "Calculator: %llu connections, %llu requests, %zu "
+               "expressions (%zu errors)\n",
+               static_cast<unsigned long long>(stats.connections),
+               static_cast<unsigned long long>(stats.frames),
+               stats.expressions.lines, stats.expressions.errors);
+  if (!ok) {
+    std::fprintf(stderr, "Calculator: %s\n", server.error().c_str());
+    return 1;
+  }
+  return 0;
+}
+
+} // namespace calc
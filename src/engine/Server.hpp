@@ -0,0 +1,93 @@
+#pragma once
+#include "engine/Backend.hpp"
+#include "engine/Batch.hpp"
+#include "engine/ThreadPool.hpp"
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace calc {
+
+class ResultCache;
+
+// Evaluation server on a Unix domain socket. Every message in either
+// direction is a frame:
+//
+//   length payload      payload byte count (little-endian uint32), then
+//                       the payload itself
+//
+// A request payload holds one or more expressions, one per line; the
+// response payload holds their results in the same order, one per line,
+// exactly as `--batch` prints them. Clients may pipeline any number of
+// frames without waiting; responses come back in request order.
+//
+// One epoll loop serves every client with non-blocking sockets, so
+// thousands of idle or busy connections cost a buffer each rather than a
+// thread each. Frames are evaluated on a ThreadPool, so a large frame
+// never stalls the loop or the other clients; each connection's responses
+// are still sent in the order of its requests. Linux only; elsewhere the
+// server fails to open.
+class Server {
+public:
+  // Largest payload accepted; a bigger frame closes its connection
+  static constexpr std::uint32_t kMaxFrame = 16 << 20;
+
+  Server(const std::string &path, NumericBackend backend,
+         ResultCache *cache = nullptr);
+  ~Server();
+
+  Server(const Server &) = delete;
+  Server &operator=(const Server &) = delete;
+
+  bool isOpen() const { return listener >= 0; }
+  const std::string &error() const { return errorText; }
+
+  // Serves until stop() is called; false if the event loop failed
+  bool run();
+  // Makes run() return; safe from other threads and signal handlers
+  void stop();
+
+  struct Stats {
+    std::uint64_t connections = 0;
+    std::uint64_t frames = 0;
+    BatchStats expressions;
+  };
+  const Stats &stats() const { return totals; }
+
+private:
+  struct Request;
+  struct Connection;
+
+  std::string path;
+  NumericBackend backend;
+  ResultCache *cache;
+  std::string errorText;
+  int listener = -1;
+  int poller = -1;
+  int stopper = -1;  // eventfd written by stop()
+  int notifier = -1; // eventfd written when a request has been evaluated
+  bool accepting = true; // Whether epoll watches the listener
+  std::vector<std::unique_ptr<Connection>> connections; // Indexed by fd
+  std::vector<char> scratch; // recv() target shared by every connection
+  Stats totals;
+
+  // Shared with the pool's workers
+  std::mutex finishedMutex;
+  std::vector<int> finished; // Connections with a request just evaluated
+  std::unique_ptr<ThreadPool> pool;
+
+  void accept();
+  void setAccepting(bool on);
+  void receive(int fd);
+  void deliver(int fd);
+  void send(int fd);
+  void watch(int fd);
+  void close(int fd);
+};
+
+// Entry point for `Calculator --serve [--decimal] [--cache N] SOCKET`
+int runServe(int argc, char *argv[]);
+
+} // namespace calc
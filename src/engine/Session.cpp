@@ -0,0 +1,483 @@
+#include "engine/Session.hpp"
+#include "engine/Decimal.hpp"
+#include "engine/Expression.hpp"
+#include "engine/Format.hpp"
+#include <charconv>
+
+namespace calc {
+
+void Session::inputDigit(char digit) {
+  if (waitingForNumber || displayText == "0") {
+    displayText.assign(1, digit);
+    waitingForNumber = false;
+  } else {
+    displayText += digit;
+  }
+  updatePreview();
+}
+
+void Session::inputDecimalPoint() {
+  if (waitingForNumber) {
+    displayText = "0.";
+  } else if (displayText.find('.') == std::string::npos) {
+    displayText += '.';
+  }
+  waitingForNumber = false;
+  updatePreview();
+}
+
+void Session::negate() {
+  if (backend == NumericBackend::Decimal) {
+    displayText = (-Decimal::parse(displayText).value_or(Decimal())).toString();
+  } else {
+    displayText = formatGeneral(-parseNumber(displayText));
+  }
+  updatePreview();
+}
+
+void Session::percent() {
+  if (backend == NumericBackend::Decimal) {
+    displayText =
+        Decimal::parse(displayText).value_or(Decimal()).percent().toString();
+  } else {
+    displayText = formatGeneral(parseNumber(displayText) / 100.0);
+  }
+  waitingForNumber = true;
+  updatePreview();
+}
+
+void Session::allClear() {
+  displayText.assign(1, '0');
+  result = 0.0;
+  operation = Operator::None;
+  resetExpression();
+  waitingForNumber = true;
+  updatePreview();
+}
+
+void Session::clear() {
+  displayText.assign(1, '0');
+  waitingForNumber = true;
+  updatePreview();
+}
+
+void Session::clearEntry() {
+  displayText.assign(1, '0');
+  result = 0.0;
+  operation = Operator::None;
+  resetExpression();
+  waitingForNumber = true;
+  updatePreview();
+}
+
+void Session::backspace() {
+  if (displayText.size() > 1) {
+    displayText.pop_back();
+  } else {
+    displayText.assign(1, '0');
+  }
+  if (displayText == "0") {
+    waitingForNumber = true;
+  }
+  updatePreview();
+}
+
+void Session::equals() {
+  if (operation != Operator::None) {
+    calculate();
+    // A failed calculation has already reset the operation
+    if (history && operation != Operator::None) {
+      history->append(calculationHistory, displayText);
+    }
+    operation = Operator::None;
+    resetExpression();
+    waitingForNumber = true;
+    updatePreview();
+  }
+}
+
+void Session::performOperation(Operator op) {
+  if (operation != Operator::None) {
+    // Chain operations: fold the operand into the running result
+    calculate();
+    if (operation == Operator::None) {
+      return; // The calculation failed and reset the session
+    }
+  } else {
+    // First operation: start new calculation
+    result = parseNumber(displayText);
+    resetExpression();
+    if (!appendOperand()) {
+      return;
+    }
+  }
+  calculationHistory += ' ';
+  calculationHistory += symbolOf(op);
+  operation = op;
+  waitingForNumber = true;
+  updatePreview();
+}
+
+void Session::setConversion(std::optional<Conversion> to) {
+  conversion = to;
+  updateConversion();
+}
+
+void Session::setNumericBackend(NumericBackend numeric) {
+  if (numeric != backend) {
+    backend = numeric;
+    allClear();
+    forgetSteps(); // Their expressions belong to the other backend
+  }
+}
+
+std::string_view Session::previewTail(std::size_t maxBytes) const {
+  const std::string_view text = previewText;
+  if (text.size() <= maxBytes) {
+    return text;
+  }
+  std::size_t start = text.size() - maxBytes;
+  // Skip UTF-8 continuation bytes so "×" and "÷" are never split
+  while (start < text.size() &&
+         (static_cast<unsigned char>(text[start]) & 0xC0) == 0x80) {
+    ++start;
+  }
+  return text.substr(start);
+}
+
+void Session::dispatch(Action action) {
+  const ScopedLatency timer(latency, LatencyStage::Dispatch);
+  if (timeline.empty()) {
+    record(); // The state before the first step
+  }
+  switch (action) {
+  case Action::Digit0:
+  case Action::Digit1:
+  case Action::Digit2:
+  case Action::Digit3:
+  case Action::Digit4:
+  case Action::Digit5:
+  case Action::Digit6:
+  case Action::Digit7:
+  case Action::Digit8:
+  case Action::Digit9:
+    inputDigit(static_cast<char>(
+        '0' + (static_cast<int>(action) - static_cast<int>(Action::Digit0))));
+    break;
+  case Action::DecimalPoint:
+    inputDecimalPoint();
+    break;
+  case Action::Negate:
+    negate();
+    break;
+  case Action::AllClear:
+    allClear();
+    break;
+  case Action::Percent:
+    percent();
+    break;
+  case Action::Clear:
+    clear();
+    break;
+  case Action::ClearEntry:
+    clearEntry();
+    break;
+  case Action::Backspace:
+    backspace();
+    break;
+  case Action::Equals:
+    equals();
+    break;
+  case Action::Add:
+    performOperation(Operator::Add);
+    break;
+  case Action::Subtract:
+    performOperation(Operator::Subtract);
+    break;
+  case Action::Multiply:
+    performOperation(Operator::Multiply);
+    break;
+  case Action::Divide:
+    performOperation(Operator::Divide);
+    break;
+  case Action::Undo:
+    undo();
+    return;
+  case Action::Redo:
+    redo();
+    return;
+  }
+  record();
+}
+
+std::string_view Session::displayOf(const Snapshot &step) const {
+  return std::string_view(displayTexts)
+      .substr(step.displayBegin, step.displayLength);
+}
+
+void Session::undo() {
+  if (canUndo()) {
+    restore(cursor - 1);
+  }
+}
+
+void Session::redo() {
+  if (canRedo()) {
+    restore(cursor + 1);
+  }
+}
+
+void Session::jumpTo(std::size_t step) {
+  if (step < timeline.size()) {
+    restore(step);
+  }
+}
+
+// Appends the state dispatch() left behind as a new step, unless nothing
+// visible changed
+void Session::record() {
+  const bool first = timeline.empty();
+  const bool reset = first || historyReset;
+  historyReset = false;
+  const char *message =
+      calculationHistory.empty() && !previewText.empty() ? failure : nullptr;
+  if (!first) {
+    const Snapshot &last = timeline[cursor];
+    // Between resets the history only grows, so its length tells whether
+    // it changed
+    const bool historyChanged =
+        reset || calculationHistory.size() != last.history.length;
+    if (!historyChanged && displayText == displayOf(last) &&
+        operation == last.operation &&
+        waitingForNumber == last.waitingForNumber && message == last.message) {
+      return;
+    }
+    // A new step after undoing replaces the steps undone, and the text
+    // and states only they used
+    if (canRedo()) {
+      timeline.resize(cursor + 1);
+      const Snapshot &kept = timeline.back();
+      historyText.rollback(kept.historyMark);
+      displayTexts.resize(kept.displayBegin + kept.displayLength);
+      expressionStates.resize(std::min(expressionStates.size(),
+                                       std::size_t{kept.expressionState} + 1));
+      decimalExpressionStates.resize(
+          std::min(decimalExpressionStates.size(),
+                   std::size_t{kept.expressionState} + 1));
+    }
+  }
+
+  Snapshot next;
+  next.result = result;
+  next.operation = operation;
+  next.waitingForNumber = waitingForNumber;
+  next.message = message;
+  if (!first && displayText == displayOf(timeline[cursor])) {
+    next.displayBegin = timeline[cursor].displayBegin;
+  } else {
+    next.displayBegin = static_cast<std::uint32_t>(displayTexts.size());
+    displayTexts += displayText;
+  }
+  next.displayLength = static_cast<std::uint32_t>(displayText.size());
+  if (!first && !reset &&
+      calculationHistory.size() == timeline[cursor].history.length) {
+    next.history = timeline[cursor].history;
+    next.historyMark = timeline[cursor].historyMark;
+    next.expressionState = timeline[cursor].expressionState;
+  } else {
+    const PersistentText::Version base =
+        reset ? PersistentText::Version{} : timeline[cursor].history;
+    next.history = historyText.append(
+        base, std::string_view(calculationHistory).substr(base.length));
+    next.historyMark = historyText.mark();
+    if (backend == NumericBackend::Decimal) {
+      decimalExpressionStates.push_back(decimalExpression);
+      next.expressionState =
+          static_cast<std::uint32_t>(decimalExpressionStates.size() - 1);
+    } else {
+      expressionStates.push_back(expression);
+      next.expressionState =
+          static_cast<std::uint32_t>(expressionStates.size() - 1);
+    }
+  }
+  timeline.push_back(next);
+  cursor = timeline.size() - 1;
+}
+
+void Session::restore(std::size_t step) {
+  cursor = step;
+  const Snapshot &state = timeline[step];
+  historyText.read(state.history, calculationHistory);
+  if (backend == NumericBackend::Decimal) {
+    decimalExpression = decimalExpressionStates[state.expressionState];
+  } else {
+    expression = expressionStates[state.expressionState];
+  }
+  result = state.result;
+  operation = state.operation;
+  waitingForNumber = state.waitingForNumber;
+  displayText = displayOf(state);
+  failure = state.message;
+  historyReset = false;
+
+  // The preview is rebuilt from the history like after any key press
+  previewSynced = 0;
+  if (state.message) {
+    previewText = state.message;
+    runningText.clear();
+    updateConversion();
+  } else {
+    updatePreview();
+  }
+}
+
+void Session::forgetSteps() {
+  timeline.clear();
+  cursor = 0;
+  historyText.clear();
+  displayTexts.clear();
+  expressionStates.clear();
+  decimalExpressionStates.clear();
+  historyReset = false;
+}
+
+void Session::calculate() {
+  const ScopedLatency timer(latency, LatencyStage::Calculate);
+  if (operation == Operator::None || !appendOperand()) {
+    return;
+  }
+  if (backend == NumericBackend::Decimal) {
+    const Decimal value = decimalExpression.value();
+    result = value.toDouble();
+    displayText.clear();
+    value.appendTo(displayText);
+  } else {
+    result = expression.value();
+    NumberBuffer buffer;
+    displayText.assign(formatNumber(result, buffer));
+  }
+}
+
+bool Session::appendOperand() {
+  // The first operand starts the expression; later ones join it with the
+  // pending operator
+  const Operator op =
+      calculationHistory.empty() ? Operator::None : operation;
+  const std::string operand = operandText();
+  if (op != Operator::None) {
+    calculationHistory += ' ';
+  }
+  calculationHistory += operand;
+
+  // Operands are read exactly as the expression compiler reads literals
+  const bool compiled = compile(operand, operandProgram);
+  bool divided = true;
+  if (backend == NumericBackend::Decimal) {
+    const auto value =
+        compiled ? evaluateDecimal(operandProgram) : std::nullopt;
+    if (!value) {
+      fail("Invalid expression");
+      return false;
+    }
+    divided = decimalExpression.push(op, *value);
+  } else {
+    const auto value = compiled ? evaluate(operandProgram) : std::nullopt;
+    if (!value) {
+      fail("Invalid expression");
+      return false;
+    }
+    divided = expression.push(op, *value);
+  }
+  if (!divided) {
+    fail("Cannot divide by zero");
+    return false;
+  }
+  return true;
+}
+
+void Session::resetExpression() {
+  historyReset = true;
+  calculationHistory.clear();
+  expression.clear();
+  decimalExpression.clear();
+  previewSynced = 0;
+  previewText.clear();
+  runningText.clear();
+}
+
+void Session::fail(const char *message) {
+  displayText = "Error";
+  resetExpression();
+  previewText = message;
+  failure = message;
+  operation = Operator::None;
+  waitingForNumber = true;
+  updateConversion();
+}
+
+std::string Session::operandText() const {
+  // Display text that is not a plain number ("Error", a lone "-") enters
+  // the expression as its numeric value
+  double value = 0.0;
+  const char *last = displayText.data() + displayText.size();
+  const auto [end, ec] = std::from_chars(displayText.data(), last, value);
+  if (ec == std::errc() && end == last) {
+    return displayText;
+  }
+  return formatNumber(parseNumber(displayText));
+}
+
+// A multiply and an add into a string that keeps its capacity, so this
+// costs next to nothing on each key press
+void Session::updateConversion() {
+  convertedText.clear();
+  if (conversion && displayText != "Error") {
+    NumberBuffer buffer;
+    convertedText.assign(
+        formatNumber((*conversion)(parseNumber(displayText)), buffer));
+  }
+}
+
+void Session::updatePreview() {
+  const ScopedLatency timer(latency, LatencyStage::Preview);
+  updateConversion();
+  runningText.clear();
+  if (calculationHistory.empty()) {
+    previewText.clear();
+    previewSynced = 0;
+    return;
+  }
+
+  // Only the part of the history added since the last update is copied,
+  // so long chains cost the length of the new tail, not of the whole text
+  previewText.resize(previewSynced);
+  previewText.append(calculationHistory, previewSynced);
+  previewSynced = calculationHistory.size();
+  if (operation == Operator::None || waitingForNumber) {
+    return;
+  }
+
+  // Show ongoing calculation and what = would give
+  previewText += ' ';
+  previewText += displayText;
+  const bool compiled = compile(operandText(), operandProgram);
+  if (backend == NumericBackend::Decimal) {
+    const auto operand =
+        compiled ? evaluateDecimal(operandProgram) : std::nullopt;
+    const auto value =
+        operand ? decimalExpression.peek(operation, *operand) : std::nullopt;
+    if (value) {
+      value->appendTo(runningText);
+    }
+  } else {
+    const auto operand = compiled ? evaluate(operandProgram) : std::nullopt;
+    const auto value =
+        operand ? expression.peek(operation, *operand) : std::nullopt;
+    if (value) {
+      NumberBuffer buffer;
+      runningText.assign(formatNumber(*value, buffer));
+    }
+  }
+}
+
+} // namespace calc
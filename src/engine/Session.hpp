@@ -0,0 +1,145 @@
+#pragma once
+#include "engine/Action.hpp"
+#include "engine/Arithmetic.hpp"
+#include "engine/Backend.hpp"
+#include "engine/Decimal.hpp"
+#include "engine/HistoryLog.hpp"
+#include "engine/Latency.hpp"
+#include "engine/PersistentText.hpp"
+#include "engine/RunningExpression.hpp"
+#include "engine/Units.hpp"
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace calc {
+
+// Headless keypad state machine. Calculator forwards every button press here
+// and mirrors display() / preview() into its widgets, so the same sequence of
+// presses can be driven without Qt.
+class Session {
+public:
+  void inputDigit(char digit);
+  void inputDecimalPoint();
+  void negate();
+  void percent();
+  void allClear();
+  void clear();
+  void clearEntry();
+  void backspace();
+  void equals();
+  void performOperation(Operator op);
+
+  // Runs the method behind a keypad button or keyboard command
+  void dispatch(Action action);
+
+  // Every dispatch() that changes what the keypad shows is a step, kept
+  // for undo() and redo() (Action::Undo and Action::Redo) without limit. A
+  // step taken after undoing replaces the steps undone. Steps share the
+  // expression text, so each costs the same few dozen bytes however long
+  // the expression has grown, and jumping to any step costs one copy of
+  // the expression text.
+  void undo();
+  void redo();
+  bool canUndo() const { return cursor > 0; }
+  bool canRedo() const { return cursor + 1 < timeline.size(); }
+  // Current step, counted from 0 for the state before the first, and one
+  // more than the highest step jumpTo() accepts
+  std::size_t step() const { return cursor; }
+  std::size_t steps() const { return timeline.size(); }
+  void jumpTo(std::size_t step);
+
+  // Number type used for results, ± and %; Double unless set otherwise.
+  // Switching backends clears the session.
+  NumericBackend numericBackend() const { return backend; }
+  void setNumericBackend(NumericBackend numeric);
+
+  // Times dispatch(), calculate() and updatePreview() into `monitor`
+  // (null, the default, turns timing off)
+  void setLatencyMonitor(LatencyMonitor *monitor) { latency = monitor; }
+
+  // Appends every calculation = completes to `log` (null for none)
+  void setHistoryLog(HistoryLog *log) { history = log; }
+
+  // Converts display() with `conversion` into converted() on every key
+  // press (std::nullopt, the default, leaves converted() empty)
+  void setConversion(std::optional<Conversion> conversion);
+
+  // Text of the main display ("0", "12.5", "Error", ...)
+  const std::string &display() const { return displayText; }
+  // Text of the preview line above it
+  const std::string &preview() const { return previewText; }
+  // The last `maxBytes` of preview() (fewer to keep UTF-8 intact), for
+  // labels too narrow to show a long chain
+  std::string_view previewTail(std::size_t maxBytes) const;
+  // Result the expression would have if = were pressed now, while an
+  // operand is being typed after an operator; empty otherwise
+  const std::string &running() const { return runningText; }
+  // display() converted with the conversion set above, as a double
+  const std::string &converted() const { return convertedText; }
+  // Value of the expression entered so far, honouring operator precedence
+  double value() const { return result; }
+
+private:
+  double result = 0.0;
+  Operator operation = Operator::None;
+  bool waitingForNumber = true;
+  std::string calculationHistory; // Expression entered so far, e.g. "2 + 3 ×"
+  std::string displayText = "0";
+  std::string previewText;
+  std::string runningText;
+  std::string convertedText;
+  std::optional<Conversion> conversion;
+  NumericBackend backend = NumericBackend::Double;
+  LatencyMonitor *latency = nullptr;
+  HistoryLog *history = nullptr;
+
+  // calculationHistory's value, kept up to date operand by operand
+  RunningExpression<double> expression;
+  RunningExpression<Decimal> decimalExpression;
+  // previewText starts with this many bytes of calculationHistory, which
+  // only ever grows until resetExpression()
+  std::size_t previewSynced = 0;
+  // Every operand is compiled into this, so key presses reuse its buffers
+  Program operandProgram;
+  const char *failure = nullptr; // Message of the last fail()
+
+  // What a step restores. The history is a version of historyText, the
+  // display a slice of displayTexts and the running expression an index
+  // into the states of the backend in use; steps that did not change one
+  // of them share it with the step before. Plain data, so the timeline
+  // grows by memcpy.
+  struct Snapshot {
+    PersistentText::Version history;
+    PersistentText::Mark historyMark; // historyText once `history` was in
+    std::uint32_t displayBegin;
+    std::uint32_t displayLength;
+    std::uint32_t expressionState;
+    Operator operation;
+    bool waitingForNumber;
+    double result;
+    const char *message; // Preview without an expression, i.e. an error
+  };
+  std::vector<Snapshot> timeline;
+  std::size_t cursor = 0; // Step of the current state
+  PersistentText historyText;
+  std::string displayTexts;
+  std::vector<RunningExpression<double>> expressionStates;
+  std::vector<RunningExpression<Decimal>> decimalExpressionStates;
+  bool historyReset = false; // Since the last step was recorded
+
+  void calculate();
+  bool appendOperand();
+  void resetExpression();
+  void fail(const char *message);
+  void updatePreview();
+  void updateConversion();
+  void record();
+  void restore(std::size_t step);
+  void forgetSteps();
+  std::string_view displayOf(const Snapshot &step) const;
+  std::string operandText() const;
+};
+
+} // namespace calc
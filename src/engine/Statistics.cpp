@@ -0,0 +1,301 @@
+#include "engine/Statistics.hpp"
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+#include <vector>
+
+namespace calc {
+
+void CompensatedSum::add(double value) {
+  const double next = sum + value;
+  // Whatever the larger operand lost to rounding
+  if (std::fabs(sum) >= std::fabs(value)) {
+    compensation += (sum - next) + value;
+  } else {
+    compensation += (value - next) + sum;
+  }
+  sum = next;
+}
+
+void CompensatedSum::merge(const CompensatedSum &other) {
+  add(other.sum);
+  compensation += other.compensation;
+}
+
+double CompensatedSum::value() const {
+  // Past infinity the compensation is NaN, and meaningless anyway
+  return std::isfinite(sum) ? sum + compensation : sum;
+}
+
+namespace {
+
+// The t-digest's k1 scale: centroids may span one unit of k, which is
+// narrow in quantile near 0 and 1 and wide around the median
+double scale(double q, double compression) {
+  return compression / (2.0 * std::numbers::pi) * std::asin(2.0 * q - 1.0);
+}
+
+double inverseScale(double k, double compression) {
+  if (k >= compression / 4.0) {
+    return 1.0;
+  }
+  return (std::sin(k * 2.0 * std::numbers::pi / compression) + 1.0) / 2.0;
+}
+
+} // namespace
+
+TDigest::TDigest(double compression) : compression(compression) {}
+
+std::size_t TDigest::bufferCapacity() const {
+  return static_cast<std::size_t>(5.0 * compression);
+}
+
+void TDigest::add(double value, double weight) {
+  if (std::isnan(value)) {
+    return;
+  }
+  if (buffer.capacity() == 0) {
+    buffer.reserve(bufferCapacity());
+  }
+  buffer.push_back({value, weight});
+  bufferedWeight += weight;
+  min = std::min(min, value);
+  max = std::max(max, value);
+  if (buffer.size() >= bufferCapacity()) {
+    compress();
+  }
+}
+
+void TDigest::merge(const TDigest &other) {
+  other.compress();
+  for (const Centroid &centroid : other.centroids) {
+    add(centroid.mean, centroid.weight);
+  }
+  min = std::min(min, other.min);
+  max = std::max(max, other.max);
+}
+
+void TDigest::clear() {
+  centroids.clear();
+  buffer.clear();
+  totalWeight = 0.0;
+  bufferedWeight = 0.0;
+  min = std::numeric_limits<double>::infinity();
+  max = -std::numeric_limits<double>::infinity();
+}
+
+// Sorts the buffer into the centroids and merges neighbours while the
+// merged centroid still spans at most one unit of the scale
+void TDigest::compress() const {
+  if (buffer.empty()) {
+    return;
+  }
+  // The centroids are sorted already; only the buffer needs sorting
+  const auto byMean = [](const Centroid &a, const Centroid &b) {
+    return a.mean < b.mean;
+  };
+  std::sort(buffer.begin(), buffer.end(), byMean);
+  scratch.resize(centroids.size() + buffer.size());
+  std::merge(centroids.begin(), centroids.end(), buffer.begin(), buffer.end(),
+             scratch.begin(), byMean);
+  const double total = totalWeight + bufferedWeight;
+
+  centroids.clear();
+  double before = 0.0; // Weight of the centroids already emitted
+  Centroid current = scratch.front();
+  double limit =
+      total * inverseScale(scale(0.0, compression) + 1.0, compression);
+  for (std::size_t i = 1; i < scratch.size(); ++i) {
+    const Centroid &next = scratch[i];
+    if (before + current.weight + next.weight <= limit) {
+      current.weight += next.weight;
+      current.mean +=
+          (next.mean - current.mean) * next.weight / current.weight;
+      continue;
+    }
+    before += current.weight;
+    centroids.push_back(current);
+    limit = total * inverseScale(scale(before / total, compression) + 1.0,
+                                 compression);
+    current = next;
+  }
+  centroids.push_back(current);
+
+  buffer.clear();
+  totalWeight = total;
+  bufferedWeight = 0.0;
+}
+
+double TDigest::quantile(double q) const {
+  compress();
+  if (centroids.empty()) {
+    return std::numeric_limits<double>::quiet_NaN();
+  }
+  // Each centroid sits at the rank of its middle value; between those (and
+  // the extremes at ranks 0 and n - 1) values are interpolated. With
+  // single-value centroids that is exactly PERCENTILE's interpolation.
+  const double rank = std::clamp(q, 0.0, 1.0) * (totalWeight - 1.0);
+  double previousRank = 0.0;
+  double previousValue = min;
+  double before = 0.0;
+  for (const Centroid &centroid : centroids) {
+    const double centre = before + (centroid.weight - 1.0) / 2.0;
+    if (rank <= centre) {
+      if (centre <= previousRank) {
+        return centroid.mean;
+      }
+      const double t = (rank - previousRank) / (centre - previousRank);
+      return previousValue + t * (centroid.mean - previousValue);
+    }
+    previousRank = centre;
+    previousValue = centroid.mean;
+    before += centroid.weight;
+  }
+  const double lastRank = totalWeight - 1.0;
+  if (lastRank <= previousRank) {
+    return previousValue;
+  }
+  const double t = (rank - previousRank) / (lastRank - previousRank);
+  return previousValue + t * (max - previousValue);
+}
+
+void Statistics::add(double value) {
+  if (std::isnan(value)) {
+    return;
+  }
+  if (n++ == 0) {
+    lowest = highest = value;
+  } else {
+    lowest = std::min(lowest, value);
+    highest = std::max(highest, value);
+  }
+  total.add(value);
+  const double delta = value - runningMean;
+  runningMean += delta / static_cast<double>(n);
+  squares += delta * (value - runningMean);
+  digest.add(value);
+}
+
+void Statistics::merge(const Statistics &other) {
+  if (other.n == 0) {
+    return;
+  }
+  if (n == 0) {
+    *this = other;
+    return;
+  }
+  // Chan et al.'s pairwise update of Welford's mean and squares
+  const auto count = static_cast<double>(n);
+  const auto otherCount = static_cast<double>(other.n);
+  const double combined = count + otherCount;
+  const double delta = other.runningMean - runningMean;
+  runningMean += delta * otherCount / combined;
+  squares += other.squares + delta * delta * count * otherCount / combined;
+  n += other.n;
+  total.merge(other.total);
+  lowest = std::min(lowest, other.lowest);
+  highest = std::max(highest, other.highest);
+  digest.merge(other.digest);
+}
+
+void Statistics::clear() {
+  n = 0;
+  total = {};
+  runningMean = 0.0;
+  squares = 0.0;
+  lowest = highest = std::numeric_limits<double>::quiet_NaN();
+  digest.clear();
+}
+
+double Statistics::mean() const {
+  return n == 0 ? std::numeric_limits<double>::quiet_NaN()
+                : sum() / static_cast<double>(n);
+}
+
+double Statistics::variance() const {
+  return n < 2 ? std::numeric_limits<double>::quiet_NaN()
+               : squares / static_cast<double>(n - 1);
+}
+
+double Statistics::standardDeviation() const { return std::sqrt(variance()); }
+
+namespace {
+
+// Percentile `percentage` (0 to 100) of `values`, interpolated between the
+// two nearest ranks as spreadsheets' PERCENTILE does. Exact however many
+// values there are, by selection rather than through the t-digest.
+double percentileOf(std::span<const double> values, double percentage) {
+  // Reused across calls so evaluating does not allocate
+  thread_local std::vector<double> selected;
+  selected.assign(values.begin(), values.end());
+  const std::size_t last = selected.size() - 1;
+  const double rank = percentage / 100.0 * static_cast<double>(last);
+  const auto index = std::min(static_cast<std::size_t>(rank), last);
+  const double fraction = rank - static_cast<double>(index);
+  const auto below = selected.begin() + static_cast<std::ptrdiff_t>(index);
+  std::nth_element(selected.begin(), below, selected.end());
+  if (fraction == 0.0 || index == last) {
+    return *below;
+  }
+  // nth_element() leaves only larger or equal values after `below`
+  const double above = *std::min_element(below + 1, selected.end());
+  return *below == above ? above : *below + fraction * (above - *below);
+}
+
+} // namespace
+
+std::optional<double> aggregate(Function function,
+                                std::span<const double> arguments) {
+  double percentage = 0.0;
+  if (function == Function::Percentile && !arguments.empty()) {
+    percentage = arguments.front();
+    arguments = arguments.subspan(1);
+    if (!(percentage >= 0.0 && percentage <= 100.0)) {
+      return std::nullopt;
+    }
+  }
+  if (arguments.empty()) {
+    return std::nullopt;
+  }
+  // NaN propagates, as it does through arithmetic, instead of being skipped
+  for (const double value : arguments) {
+    if (std::isnan(value)) {
+      return value;
+    }
+  }
+
+  if (function == Function::Median || function == Function::Percentile) {
+    return percentileOf(arguments,
+                        function == Function::Median ? 50.0 : percentage);
+  }
+
+  // Reused across calls so evaluating does not allocate
+  thread_local Statistics statistics;
+  statistics.clear();
+  for (const double value : arguments) {
+    statistics.add(value);
+  }
+  switch (function) {
+  case Function::Sum:
+    return statistics.sum();
+  case Function::Mean:
+    return statistics.mean();
+  case Function::Min:
+    return statistics.minimum();
+  case Function::Max:
+    return statistics.maximum();
+  case Function::Variance:
+  case Function::StdDev:
+    if (statistics.count() < 2) {
+      return std::nullopt;
+    }
+    return function == Function::Variance ? statistics.variance()
+                                          : statistics.standardDeviation();
+  case Function::Median:
+  case Function::Percentile:
+    break; // Selected exactly above
+  }
+  return std::nullopt;
+}
+
+} // namespace calc
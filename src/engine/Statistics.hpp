@@ -0,0 +1,109 @@
+#pragma once
+#include "engine/Expression.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace calc {
+
+// Neumaier's variant of Kahan summation: the rounding error of every
+// addition is carried separately and added back at the end, so a sum of
+// millions of values is as accurate as if it were rounded only once
+class CompensatedSum {
+public:
+  void add(double value);
+  void merge(const CompensatedSum &other);
+  double value() const;
+
+private:
+  double sum = 0.0;
+  double compensation = 0.0;
+};
+
+// Quantile sketch (Dunning's merging t-digest). Values are clustered into
+// at most about `compression` centroids, small ones near both tails and
+// larger ones in the middle, so extreme percentiles stay accurate however
+// many values are added. Up to roughly compression / 2 values every
+// centroid is a single value and quantile() is exact.
+class TDigest {
+public:
+  static constexpr double kCompression = 200.0;
+
+  explicit TDigest(double compression = kCompression);
+
+  void add(double value, double weight = 1.0);
+  void merge(const TDigest &other);
+  void clear();
+
+  double count() const { return totalWeight + bufferedWeight; }
+
+  // Value below which a fraction `q` (0 to 1) of the values lie,
+  // interpolated linearly between neighbouring ranks as spreadsheets'
+  // PERCENTILE does. NaN when empty.
+  double quantile(double q) const;
+
+private:
+  struct Centroid {
+    double mean;
+    double weight;
+  };
+
+  double compression;
+  // Sorted and merged; mutable so that readers can fold the buffer in
+  mutable std::vector<Centroid> centroids;
+  mutable std::vector<Centroid> buffer; // Added since the last compress()
+  mutable std::vector<Centroid> scratch;
+  mutable double totalWeight = 0.0;
+  mutable double bufferedWeight = 0.0;
+  double min = std::numeric_limits<double>::infinity();
+  double max = -std::numeric_limits<double>::infinity();
+
+  std::size_t bufferCapacity() const;
+  void compress() const;
+};
+
+// Everything --stats reports, collected in one pass over the values in
+// bounded memory. Statistics built on separate threads merge() into the
+// same result as one that saw all of the values, up to rounding and the
+// t-digest's clustering.
+class Statistics {
+public:
+  void add(double value);
+  void merge(const Statistics &other);
+  // Forgets every value but keeps the memory for reuse
+  void clear();
+
+  std::uint64_t count() const { return n; }
+  double sum() const { return total.value(); }
+  double mean() const;
+  // Sample variance and standard deviation; NaN for fewer than two values
+  double variance() const;
+  double standardDeviation() const;
+  double minimum() const { return lowest; }
+  double maximum() const { return highest; }
+  // Percentile `p` from 0 to 100, from the t-digest: exact up to about
+  // 100 values and an estimate beyond; NaN when empty
+  double percentile(double p) const { return digest.quantile(p / 100.0); }
+
+private:
+  std::uint64_t n = 0;
+  CompensatedSum total;
+  double runningMean = 0.0; // Welford's running mean
+  double squares = 0.0;     // Sum of squared distances from it
+  double lowest = std::numeric_limits<double>::quiet_NaN();
+  double highest = std::numeric_limits<double>::quiet_NaN();
+  TDigest digest;
+};
+
+// Value of an aggregate Function over `arguments` (for Percentile, the
+// percentage followed by the values). std::nullopt when it has none: no
+// values, the variance of a single value, a percentage outside 0 to 100.
+// Median and Percentile are exact for any number of arguments; only
+// Statistics (and so --stats) estimates percentiles with the t-digest.
+std::optional<double> aggregate(Function function,
+                                std::span<const double> arguments);
+
+} // namespace calc
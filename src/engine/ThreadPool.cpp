@@ -0,0 +1,111 @@
+#include "engine/ThreadPool.hpp"
+#include <algorithm>
+
+namespace calc {
+
+namespace {
+
+// Identifies the pool and deque owned by the current thread, if any
+thread_local const ThreadPool *currentPool = nullptr;
+thread_local unsigned currentWorker = 0;
+
+} // namespace
+
+ThreadPool::ThreadPool(unsigned threadCount) {
+  if (threadCount == 0) {
+    threadCount = std::max(1U, std::thread::hardware_concurrency());
+  }
+  workers.reserve(threadCount);
+  for (unsigned i = 0; i < threadCount; ++i) {
+    workers.push_back(std::make_unique<Worker>());
+  }
+  threads.reserve(threadCount);
+  for (unsigned i = 0; i < threadCount; ++i) {
+    threads.emplace_back([this, i] { workerLoop(i); });
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  wait();
+  {
+    const std::lock_guard lock(sleepMutex);
+    stopping = true;
+  }
+  wakeUp.notify_all();
+  for (auto &thread : threads) {
+    thread.join();
+  }
+}
+
+void ThreadPool::submit(Task task) {
+  const unsigned index = currentPool == this
+                             ? currentWorker
+                             : nextWorker.fetch_add(1) % size();
+  pending.fetch_add(1);
+  {
+    // queued only changes along with a deque, under its lock, so a worker
+    // can never take a task before it is counted and wrap queued past zero
+    const std::lock_guard lock(workers[index]->mutex);
+    queued.fetch_add(1);
+    workers[index]->tasks.push_back(std::move(task));
+  }
+  {
+    // Taking the lock orders this notification after a sleeper's check
+    const std::lock_guard lock(sleepMutex);
+  }
+  wakeUp.notify_one();
+}
+
+void ThreadPool::wait() {
+  std::unique_lock lock(sleepMutex);
+  finished.wait(lock, [this] { return pending.load() == 0; });
+}
+
+bool ThreadPool::takeTask(unsigned index, Task &task) {
+  {
+    // Own deque: newest first, its data is most likely still in cache
+    Worker &own = *workers[index];
+    const std::lock_guard lock(own.mutex);
+    if (!own.tasks.empty()) {
+      task = std::move(own.tasks.back());
+      own.tasks.pop_back();
+      queued.fetch_sub(1);
+      return true;
+    }
+  }
+  for (unsigned offset = 1; offset < size(); ++offset) {
+    // Steal the oldest task from a sibling
+    Worker &victim = *workers[(index + offset) % size()];
+    const std::lock_guard lock(victim.mutex);
+    if (!victim.tasks.empty()) {
+      task = std::move(victim.tasks.front());
+      victim.tasks.pop_front();
+      queued.fetch_sub(1);
+      return true;
+    }
+  }
+  return false;
+}
+
+void ThreadPool::workerLoop(unsigned index) {
+  currentPool = this;
+  currentWorker = index;
+  for (;;) {
+    Task task;
+    if (takeTask(index, task)) {
+      task();
+      if (pending.fetch_sub(1) == 1) {
+        const std::lock_guard lock(sleepMutex);
+        finished.notify_all();
+      }
+      continue;
+    }
+    std::unique_lock lock(sleepMutex);
+    wakeUp.wait(lock, [this] { return stopping || queued.load() > 0; });
+    if (stopping && queued.load() == 0) {
+      return;
+    }
+  }
+}
+
+} // namespace calc
@@ -0,0 +1,58 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace calc {
+
+// Fixed-size pool where every worker owns a task deque. Workers pop their
+// own newest task first and steal the oldest task of a sibling when they run
+// dry, so uneven batches still keep every core busy.
+class ThreadPool {
+public:
+  using Task = std::function<void()>;
+
+  // Zero picks one worker per hardware thread
+  explicit ThreadPool(unsigned threadCount = 0);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  // Queues a task. Tasks submitted from a worker go to that worker's deque,
+  // others are spread round-robin.
+  void submit(Task task);
+
+  // Blocks until every submitted task has finished
+  void wait();
+
+  unsigned size() const { return static_cast<unsigned>(threads.size()); }
+
+private:
+  struct Worker {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+  };
+
+  std::vector<std::unique_ptr<Worker>> workers;
+  std::vector<std::thread> threads;
+
+  std::mutex sleepMutex;
+  std::condition_variable wakeUp;   // Signalled when tasks are queued
+  std::condition_variable finished; // Signalled when pending drops to zero
+  std::atomic<std::size_t> queued{0};  // Tasks sitting in a deque
+  std::atomic<std::size_t> pending{0}; // Tasks queued or running
+  std::atomic<unsigned> nextWorker{0};
+  bool stopping = false;
+
+  void workerLoop(unsigned index);
+  bool takeTask(unsigned index, Task &task);
+};
+
+} // namespace calc
@@ -0,0 +1,229 @@
+#include "engine/Units.hpp"
+#include "engine/Columnar.hpp"
+#include "engine/MappedFile.hpp"
+#include "engine/ParseDouble.hpp"
+#include <bit>
+#include <cmath>
+#include <system_error>
+
+namespace calc {
+
+void Conversion::apply(std::span<const double> values, double *out) const {
+  scaleColumn(values.data(), values.size(), scale, shift, out);
+}
+
+namespace {
+
+// FNV-1a; unit names are short, so anything heavier costs more than it
+// saves in probes
+std::uint32_t hashName(std::string_view name) {
+  std::uint32_t hash = 2166136261U;
+  for (const char c : name) {
+    hash = (hash ^ static_cast<unsigned char>(c)) * 16777619U;
+  }
+  return hash;
+}
+
+// A factor or offset: a number with an optional sign, and nothing else
+std::optional<double> parseQuantity(std::string_view text) {
+  const bool negative = !text.empty() && text.front() == '-';
+  if (!text.empty() && (text.front() == '-' || text.front() == '+')) {
+    text.remove_prefix(1);
+  }
+  const ParsedDouble number = parseDouble(text);
+  if (number.length == 0 || number.length != text.size() ||
+      !std::isfinite(number.value)) {
+    return std::nullopt;
+  }
+  return negative ? -number.value : number.value;
+}
+
+} // namespace
+
+std::shared_ptr<const UnitTable> UnitTable::parse(std::string_view source,
+                                                  std::string *error) {
+  auto table = std::make_shared<UnitTable>();
+  std::vector<std::size_t> lines; // Where each unit was defined
+  // "line N: what", or "line N: 'name' what" for a message about a name
+  const auto fail = [error](std::size_t line, std::string_view what,
+                            std::string_view name = {}) {
+    if (error) {
+      error->assign("line ").append(std::to_string(line)).append(": ");
+      if (!name.empty()) {
+        error->append(1, '\'').append(name).append("' ");
+      }
+      error->append(what);
+    }
+    return nullptr;
+  };
+
+  std::size_t lineNumber = 0;
+  while (!source.empty()) {
+    ++lineNumber;
+    const std::size_t newline = source.find('\n');
+    std::string_view line = source.substr(0, newline);
+    source.remove_prefix(newline == std::string_view::npos ? source.size()
+                                                           : newline + 1);
+    line = line.substr(0, line.find('#'));
+
+    std::string_view fields[5];
+    std::size_t count = 0;
+    for (std::size_t pos = 0; count < 5;) {
+      pos = line.find_first_not_of(" \t\r", pos);
+      if (pos == std::string_view::npos) {
+        break;
+      }
+      const std::size_t end = std::min(line.find_first_of(" \t\r", pos),
+                                       line.size());
+      fields[count++] = line.substr(pos, end - pos);
+      pos = end;
+    }
+    if (count == 0) {
+      continue;
+    }
+    if (count < 3 || count > 4) {
+      return fail(lineNumber,
+                  "expected a name, a dimension, a factor and an optional "
+                  "offset");
+    }
+
+    const std::string_view name = fields[0];
+    if (unitNameLength(name) != name.size() || name == "to") {
+      return fail(lineNumber, "is not a unit name", name);
+    }
+    const std::optional<double> factor = parseQuantity(fields[2]);
+    if (!factor || *factor == 0.0) {
+      return fail(lineNumber, "the factor must be a nonzero number");
+    }
+    const std::optional<double> offset =
+        count == 4 ? parseQuantity(fields[3]) : 0.0;
+    if (!offset) {
+      return fail(lineNumber, "the offset must be a number");
+    }
+
+    std::uint32_t dimension = 0;
+    while (dimension < table->dimensions.size() &&
+           table->dimensions[dimension] != fields[1]) {
+      ++dimension;
+    }
+    if (dimension == table->dimensions.size()) {
+      table->dimensions.emplace_back(fields[1]);
+    }
+
+    Texts texts;
+    texts.name = static_cast<std::uint32_t>(table->text.size());
+    table->text += name;
+    texts.factor = static_cast<std::uint32_t>(table->text.size());
+    table->text += fields[2];
+    texts.offset = static_cast<std::uint32_t>(table->text.size());
+    table->text += fields[3];
+    texts.end = static_cast<std::uint32_t>(table->text.size());
+    table->texts.push_back(texts);
+    table->units.push_back({*factor, *offset, dimension});
+    lines.push_back(lineNumber);
+  }
+
+  // At most half full, so probe sequences stay short and always end
+  table->index.resize(std::bit_ceil(std::max<std::size_t>(
+      2 * table->units.size(), 8)));
+  for (std::uint32_t unit = 0; unit < table->units.size(); ++unit) {
+    const std::string_view name = table->name(unit);
+    if (table->find(name) != kNotFound) {
+      return fail(lines[unit], "is defined twice", name);
+    }
+    table->insert(hashName(name), unit);
+  }
+  return table;
+}
+
+void UnitTable::insert(std::uint32_t hash, std::uint32_t unit) {
+  const std::size_t mask = index.size() - 1;
+  std::size_t slot = hash & mask;
+  while (index[slot].unit != 0) {
+    slot = (slot + 1) & mask;
+  }
+  index[slot] = {hash, unit + 1};
+}
+
+std::uint32_t UnitTable::find(std::string_view name) const {
+  if (index.empty()) {
+    return kNotFound;
+  }
+  const std::uint32_t hash = hashName(name);
+  const std::size_t mask = index.size() - 1;
+  for (std::size_t slot = hash & mask;; slot = (slot + 1) & mask) {
+    const Slot &entry = index[slot];
+    if (entry.unit == 0) {
+      return kNotFound;
+    }
+    if (entry.hash == hash && this->name(entry.unit - 1) == name) {
+      return entry.unit - 1;
+    }
+  }
+}
+
+std::string_view UnitTable::name(std::uint32_t index) const {
+  const Texts &at = texts[index];
+  return std::string_view(text).substr(at.name, at.factor - at.name);
+}
+
+std::string_view UnitTable::factorText(std::uint32_t index) const {
+  const Texts &at = texts[index];
+  return std::string_view(text).substr(at.factor, at.offset - at.factor);
+}
+
+std::string_view UnitTable::offsetText(std::uint32_t index) const {
+  const Texts &at = texts[index];
+  return std::string_view(text).substr(at.offset, at.end - at.offset);
+}
+
+std::optional<Conversion> UnitTable::conversion(std::string_view from,
+                                                std::string_view to) const {
+  const std::uint32_t source = find(from);
+  const std::uint32_t target = find(to);
+  if (source == kNotFound || target == kNotFound ||
+      units[source].dimension != units[target].dimension) {
+    return std::nullopt;
+  }
+  const Unit &a = units[source];
+  const Unit &b = units[target];
+  return Conversion{a.factor / b.factor, (a.offset - b.offset) / b.factor};
+}
+
+UnitFile::UnitFile(std::string path) : filePath(std::move(path)) {
+  reload();
+}
+
+bool UnitFile::reload() {
+  std::error_code error;
+  const auto time = std::filesystem::last_write_time(filePath, error);
+  const std::uintmax_t bytes =
+      error ? 0 : std::filesystem::file_size(filePath, error);
+  if (error) {
+    errorText = filePath + ": " + error.message();
+    return false;
+  }
+  if (current && time == modified && bytes == size) {
+    return false;
+  }
+
+  const MappedFile file(filePath);
+  if (!file.isOpen()) {
+    errorText = file.error();
+    return false;
+  }
+  // A broken file is not parsed again until it changes again
+  modified = time;
+  size = bytes;
+  std::string parseError;
+  auto table = UnitTable::parse(file.view(), &parseError);
+  if (!table) {
+    errorText = filePath + ": " + parseError;
+    return false;
+  }
+  current = std::move(table);
+  errorText.clear();
+  return true;
+}
+
+} // namespace calc
@@ -0,0 +1,148 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace calc {
+
+// Length of the unit name at the start of `text`: letters, digits, '_',
+// '$' and any non-ASCII character except the keypad's × and ÷, not
+// starting with a digit. 0 when `text` does not start with one.
+constexpr std::size_t unitNameLength(std::string_view text) {
+  const auto isOperator = [text](std::size_t at) {
+    // × is C3 97 and ÷ is C3 B7 in UTF-8
+    return static_cast<unsigned char>(text[at]) == 0xC3 &&
+           at + 1 < text.size() &&
+           (static_cast<unsigned char>(text[at + 1]) == 0x97 ||
+            static_cast<unsigned char>(text[at + 1]) == 0xB7);
+  };
+  std::size_t length = 0;
+  while (length < text.size()) {
+    const char c = text[length];
+    const bool letter = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+                        c == '_' || c == '$';
+    const bool digit = c >= '0' && c <= '9';
+    const bool other = static_cast<unsigned char>(c) >= 0x80;
+    if (!(letter || (digit && length > 0) || other) || isOperator(length)) {
+      break;
+    }
+    ++length;
+  }
+  return length;
+}
+
+// Affine map between two units of one dimension: to = from × scale + shift
+struct Conversion {
+  double scale = 1.0;
+  double shift = 0.0;
+
+  double operator()(double value) const { return value * scale + shift; }
+
+  // Converts values[i] into out[i] with the columnar SIMD kernels; every
+  // value matches operator() bit for bit. `out` may equal values.data().
+  void apply(std::span<const double> values, double *out) const;
+};
+
+// Immutable table of units, parsed once from the text of a units file:
+//
+//   # name  dimension    factor  [offset]
+//   m       length       1
+//   km      length       1000
+//   °C      temperature  1       273.15
+//
+// A value in a unit is value × factor + offset in its dimension's base
+// unit. Units sit in one flat array and are found through an
+// open-addressing hash index, so a lookup is a hash, usually one probe and
+// no allocation.
+class UnitTable {
+public:
+  static constexpr std::uint32_t kNotFound = 0xFFFFFFFF;
+
+  struct Unit {
+    double factor;
+    double offset;
+    std::uint32_t dimension; // Index into the table's dimension names
+  };
+
+  // nullptr for text that is not a units file, with the line and reason
+  // in `error`
+  static std::shared_ptr<const UnitTable> parse(std::string_view text,
+                                                std::string *error = nullptr);
+
+  std::size_t size() const { return units.size(); }
+
+  // Index of the unit called `name`, or kNotFound
+  std::uint32_t find(std::string_view name) const;
+
+  constexpr const Unit &operator[](std::uint32_t index) const {
+    return units[index];
+  }
+  std::string_view name(std::uint32_t index) const;
+  // Factor and offset as written in the file, so exact backends read the
+  // same decimal the file gives rather than its nearest double
+  std::string_view factorText(std::uint32_t index) const;
+  std::string_view offsetText(std::uint32_t index) const;
+  std::string_view dimensionName(std::uint32_t dimension) const {
+    return dimensions[dimension];
+  }
+
+  // Conversion from one unit to another; std::nullopt when either is
+  // unknown or they measure different dimensions
+  std::optional<Conversion> conversion(std::string_view from,
+                                       std::string_view to) const;
+
+private:
+  // Offsets into `text`: name, factor and offset texts, end to end
+  struct Texts {
+    std::uint32_t name;
+    std::uint32_t factor;
+    std::uint32_t offset;
+    std::uint32_t end;
+  };
+  struct Slot {
+    std::uint32_t hash;
+    std::uint32_t unit; // Index + 1; 0 marks an empty slot
+  };
+
+  std::vector<Unit> units;
+  std::vector<Slot> index; // Power-of-two size, at most half full
+  std::vector<Texts> texts;
+  std::string text;
+  std::vector<std::string> dimensions;
+
+  void insert(std::uint32_t hash, std::uint32_t unit);
+};
+
+// A units file and the table parsed from it. reload() picks up edits
+// without restarting: callers that hold on to table() keep a consistent
+// snapshot while the next one is swapped in.
+class UnitFile {
+public:
+  explicit UnitFile(std::string path);
+
+  bool isOpen() const { return current != nullptr; }
+  const std::string &error() const { return errorText; }
+  const std::string &path() const { return filePath; }
+
+  const std::shared_ptr<const UnitTable> &table() const { return current; }
+
+  // Re-reads the file if its size or modification time changed. Returns
+  // true when a new table replaced the old one; a file that no longer
+  // parses keeps the old table and sets error().
+  bool reload();
+
+private:
+  std::string filePath;
+  std::shared_ptr<const UnitTable> current;
+  std::string errorText;
+  std::filesystem::file_time_type modified;
+  std::uintmax_t size = 0;
+};
+
+} // namespace calc
@@ -1,7 +1,34 @@
 #include "Application.hpp"
+#include "StartupTrace.hpp"
+#include "engine/Batch.hpp"
+#include "engine/HistoryLog.hpp"
+#include "engine/Recording.hpp"
+#include "engine/Server.hpp"
 #include <QtWidgets/QApplication>
+#include <string_view>
 
 int main(int argc, char *argv[]) {
+  // Headless modes run before any Qt object is created
+  if (argc > 1 && std::string_view(argv[1]) == "--batch") {
+    return calc::runBatch(argc - 2, argv + 2);
+  }
+  if (argc > 1 && std::string_view(argv[1]) == "--replay") {
+    return calc::runReplay(argc - 2, argv + 2);
+  }
+  if (argc > 1 && std::string_view(argv[1]) == "--history") {
+    return calc::runHistory(argc - 2, argv + 2);
+  }
+  if (argc > 1 && std::string_view(argv[1]) == "--serve") {
+    return calc::runServe(argc - 2, argv + 2);
+  }
+
+  bool trace = false;
+  for (int i = 1; i < argc; ++i) {
+    trace = trace || std::string_view(argv[i]) == "--startup-trace";
+  }
+  StartupTrace::start(trace);
+
   QApplication app(argc, argv);
+  StartupTrace::mark("QApplication");
   return (Calculator().show(), QApplication::exec());
 }
\ No newline at end of file
@@ -0,0 +1,124 @@
+// Headless --batch mode: line evaluation and its command line.
+#include "Check.hpp"
+#include "engine/Batch.hpp"
+#include "engine/MappedFile.hpp"
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+using calc::test::temporaryPath;
+
+// calc::runBatch() over `args`, which exclude "--batch" itself
+int runBatch(std::vector<std::string> args) {
+  std::vector<char *> argv;
+  for (std::string &arg : args) {
+    argv.push_back(arg.data());
+  }
+  return calc::runBatch(static_cast<int>(argv.size()), argv.data());
+}
+
+void testBatch() {
+  // One result per line, blank lines kept so output lines up with input
+  std::string out;
+  calc::BatchStats stats;
+  const std::string_view input = "1 + 2\n\n1 ÷ 0\n2 × (3 + 4)\n10 -";
+  const std::size_t consumed = calc::evaluateLines(input, false, out, stats);
+  CHECK(out == "3\n\nError\n14\n");
+  CHECK(consumed == input.size() - 4); // "10 -" has no newline yet
+  CHECK(stats.lines == 4 && stats.errors == 1);
+  calc::evaluateLines(input.substr(consumed), true, out, stats);
+  CHECK(out == "3\n\nError\n14\nError\n");
+  CHECK(stats.lines == 5 && stats.errors == 2);
+
+  // Counts must be whole numbers; anything else is an error, not "0"
+  CHECK(runBatch({"-j", "abc"}) == 2);
+  CHECK(runBatch({"--jobs", "4x"}) == 2);
+  CHECK(runBatch({"-j", ""}) == 2);
+  CHECK(runBatch({"--cache", "-1"}) == 2);
+  CHECK(runBatch({"--no-such-option"}) == 2);
+}
+
+#ifndef _WIN32
+
+// What runBatch() prints for `args`, and its exit status
+std::pair<std::string, int> batchOutput(std::vector<std::string> args) {
+  const std::string path = temporaryPath("batch.out");
+  std::fflush(stdout);
+  const int saved = ::dup(STDOUT_FILENO);
+  const int into = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+  ::dup2(into, STDOUT_FILENO);
+  ::close(into);
+  const int status = runBatch(std::move(args));
+  std::fflush(stdout);
+  ::dup2(saved, STDOUT_FILENO);
+  ::close(saved);
+
+  std::string output;
+  std::FILE *file = std::fopen(path.c_str(), "rb");
+  for (int c; file && (c = std::fgetc(file)) != EOF;) {
+    output += static_cast<char>(c);
+  }
+  if (file) {
+    std::fclose(file);
+  }
+  std::filesystem::remove(path);
+  return {output, status};
+}
+
+// Pipes and FIFOs have no size to map: they are streamed, never read as
+// empty input
+void testBatchFiles() {
+  const std::string regular = temporaryPath("batch.txt");
+  {
+    std::FILE *file = std::fopen(regular.c_str(), "wb");
+    std::fputs("1 + 1\n2 × 3\n", file);
+    std::fclose(file);
+  }
+  CHECK(batchOutput({"-j", "1", regular}) ==
+        std::pair<std::string, int>("2\n6\n", 0));
+
+  const std::string fifo = temporaryPath("batch.fifo");
+  CHECK(::mkfifo(fifo.c_str(), 0600) == 0);
+  for (const char *jobs : {"1", "4"}) {
+    std::thread writer([&fifo] {
+      std::FILE *file = std::fopen(fifo.c_str(), "wb");
+      std::fputs("1 + 1\n2 × 3\n", file);
+      std::fclose(file);
+    });
+    CHECK(batchOutput({"-j", jobs, fifo, regular}) ==
+          std::pair<std::string, int>("2\n6\n2\n6\n", 0));
+    writer.join();
+  }
+  std::filesystem::remove(fifo);
+  std::filesystem::remove(regular);
+
+  // Nor can a directory be mapped, or any other file that is not regular
+  const calc::MappedFile directory(
+      std::filesystem::temp_directory_path().string());
+  CHECK(!directory.isOpen() && !directory.error().empty());
+  CHECK(batchOutput({std::filesystem::temp_directory_path().string()})
+            .second == 1);
+}
+
+#else
+
+void testBatchFiles() {}
+
+#endif
+
+CALC_TEST_GROUP("batch", testBatch);
+CALC_TEST_GROUP("batch-files", testBatchFiles);
+
+} // namespace
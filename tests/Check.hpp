@@ -0,0 +1,31 @@
+#pragma once
+
+// The checks shared by every calc_tests group. Each tests/*Tests.cpp file
+// registers its groups with CALC_TEST_GROUP; calc_tests.cpp runs them.
+#include "engine/Expression.hpp"
+#include <string>
+#include <string_view>
+
+namespace calc::test {
+
+// Records a failed check; use CHECK rather than calling this directly
+void check(bool passed, const char *expression, const char *file, int line);
+
+#define CHECK(...)                                                             \
+  ::calc::test::check((__VA_ARGS__), #__VA_ARGS__, __FILE__, __LINE__)
+
+// Adds a group to the ones main() can run, at static initialisation
+struct Registration {
+  Registration(std::string_view name, void (*run)());
+};
+
+#define CALC_TEST_GROUP(name, function)                                        \
+  const ::calc::test::Registration function##Registration(name, function)
+
+// A file name in the temporary directory, unique to this process
+std::string temporaryPath(std::string_view name);
+
+// `source` compiled; a failed compile is a failed check
+Program compiled(std::string_view source);
+
+} // namespace calc::test
@@ -0,0 +1,54 @@
+// Exact decimal backend: parsing, arithmetic and rounded division.
+#include "Check.hpp"
+#include "engine/Decimal.hpp"
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace {
+
+std::string decimalText(std::string_view text) {
+  return calc::Decimal::parse(text).value_or(calc::Decimal()).toString();
+}
+
+void testDecimal() {
+  CHECK(decimalText("0.1") == "0.1");
+  const auto sum = *calc::Decimal::parse("0.1") + *calc::Decimal::parse("0.2");
+  CHECK(sum.toString() == "0.3");
+  CHECK((*calc::Decimal::parse("1.5") * *calc::Decimal::parse("-4"))
+            .toString() == "-6");
+
+  // Long division over many limbs (Knuth's algorithm D): an exact
+  // quotient comes back exactly
+  const calc::Decimal a = *calc::Decimal::parse("123456789012345678901234567");
+  const calc::Decimal b = *calc::Decimal::parse("98765432109876543210987");
+  const std::optional<calc::Decimal> quotient = calc::divide(a * b, b);
+  CHECK(quotient && quotient->toString() == a.toString());
+  CHECK(!calc::divide(a, calc::Decimal()));
+
+  // Inexact quotients are rounded half to even to the digits asked for
+  const auto quotientText = [](const char *lhs, const char *rhs, int digits) {
+    const auto quotient = calc::divide(*calc::Decimal::parse(lhs),
+                                       *calc::Decimal::parse(rhs), digits);
+    return quotient ? quotient->toString() : std::string();
+  };
+  CHECK(quotientText("1", "3", 34) == "0." + std::string(34, '3'));
+  CHECK(quotientText("2", "3", 34) == "0." + std::string(33, '6') + "7");
+  CHECK(quotientText("1", "8", 2) == "0.12");
+  CHECK(quotientText("3", "8", 2) == "0.38");
+  CHECK(quotientText("9995", "10", 3) == "1000");
+  CHECK(quotientText("123456789", "1", 4) == "123500000");
+
+  // Operands too far apart to align are only dropped when negligible
+  const std::string power = "1" + std::string(4003, '0'); // 10^4003
+  CHECK((*calc::Decimal::parse("1e4002") + *calc::Decimal::parse(power))
+            .toString() == "1.1e+4003");
+  CHECK((*calc::Decimal::parse(power) - *calc::Decimal::parse("1e4002"))
+            .toString() == "9e+4002");
+  CHECK((*calc::Decimal::parse("1e5000") + *calc::Decimal::parse("1"))
+            .toString() == "1e+5000");
+}
+
+CALC_TEST_GROUP("decimal", testDecimal);
+
+} // namespace
@@ -0,0 +1,158 @@
+// Persistent history log: appends, crash recovery and search.
+#include "Check.hpp"
+#include "engine/HistoryLog.hpp"
+#include <atomic>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+using calc::test::temporaryPath;
+
+void testHistory() {
+  const std::string path = temporaryPath("history.log");
+  std::filesystem::remove(path);
+  {
+    calc::HistoryLog log(path);
+    CHECK(log.isOpen());
+    log.append("2 + 3", "5");
+    log.append("1 ÷ 4", "0.25");
+    log.flush();
+  }
+  {
+    // A crash in the middle of an entry leaves a torn tail behind
+    std::FILE *file = std::fopen(path.c_str(), "ab");
+    std::fwrite("\x09\x00\x00\x00\x01", 1, 5, file);
+    std::fclose(file);
+  }
+  {
+    // Read-only logs index the whole entries and ignore the tail
+    const calc::HistoryLog log(path, true);
+    CHECK(log.size() == 2);
+  }
+  {
+    // The writer drops the torn tail before appending
+    calc::HistoryLog log(path);
+    CHECK(log.isOpen());
+    log.append("6 × 7", "42");
+    log.flush();
+  }
+  {
+    const calc::HistoryLog log(path, true);
+    CHECK(log.size() == 3);
+    CHECK(log.entry(0).expression == "2 + 3");
+    CHECK(log.entry(2).result == "42");
+    CHECK(log.search("÷") == std::vector<std::size_t>{1});
+  }
+  std::filesystem::remove(path);
+
+  // Two instances appending to one new log never interleave entries
+  {
+    calc::HistoryLog first(path);
+    calc::HistoryLog second(path);
+    const std::string expression(1000, '1');
+    for (int i = 0; i < 200; ++i) {
+      first.append(expression, "first");
+      second.append(expression, "second");
+    }
+    first.flush();
+    second.flush();
+  }
+  {
+    const calc::HistoryLog log(path, true);
+    CHECK(log.isOpen() && log.size() == 400);
+    CHECK(log.search("first").size() == 200);
+    CHECK(log.search("second").size() == 200);
+  }
+  std::filesystem::remove(path);
+
+  const std::string other = temporaryPath("not-history.txt");
+  {
+    std::FILE *file = std::fopen(other.c_str(), "wb");
+    std::fputs("2 + 3 = 5\n", file);
+    std::fclose(file);
+  }
+  CHECK(!calc::HistoryLog(other).isOpen());
+  std::filesystem::remove(other);
+}
+
+// The trigram index behind search(), as a writing log builds it
+void testHistorySearch() {
+  const std::string path = temporaryPath("history-search.log");
+  std::filesystem::remove(path);
+  {
+    calc::HistoryLog log(path);
+    log.append("2 + 3", "5");
+    log.flush();
+  }
+  {
+    calc::HistoryLog log(path);
+    std::atomic<int> notified{0};
+    log.setListener([&] { ++notified; });
+    for (int i = 0; i < 5000; ++i) {
+      log.append(std::to_string(i) + " × 2", std::to_string(i * 2));
+    }
+    log.flush();
+    CHECK(log.isLoaded() && notified > 0);
+    // The entry already in the file comes first, then this session's
+    CHECK(log.size() == 5001);
+    CHECK(log.entry(0).expression == "2 + 3");
+    CHECK(log.entry(5000).result == "9998");
+
+    // Newest first, up to the limit
+    CHECK(log.search("4999") == std::vector<std::size_t>{5000});
+    CHECK(log.search("4123 ×") == std::vector<std::size_t>{4124});
+    CHECK(log.search("× 2", 3) == std::vector<std::size_t>{5000, 4999, 4998});
+    CHECK(log.search("× 2").size() == 5000);
+    // Shorter than a trigram: scanned rather than looked up
+    CHECK(log.search("9", 2) == std::vector<std::size_t>{5000, 4999});
+    CHECK(log.search("+") == std::vector<std::size_t>{0});
+    // A missing trigram, and "14 × 2" then "28" end to end in memory
+    CHECK(log.search("7 ÷").empty());
+    CHECK(log.search("× 228").empty());
+    // Every lookup agrees with checking each entry
+    for (const std::string_view needle : {"35", "350", "12 ×", "0 × 2"}) {
+      std::vector<std::size_t> scanned;
+      for (std::size_t i = log.size(); i-- > 0;) {
+        const calc::HistoryEntry entry = log.entry(i);
+        if (entry.expression.find(needle) != std::string_view::npos ||
+            entry.result.find(needle) != std::string_view::npos) {
+          scanned.push_back(i);
+        }
+      }
+      CHECK(log.search(needle) == scanned);
+    }
+  }
+  std::filesystem::remove(path);
+}
+
+// --history reads its options like the other modes
+void testHistoryOptions() {
+  const auto run = [](std::vector<std::string> arguments) {
+    std::vector<char *> argv;
+    for (std::string &argument : arguments) {
+      argv.push_back(argument.data());
+    }
+    return calc::runHistory(static_cast<int>(argv.size()), argv.data());
+  };
+  const std::string path = temporaryPath("history-options.log");
+  {
+    calc::HistoryLog log(path);
+    log.append("2 + 3", "5");
+  }
+  CHECK(run({"--last", "abc", path}) == 2);
+  CHECK(run({"--last", "-1", path}) == 2);
+  CHECK(run({"--last", "", path}) == 2);
+  CHECK(run({"--last"}) == 2);
+  CHECK(run({"--last", "1", "--search", "zzz", path}) == 0);
+  std::filesystem::remove(path);
+}
+
+CALC_TEST_GROUP("history", testHistory);
+CALC_TEST_GROUP("history-search", testHistorySearch);
+CALC_TEST_GROUP("history-options", testHistoryOptions);
+
+} // namespace
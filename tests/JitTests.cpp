@@ -0,0 +1,59 @@
+// Native --formula code: bit for bit what the interpreter computes.
+#include "Check.hpp"
+#include "engine/Columnar.hpp"
+#include "engine/Jit.hpp"
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace {
+
+using calc::test::compiled;
+
+// Native code must match the interpreter bit for bit, failed rows included
+void testJit() {
+  constexpr std::size_t kRows = 1001; // Odd, so the last pair is half full
+  std::mt19937 random(3);
+  std::uniform_real_distribution<double> real(-100.0, 100.0);
+  std::vector<double> a(kRows);
+  std::vector<double> b(kRows);
+  std::vector<double> c(kRows);
+  for (std::size_t row = 0; row < kRows; ++row) {
+    a[row] = real(random);
+    b[row] = row % 7 == 0 ? 0.0 : real(random);
+    c[row] = real(random);
+  }
+  const double *const columns[] = {a.data(), b.data(), c.data()};
+
+  for (const char *source : {"a * b + c", "a ÷ b - c", "-(a - b) × c%",
+                             "a ÷ (b - b) + c", "(a + b) × (a - c) ÷ b"}) {
+    const calc::Program program = compiled(source);
+    const auto native = calc::NativeProgram::compile(program);
+#if defined(__x86_64__) && !defined(_WIN32)
+    CHECK(native != nullptr);
+#endif
+    if (!native) {
+      continue;
+    }
+    std::vector<double> expected(kRows);
+    std::vector<std::uint8_t> expectedErrors(kRows);
+    std::vector<double> actual(kRows);
+    std::vector<std::uint8_t> actualErrors(kRows);
+    CHECK(calc::evaluateColumns(program, columns, kRows, expected.data(),
+                                expectedErrors.data()));
+    native->run(columns, kRows, actual.data(), actualErrors.data());
+    CHECK(actualErrors == expectedErrors);
+    bool same = true;
+    for (std::size_t row = 0; row < kRows; ++row) {
+      same = same && (expectedErrors[row] ||
+                      std::memcmp(&expected[row], &actual[row],
+                                  sizeof(double)) == 0);
+    }
+    CHECK(same);
+  }
+}
+
+CALC_TEST_GROUP("jit", testJit);
+
+} // namespace
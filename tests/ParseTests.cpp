@@ -0,0 +1,50 @@
+// Number literals: parseDouble() against a correctly rounded strtod().
+#include "Check.hpp"
+#include "engine/ParseDouble.hpp"
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+
+namespace {
+
+// parseDouble() must round exactly like a correctly rounded strtod()
+void testParse() {
+  const auto same = [](const char *text) {
+    const calc::ParsedDouble parsed = calc::parseDouble(text);
+    return parsed.length == std::strlen(text) &&
+           parsed.value == std::strtod(text, nullptr);
+  };
+  // Halfway cases, which round to even, and neighbours that do not
+  CHECK(same("9007199254740993"));
+  CHECK(same("9007199254740993.0000000000000000000000000001"));
+  CHECK(same("9007199254740995"));
+  CHECK(same("1.00000000000000011102230246251565404236316680908203125"));
+  CHECK(same("1.00000000000000011102230246251565404236316680908203124"));
+  // Subnormals, the extremes and long mantissas that need big integers
+  CHECK(same("2.4703282292062328e-324"));
+  CHECK(same("4.9406564584124654e-324"));
+  CHECK(same("2.2250738585072011e-308"));
+  CHECK(same("1.7976931348623157e308"));
+  CHECK(same("0.000000000000000000000000000000000000000000001234567890123"));
+  CHECK(same("123456789012345678901234567890123456789012345678901234567890"));
+
+  std::mt19937_64 random(5);
+  for (int i = 0; i < 20000; ++i) {
+    char text[64];
+    const std::uint64_t bits = random();
+    double value = 0.0;
+    std::memcpy(&value, &bits, sizeof(value));
+    if (!std::isfinite(value)) {
+      continue;
+    }
+    std::snprintf(text, sizeof(text), "%.17g", std::fabs(value));
+    CHECK(same(text));
+  }
+}
+
+CALC_TEST_GROUP("parse", testParse);
+
+} // namespace
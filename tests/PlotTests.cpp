@@ -0,0 +1,51 @@
+// Plot panel: curve sampling and tile rasterizing.
+#include "Check.hpp"
+#include "engine/Plot.hpp"
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace {
+
+using calc::test::compiled;
+
+void testPlot() {
+  std::vector<calc::CurvePoint> points;
+  const calc::PlotArea area{-1.28, 1.28, 0.01};
+
+  // 1/x breaks at its pole rather than joining the two branches
+  calc::sampleCurve(compiled("1 / x"), area, points);
+  bool broken = false;
+  for (std::size_t i = 1; i < points.size(); ++i) {
+    CHECK(points[i - 1].x <= points[i].x);
+    broken = broken || (std::isnan(points[i].y) && points[i - 1].x < 0.0 &&
+                        i + 1 < points.size() && points[i + 1].x > 0.0);
+  }
+  CHECK(broken);
+
+  // y = x crosses the tile corner to corner
+  std::vector<std::uint32_t> pixels(std::size_t{calc::kTileSize} *
+                                    calc::kTileSize);
+  calc::sampleCurve(compiled("x"), area, points);
+  calc::renderCurve(points, area, 0xFFFFFFFF, pixels.data(), calc::kTileSize);
+  const auto at = [&pixels](int x, int y) {
+    return pixels[static_cast<std::size_t>(y * calc::kTileSize + x)];
+  };
+  CHECK(at(128, 127) >> 24 > 0x80);
+  CHECK(at(10, 245) >> 24 > 0x80);
+  CHECK(at(10, 10) == 0);
+
+  // Points far off the tile are clipped, not converted to rows
+  for (const char *source : {"x - 1e10", "x + 1e10", "1e12 × x"}) {
+    calc::sampleCurve(compiled(source), area, points);
+    calc::renderCurve(points, area, 0xFFFFFFFF, pixels.data(),
+                      calc::kTileSize);
+  }
+  // The steep line through the origin still crosses the tile's centre
+  CHECK(at(128, 128) >> 24 > 0x80 || at(127, 128) >> 24 > 0x80);
+  CHECK(at(10, 10) == 0);
+}
+
+CALC_TEST_GROUP("plot", testPlot);
+
+} // namespace
@@ -0,0 +1,70 @@
+// Keypad session recording and headless replay.
+#include "Check.hpp"
+#include "engine/Action.hpp"
+#include "engine/Recording.hpp"
+#include "engine/Session.hpp"
+#include <cstdio>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+using calc::test::temporaryPath;
+
+void testRecording() {
+  const std::string path = temporaryPath("session.rec");
+  calc::Session session;
+  {
+    calc::Recorder recorder(path, calc::NumericBackend::Double);
+    CHECK(recorder.isOpen());
+    for (const char key : std::string_view("12+3*2=")) {
+      const std::optional<calc::Action> action = calc::actionForCharacter(key);
+      recorder.record(*action);
+      session.dispatch(*action);
+    }
+    recorder.finish(session.display());
+  }
+
+  std::FILE *file = std::fopen(path.c_str(), "rb");
+  std::string bytes;
+  for (int c; file && (c = std::fgetc(file)) != EOF;) {
+    bytes += static_cast<char>(c);
+  }
+  if (file) {
+    std::fclose(file);
+  }
+  std::filesystem::remove(path);
+
+  const std::optional<calc::Recording> recording = calc::parseRecording(bytes);
+  CHECK(recording && recording->actions.size() == 7);
+  CHECK(recording && recording->finalDisplay == "18");
+  if (recording) {
+    calc::Session fresh;
+    const calc::ReplayResult result = calc::replay(*recording, fresh);
+    CHECK(result.matches && result.display == "18");
+  }
+}
+
+// Replays run a whole number of times; a typo is an error, not 0 passes
+void testReplayOptions() {
+  const auto runReplay = [](std::vector<std::string> args) {
+    std::vector<char *> argv;
+    for (std::string &arg : args) {
+      argv.push_back(arg.data());
+    }
+    return calc::runReplay(static_cast<int>(argv.size()), argv.data());
+  };
+  const std::string path = temporaryPath("options.rec");
+  for (const char *count : {"abc", "0", "-1", "", "3x"}) {
+    CHECK(runReplay({"--repeat", count, path}) == 2);
+  }
+  CHECK(runReplay({"--repeat", "3", path}) == 1); // No such file
+}
+
+CALC_TEST_GROUP("recording", testRecording);
+CALC_TEST_GROUP("replay-options", testReplayOptions);
+
+} // namespace
@@ -0,0 +1,198 @@
+// --serve mode: framing, per-connection order and running out of fds.
+#include "Check.hpp"
+#include "engine/Server.hpp"
+#include <chrono>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+using calc::test::temporaryPath;
+
+#ifdef __linux__
+
+int connectTo(const std::string &path) {
+  const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  sockaddr_un address{};
+  address.sun_family = AF_UNIX;
+  std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+  if (::connect(fd, reinterpret_cast<const sockaddr *>(&address),
+                sizeof(address)) != 0) {
+    ::close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+std::string frame(std::string_view payload) {
+  std::string bytes(4, '\0');
+  for (int i = 0; i < 4; ++i) {
+    bytes[i] = static_cast<char>(payload.size() >> (8 * i) & 0xFF);
+  }
+  bytes += payload;
+  return bytes;
+}
+
+// The payload of the next response frame, or std::nullopt at the end
+std::optional<std::string> readFrame(int fd) {
+  const auto readAll = [fd](char *into, std::size_t count) {
+    while (count > 0) {
+      const ssize_t got = ::recv(fd, into, count, 0);
+      if (got <= 0) {
+        return false;
+      }
+      into += got;
+      count -= static_cast<std::size_t>(got);
+    }
+    return true;
+  };
+  unsigned char header[4];
+  if (!readAll(reinterpret_cast<char *>(header), 4)) {
+    return std::nullopt;
+  }
+  const std::size_t length = header[0] | header[1] << 8 | header[2] << 16 |
+                             std::size_t{header[3]} << 24;
+  std::string payload(length, '\0');
+  if (!readAll(payload.data(), length)) {
+    return std::nullopt;
+  }
+  return payload;
+}
+
+void testServer() {
+  const std::string path = temporaryPath("server.sock");
+  calc::Server server(path, calc::NumericBackend::Double);
+  CHECK(server.isOpen());
+  if (!server.isOpen()) {
+    return;
+  }
+  std::thread loop([&server] { server.run(); });
+
+  const int fd = connectTo(path);
+  CHECK(fd >= 0);
+  if (fd >= 0) {
+    // Pipelined frames, the second split across two writes
+    const std::string first = frame("1 + 2\n2 × 3 + 1");
+    const std::string second = frame("1 ÷ 0\n\n10 - 4");
+    const std::string requests = first + second;
+    const std::size_t split = first.size() + 3;
+    CHECK(::send(fd, requests.data(), split, 0) ==
+          static_cast<ssize_t>(split));
+    CHECK(::send(fd, requests.data() + split, requests.size() - split, 0) ==
+          static_cast<ssize_t>(requests.size() - split));
+    ::shutdown(fd, SHUT_WR);
+    CHECK(readFrame(fd) == "3\n7\n");
+    CHECK(readFrame(fd) == "Error\n\n6\n");
+    CHECK(readFrame(fd) == std::nullopt); // Closed once answered
+    ::close(fd);
+  }
+
+  // A slow frame does not let the quick ones behind it overtake it
+  const int pipelined = connectTo(path);
+  CHECK(pipelined >= 0);
+  if (pipelined >= 0) {
+    std::string slow;
+    for (int i = 0; i < 100000; ++i) {
+      slow += "1 + 1\n";
+    }
+    std::string requests = frame(slow);
+    for (int i = 0; i < 50; ++i) {
+      requests += frame(std::to_string(i));
+    }
+    for (std::size_t at = 0; at < requests.size();) {
+      const ssize_t sent =
+          ::send(pipelined, requests.data() + at, requests.size() - at, 0);
+      CHECK(sent > 0);
+      at += sent > 0 ? static_cast<std::size_t>(sent) : requests.size();
+    }
+    ::shutdown(pipelined, SHUT_WR);
+    const std::optional<std::string> first = readFrame(pipelined);
+    CHECK(first && first->size() == 200000);
+    bool ordered = true;
+    for (int i = 0; i < 50; ++i) {
+      ordered = ordered && readFrame(pipelined) == std::to_string(i) + "\n";
+    }
+    CHECK(ordered);
+    ::close(pipelined);
+  }
+
+  // Out of descriptors, the server leaves the listener alone until one is
+  // free instead of spinning on it
+  rlimit limit{};
+  CHECK(::getrlimit(RLIMIT_NOFILE, &limit) == 0);
+  const int lowest = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  ::close(lowest);
+  rlimit tight = limit;
+  // Room for two clients and the server's end of the first
+  tight.rlim_cur = static_cast<rlim_t>(lowest) + 3;
+  CHECK(::setrlimit(RLIMIT_NOFILE, &tight) == 0);
+  const int accepted = connectTo(path);
+  const int waiting = connectTo(path);
+  CHECK(accepted >= 0 && waiting >= 0);
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  const auto cpuTime = [] {
+    rusage usage{};
+    ::getrusage(RUSAGE_SELF, &usage);
+    return std::chrono::seconds(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) +
+           std::chrono::microseconds(usage.ru_utime.tv_usec +
+                                     usage.ru_stime.tv_usec);
+  };
+  const auto before = cpuTime();
+  std::this_thread::sleep_for(std::chrono::milliseconds(300));
+  CHECK(cpuTime() - before < std::chrono::milliseconds(100));
+  ::close(accepted); // Frees the server's descriptor for `waiting`
+  CHECK(::setrlimit(RLIMIT_NOFILE, &limit) == 0);
+  if (waiting >= 0) {
+    const std::string request = frame("6 × 7");
+    CHECK(::send(waiting, request.data(), request.size(), 0) ==
+          static_cast<ssize_t>(request.size()));
+    CHECK(readFrame(waiting) == "42\n");
+    ::close(waiting);
+  }
+
+  server.stop();
+  loop.join();
+  CHECK(server.stats().frames == 54);
+  CHECK(server.stats().expressions.lines == 100056);
+}
+
+// The cache size is a whole count; anything else is an error, not "0"
+void testServeOptions() {
+  const auto runServe = [](std::vector<std::string> args) {
+    std::vector<char *> argv;
+    for (std::string &arg : args) {
+      argv.push_back(arg.data());
+    }
+    return calc::runServe(static_cast<int>(argv.size()), argv.data());
+  };
+  const std::string path = temporaryPath("options.sock");
+  CHECK(runServe({"--cache", "foo", path}) == 2);
+  CHECK(runServe({"--cache", "-1", path}) == 2);
+  CHECK(runServe({"--cache", "", path}) == 2);
+  CHECK(runServe({"--cache", "99999999999999999999999", path}) == 2);
+  CHECK(runServe({"--no-such-option", path}) == 2);
+  CHECK(runServe({}) == 2);
+}
+
+#else
+
+void testServer() {}
+void testServeOptions() {}
+
+#endif
+
+CALC_TEST_GROUP("server", testServer);
+CALC_TEST_GROUP("serve-options", testServeOptions);
+
+} // namespace
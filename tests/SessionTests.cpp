@@ -0,0 +1,65 @@
+// Keypad sessions: dispatching actions and undo/redo.
+#include "Check.hpp"
+#include "engine/Action.hpp"
+#include "engine/Session.hpp"
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+void press(calc::Session &session, std::string_view keys) {
+  for (const char key : keys) {
+    if (const std::optional<calc::Action> action =
+            calc::actionForCharacter(key)) {
+      session.dispatch(*action);
+    }
+  }
+}
+
+void testSession() {
+  calc::Session session;
+  CHECK(session.display() == "0");
+  press(session, "12+3*2=");
+  CHECK(session.display() == "18"); // × binds tighter
+  press(session, "/4=");
+  CHECK(session.display() == "4.5"); // Results carry into the next step
+  session.allClear();
+  CHECK(session.display() == "0");
+  press(session, "7/0=");
+  CHECK(session.display() == "Error");
+  press(session, "2+2="); // A digit after an error starts afresh
+  CHECK(session.display() == "4");
+}
+
+// Every step undoes back to what the keypad showed, and redoes forward
+void testUndo() {
+  calc::Session steps;
+  std::vector<std::string> shown;
+  for (const char key : std::string_view("7*6-2.5=")) {
+    press(steps, std::string_view(&key, 1));
+    shown.push_back(steps.display());
+  }
+  for (std::size_t i = shown.size() - 1; i-- > 0;) {
+    steps.undo();
+    CHECK(steps.display() == shown[i]);
+  }
+  for (std::size_t i = 1; i < shown.size(); ++i) {
+    steps.redo();
+    CHECK(steps.display() == shown[i]);
+  }
+  CHECK(!steps.canRedo());
+
+  // Undone back to "42 - 2.", a key pressed starts a new branch
+  steps.undo();
+  steps.undo();
+  press(steps, "1=");
+  CHECK(steps.display() == "39.9");
+  CHECK(!steps.canRedo());
+}
+
+CALC_TEST_GROUP("session", testSession);
+CALC_TEST_GROUP("undo", testUndo);
+
+} // namespace
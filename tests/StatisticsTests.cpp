@@ -0,0 +1,79 @@
+// Streaming statistics: --stats and the aggregate functions.
+#include "Check.hpp"
+#include "engine/Batch.hpp"
+#include "engine/Jit.hpp"
+#include "engine/Statistics.hpp"
+#include <cmath>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+using calc::test::compiled;
+
+// Overflow and NaN are errors to --stats, not values
+void testStatistics() {
+  calc::BatchStats stats;
+  const std::string_view input = "1e308 × 10\n1e308 × 10 - 1e308 × 10\n"
+                                 "1 ÷ 0\n2\n\n4\n";
+  CHECK(calc::summarizeLines(input, true, stats) == input.size());
+  CHECK(stats.lines == 6);
+  CHECK(stats.errors == 3);
+  CHECK(stats.values.count() == 2 && stats.values.sum() == 6.0);
+
+  const calc::Program formula = compiled("a × b");
+  calc::HotProgram hot(formula);
+  calc::BatchStats rows;
+  const std::string_view columns = "1e200, 1e200\n2, 3\n1, x\n";
+  CHECK(calc::summarizeFormulaLines(hot, columns, true, rows) ==
+        columns.size());
+  CHECK(rows.errors == 2);
+  CHECK(rows.values.count() == 1 && rows.values.sum() == 6.0);
+}
+
+// median() and percentile() select exactly whatever the argument count,
+// and agree with the Decimal backend
+void testPercentiles() {
+  // Cubes of 0 to 999, shuffled: spread unevenly, so a sketch's clusters
+  // would blur them
+  const auto cube = [](double x) { return x * x * x; };
+  std::vector<double> values(1000);
+  for (std::size_t i = 0; i < values.size(); ++i) {
+    values[i] = cube(static_cast<double>((i * 389) % values.size()));
+  }
+  CHECK(calc::aggregate(calc::Function::Median, values) ==
+        (cube(499.0) + cube(500.0)) / 2.0);
+  std::vector<double> arguments{25.0}; // Rank 249.75
+  arguments.insert(arguments.end(), values.begin(), values.end());
+  CHECK(calc::aggregate(calc::Function::Percentile, arguments) ==
+        cube(249.0) + 0.75 * (cube(250.0) - cube(249.0)));
+  arguments[0] = 100.0;
+  CHECK(calc::aggregate(calc::Function::Percentile, arguments) ==
+        cube(999.0));
+  arguments[0] = 0.0;
+  CHECK(calc::aggregate(calc::Function::Percentile, arguments) == 0.0);
+
+  // The same argument lists through the interpreter, on both backends
+  std::string source = "median(";
+  for (int i = 0; i < 300; ++i) {
+    source += std::to_string((i * 7) % 300) + (i < 299 ? ", " : ")");
+  }
+  std::string out;
+  calc::BatchStats stats;
+  calc::evaluateLine(source, out, stats);
+  calc::evaluateLine(source, out, stats, calc::NumericBackend::Decimal);
+  CHECK(out == "149.5\n149.5\n");
+
+  // --stats estimates its percentiles: close, though not always exact
+  calc::Statistics streamed;
+  for (int i = 0; i < 100000; ++i) {
+    streamed.add(static_cast<double>((i * 7919) % 100000));
+  }
+  CHECK(std::fabs(streamed.percentile(50.0) - 49999.5) < 100.0);
+}
+
+CALC_TEST_GROUP("stats", testStatistics);
+CALC_TEST_GROUP("percentiles", testPercentiles);
+
+} // namespace
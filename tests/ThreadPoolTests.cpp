@@ -0,0 +1,32 @@
+// Work-stealing thread pool: every task runs once, nested ones included.
+#include "Check.hpp"
+#include "engine/ThreadPool.hpp"
+#include <atomic>
+
+namespace {
+
+void testThreadPool() {
+  calc::ThreadPool pool(4);
+  std::atomic<int> ran{0};
+  for (int round = 0; round < 200; ++round) {
+    // Tasks submitted from outside and from workers, taken straight away
+    // or stolen, with sleeping workers woken in between
+    for (int i = 0; i < 50; ++i) {
+      pool.submit([&pool, &ran] {
+        ran.fetch_add(1);
+        pool.submit([&ran] { ran.fetch_add(1); });
+      });
+    }
+    pool.wait();
+    CHECK(ran.load() == (round + 1) * 100);
+  }
+
+  // A pool left idle does not run anything twice or lose a late task
+  pool.submit([&ran] { ran.fetch_add(1); });
+  pool.wait();
+  CHECK(ran.load() == 200 * 100 + 1);
+}
+
+CALC_TEST_GROUP("pool", testThreadPool);
+
+} // namespace
@@ -0,0 +1,82 @@
+// Unit tables: parsing units files, conversions and reloading.
+#include "Check.hpp"
+#include "engine/Units.hpp"
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace {
+
+using calc::test::temporaryPath;
+
+constexpr std::string_view kUnits = "# name dimension factor offset\n"
+                                    "m    length      1\n"
+                                    "km   length      1000\n"
+                                    "K    temperature 1\n"
+                                    "°C   temperature 1      273.15\n";
+
+void writeFile(const std::string &path, std::string_view text) {
+  std::FILE *file = std::fopen(path.c_str(), "wb");
+  std::fwrite(text.data(), 1, text.size(), file);
+  std::fclose(file);
+}
+
+void testUnits() {
+  const auto parseError = [](std::string_view text) {
+    std::string error;
+    const auto table = calc::UnitTable::parse(text, &error);
+    return table ? std::string() : error;
+  };
+  CHECK(parseError(kUnits).empty());
+  CHECK(parseError("m length 1\nto length 2\n") ==
+        "line 2: 'to' is not a unit name");
+  CHECK(parseError("m length 1\n\nm length 2\n") ==
+        "line 3: 'm' is defined twice");
+
+  const auto table = calc::UnitTable::parse(kUnits);
+  CHECK(table != nullptr);
+  if (!table) {
+    return;
+  }
+  CHECK(table->size() == 4);
+  CHECK(table->find("km") != calc::UnitTable::kNotFound);
+  CHECK(table->find("mi") == calc::UnitTable::kNotFound);
+
+  // Conversions are affine and only within one dimension
+  const std::optional<calc::Conversion> celsius = table->conversion("°C", "K");
+  CHECK(celsius && (*celsius)(20.0) == 293.15);
+  CHECK(!table->conversion("m", "K"));
+  CHECK(!table->conversion("m", "mi"));
+
+  const auto value = [&table](const char *source) {
+    const std::optional<calc::Program> program =
+        calc::compile(source, nullptr, table.get());
+    return program ? calc::evaluate(*program) : std::nullopt;
+  };
+  CHECK(value("5 km + 300 m to m") == 5300.0);
+  CHECK(value("1500 m to km") == 1.5);
+  CHECK(!value("5 km + 20 K"));
+
+  // A units file picks up edits, and keeps its table when they break it
+  const std::string path = temporaryPath("units.txt");
+  writeFile(path, "m length 1\n");
+  calc::UnitFile file(path);
+  CHECK(file.isOpen() && file.table()->size() == 1);
+  writeFile(path, "m length 1\nkm length 1000\n");
+  std::filesystem::last_write_time(
+      path, std::filesystem::last_write_time(path) + std::chrono::seconds(1));
+  CHECK(file.reload() && file.table()->size() == 2);
+  writeFile(path, "m length 1\nm length 2\n");
+  std::filesystem::last_write_time(
+      path, std::filesystem::last_write_time(path) + std::chrono::seconds(2));
+  CHECK(!file.reload() && file.table()->size() == 2 && !file.error().empty());
+  std::filesystem::remove(path);
+  CHECK(!calc::UnitFile(path).isOpen());
+}
+
+CALC_TEST_GROUP("units", testUnits);
+
+} // namespace
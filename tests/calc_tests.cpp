@@ -0,0 +1,93 @@
+// Behaviour tests for calc_engine.
+//
+//   calc_tests [GROUP...]
+//
+// Runs every group of checks, or only the groups named. A failed check
+// prints its location and expression; the exit status is 1 if any check
+// failed. ctest runs each group as a test of its own.
+#include "Check.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace calc::test {
+
+namespace {
+
+int failures = 0;
+
+struct Group {
+  std::string_view name;
+  void (*run)();
+};
+
+std::vector<Group> &groups() {
+  static std::vector<Group> registered;
+  return registered;
+}
+
+} // namespace
+
+void check(bool passed, const char *expression, const char *file, int line) {
+  if (!passed) {
+    std::fprintf(stderr, "%s:%d: check failed: %s\n", file, line, expression);
+    ++failures;
+  }
+}
+
+Registration::Registration(std::string_view name, void (*run)()) {
+  groups().push_back({name, run});
+}
+
+std::string temporaryPath(std::string_view name) {
+  const auto directory = std::filesystem::temp_directory_path();
+  return (directory / ("calc_tests_" + std::to_string(::getpid()) + "_" +
+                       std::string(name)))
+      .string();
+}
+
+Program compiled(std::string_view source) {
+  const std::optional<Program> program = compile(source);
+  CHECK(program.has_value());
+  return program.value_or(Program{});
+}
+
+} // namespace calc::test
+
+int main(int argc, char *argv[]) {
+  using calc::test::failures;
+  // Registration order depends on link order; run groups by name instead
+  std::vector<calc::test::Group> &groups = calc::test::groups();
+  std::sort(groups.begin(), groups.end(),
+            [](const auto &a, const auto &b) { return a.name < b.name; });
+  bool ran = false;
+  for (const calc::test::Group &group : groups) {
+    bool wanted = argc == 1;
+    for (int i = 1; i < argc; ++i) {
+      wanted = wanted || group.name == argv[i];
+    }
+    if (!wanted) {
+      continue;
+    }
+    const int before = failures;
+    group.run();
+    std::fprintf(stderr, "%s %.*s\n", failures == before ? "ok  " : "FAIL",
+                 static_cast<int>(group.name.size()), group.name.data());
+    ran = true;
+  }
+  if (!ran) {
+    std::fputs("calc_tests: no such group\n", stderr);
+    return 2;
+  }
+  return failures == 0 ? 0 : 1;
+}